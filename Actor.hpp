@@ -1,17 +1,11 @@
 #pragma once
-#include <vector>
+#include <cstdint>
 
 #include <vulkan/vulkan.h>
 
 struct SceneActor
 {
-	std::vector<VkBuffer> VertexBuffers = std::vector<VkBuffer>(2);
-	const std::vector<VkDeviceSize> Offsets = std::vector<VkDeviceSize>(2, 0);
-	VkDeviceMemory ActorBuffersGPUMemory;
-	size_t VerticesCount = 0;
-	enum BufferType
-	{
-		Position,
-		Normal
-	};
+	// Range of vertices within shared geometry arena.
+	uint32_t FirstVertex = 0;
+	uint32_t VerticesCount = 0;
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "BarrierRecorder.hpp"
+
+void BarrierRecorder::AddMemoryBarrier(const VkMemoryBarrier2& Barrier)
+{
+	this->MemoryBarriers.push_back(Barrier);
+}
+
+void BarrierRecorder::AddBufferBarrier(const VkBufferMemoryBarrier2& Barrier)
+{
+	this->BufferBarriers.push_back(Barrier);
+}
+
+void BarrierRecorder::AddImageBarrier(const VkImageMemoryBarrier2& Barrier)
+{
+	for (auto& PendingBarrier : this->ImageBarriers)
+	{
+		if (PendingBarrier.image == Barrier.image && PendingBarrier.oldLayout == Barrier.oldLayout && PendingBarrier.newLayout == Barrier.newLayout &&
+			PendingBarrier.subresourceRange.aspectMask == Barrier.subresourceRange.aspectMask)
+		{
+			PendingBarrier.srcStageMask |= Barrier.srcStageMask;
+			PendingBarrier.srcAccessMask |= Barrier.srcAccessMask;
+			PendingBarrier.dstStageMask |= Barrier.dstStageMask;
+			PendingBarrier.dstAccessMask |= Barrier.dstAccessMask;
+			return;
+		}
+	}
+
+	this->ImageBarriers.push_back(Barrier);
+}
+
+bool BarrierRecorder::IsEmpty() const
+{
+	return this->MemoryBarriers.empty() && this->BufferBarriers.empty() && this->ImageBarriers.empty();
+}
+
+void BarrierRecorder::Flush(VkCommandBuffer CommandBuffer, const VkDependencyFlags DependencyFlags)
+{
+	if (IsEmpty())
+		return;
+
+	VkDependencyInfo DependencyInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+		.pNext = nullptr,
+		.dependencyFlags = DependencyFlags,
+		.memoryBarrierCount = static_cast<uint32_t>(this->MemoryBarriers.size()),
+		.pMemoryBarriers = this->MemoryBarriers.data(),
+		.bufferMemoryBarrierCount = static_cast<uint32_t>(this->BufferBarriers.size()),
+		.pBufferMemoryBarriers = this->BufferBarriers.data(),
+		.imageMemoryBarrierCount = static_cast<uint32_t>(this->ImageBarriers.size()),
+		.pImageMemoryBarriers = this->ImageBarriers.data()
+	};
+
+	vkCmdPipelineBarrier2(CommandBuffer, &DependencyInfo);
+
+	this->MemoryBarriers.clear();
+	this->BufferBarriers.clear();
+	this->ImageBarriers.clear();
+}
\ No newline at end of file
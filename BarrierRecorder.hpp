@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Accumulates global, buffer and image barriers and records all of them by single vkCmdPipelineBarrier2,
+// so commands following barriers are waited for once instead of once per barrier.
+class BarrierRecorder
+{
+private:
+	std::vector<VkMemoryBarrier2> MemoryBarriers;
+	std::vector<VkBufferMemoryBarrier2> BufferBarriers;
+	std::vector<VkImageMemoryBarrier2> ImageBarriers;
+
+public:
+	BarrierRecorder() = default;
+
+	void AddMemoryBarrier(const VkMemoryBarrier2& Barrier);
+	void AddBufferBarrier(const VkBufferMemoryBarrier2& Barrier);
+
+	// Barrier of image already pending with the same layouts is merged into it.
+	void AddImageBarrier(const VkImageMemoryBarrier2& Barrier);
+
+	bool IsEmpty() const;
+
+	// Records pending barriers, if any, and clears them. Must be called right before first command depending on them.
+	// Barriers recorded inside dynamic render pass have to be by region.
+	void Flush(VkCommandBuffer CommandBuffer, const VkDependencyFlags DependencyFlags = 0);
+
+	~BarrierRecorder() = default;
+};
\ No newline at end of file
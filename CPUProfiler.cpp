@@ -0,0 +1,120 @@
+#include "CPUProfiler.hpp"
+#include "Helpers.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+CPUProfiler CPUTrace;
+
+static thread_local void* CurrentThreadBuffer = nullptr;
+
+CPUProfiler::ThreadBuffer& CPUProfiler::GetThreadBuffer()
+{
+	if (CurrentThreadBuffer)
+		return *static_cast<ThreadBuffer*>(CurrentThreadBuffer);
+
+	std::lock_guard<std::mutex> Lock(this->ThreadBuffersMutex);
+
+	auto Buffer = std::make_unique<ThreadBuffer>();
+	Buffer->ThreadIndex = static_cast<uint32_t>(this->ThreadBuffers.size());
+	Buffer->ThreadName = Buffer->ThreadIndex == 0 ? "Main" : "Thread " + std::to_string(Buffer->ThreadIndex);
+
+	CurrentThreadBuffer = Buffer.get();
+	this->ThreadBuffers.push_back(std::move(Buffer));
+
+	return *this->ThreadBuffers.back();
+}
+
+void CPUProfiler::Enable()
+{
+	this->StartTime = std::chrono::steady_clock::now();
+	this->IsEnabled.store(true, std::memory_order_relaxed);
+
+	// Thread enabling profiler becomes first thread of trace.
+	GetThreadBuffer();
+}
+
+bool CPUProfiler::IsRecording() const
+{
+	return this->IsEnabled.load(std::memory_order_relaxed);
+}
+
+int64_t CPUProfiler::GetTimeInUs() const
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->StartTime).count();
+}
+
+void CPUProfiler::RecordZone(const char* Name, const int64_t BeginInUs, const int64_t EndInUs)
+{
+	// Zone may close after trace has been written already.
+	if (!IsRecording())
+		return;
+
+	auto& Buffer = GetThreadBuffer();
+
+	// Only owning thread writes into buffer, so count just publishes written event to trace writer.
+	const uint64_t EventIndex = Buffer.WrittenEventsCount.load(std::memory_order_relaxed);
+	Buffer.Events[EventIndex % ThreadBufferCapacity] = { Name, BeginInUs, EndInUs };
+	Buffer.WrittenEventsCount.store(EventIndex + 1, std::memory_order_release);
+}
+
+void CPUProfiler::NameThread(const std::string& Name)
+{
+	if (!IsRecording())
+		return;
+
+	GetThreadBuffer().ThreadName = Name;
+}
+
+void CPUProfiler::WriteTrace(const std::string& FilePath)
+{
+	if (!IsRecording())
+		return;
+
+	// Trace is written only once, either at end of main or from exit handler.
+	this->IsEnabled.store(false, std::memory_order_relaxed);
+
+	std::ofstream File(FilePath);
+
+	File << "{\n";
+	File << "\t\"displayTimeUnit\": \"ms\",\n";
+	File << "\t\"traceEvents\": [";
+
+	bool IsFirst = true;
+	size_t EventsCount = 0;
+
+	std::lock_guard<std::mutex> Lock(this->ThreadBuffersMutex);
+	for (const auto& Buffer : this->ThreadBuffers)
+	{
+		File << (IsFirst ? "\n" : ",\n") << "\t\t{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << Buffer->ThreadIndex << ", \"args\": { \"name\": \"" << EscapeJSON(Buffer->ThreadName) << "\" } }";
+		IsFirst = false;
+
+		// When buffer wrapped around, only its last events are still stored.
+		const uint64_t WrittenEventsCount = Buffer->WrittenEventsCount.load(std::memory_order_acquire);
+		const uint64_t FirstEvent = WrittenEventsCount > ThreadBufferCapacity ? WrittenEventsCount - ThreadBufferCapacity : 0;
+
+		for (uint64_t EventIndex = FirstEvent; EventIndex < WrittenEventsCount; EventIndex++)
+		{
+			const auto& Event = Buffer->Events[EventIndex % ThreadBufferCapacity];
+
+			File << ",\n\t\t{ \"name\": \"" << Event.Name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << Buffer->ThreadIndex
+				<< ", \"ts\": " << Event.BeginInUs << ", \"dur\": " << (std::max)(Event.EndInUs - Event.BeginInUs, int64_t(0)) << " }";
+		}
+		EventsCount += WrittenEventsCount - FirstEvent;
+	}
+
+	File << "\n\t]\n";
+	File << "}\n";
+
+	std::cout << "CPU trace of " << EventsCount << " zones written into " << FilePath << "." << std::endl;
+}
+
+void CPUProfiler::WriteTraceOnExit(const std::string& FilePath)
+{
+	this->ExitTracePath = FilePath;
+
+	// Registered after construction of CPUTrace, so handler runs before its destructor.
+	std::atexit([]() { CPUTrace.WriteTrace(CPUTrace.ExitTracePath); });
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define TUTORIAL_VK_CPU_PROFILER // Comment out to compile profiler zones out entirely.
+
+// Scoped CPU zones written as Chrome/Perfetto trace. Every thread writes its zones into its own ring buffer,
+// registered once on its first zone, so recording never takes a lock. Oldest zones are overwritten when buffer fills.
+class CPUProfiler
+{
+private:
+	struct ZoneEvent
+	{
+		const char* Name; // Must outlive profiler, zones are named with string literals.
+		int64_t BeginInUs;
+		int64_t EndInUs;
+	};
+
+	static constexpr uint32_t ThreadBufferCapacity = 16384;
+
+	struct ThreadBuffer
+	{
+		uint32_t ThreadIndex;
+		std::string ThreadName;
+		std::array<ZoneEvent, ThreadBufferCapacity> Events;
+		std::atomic<uint64_t> WrittenEventsCount = 0;
+	};
+
+	std::atomic<bool> IsEnabled = false;
+	std::string ExitTracePath;
+	std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+
+	std::mutex ThreadBuffersMutex; // Guards only registration of thread buffers.
+	std::vector<std::unique_ptr<ThreadBuffer>> ThreadBuffers;
+
+	ThreadBuffer& GetThreadBuffer();
+
+public:
+	CPUProfiler() = default;
+
+	// Zones are dropped until profiler is enabled.
+	void Enable();
+	bool IsRecording() const;
+
+	int64_t GetTimeInUs() const;
+
+	void RecordZone(const char* Name, const int64_t BeginInUs, const int64_t EndInUs);
+
+	// Name shown for calling thread in trace viewer.
+	void NameThread(const std::string& Name);
+
+	// Other threads must not record zones while trace is written. Recording stops once trace is written.
+	void WriteTrace(const std::string& FilePath);
+
+	// Writes trace also when app leaves through exit(), e.g. on error. Zones still open or being recorded
+	// by other threads at that moment are missing from trace.
+	void WriteTraceOnExit(const std::string& FilePath);
+
+	~CPUProfiler() = default;
+};
+
+extern CPUProfiler CPUTrace;
+
+// Records zone from its construction until end of scope.
+class CPUProfilerZone
+{
+private:
+	const char* Name = nullptr;
+	int64_t BeginInUs = -1;
+
+public:
+	CPUProfilerZone(const char* Name)
+	{
+		if (!CPUTrace.IsRecording())
+			return;
+
+		this->Name = Name;
+		this->BeginInUs = CPUTrace.GetTimeInUs();
+	}
+
+	~CPUProfilerZone()
+	{
+		if (this->BeginInUs < 0)
+			return;
+
+		CPUTrace.RecordZone(this->Name, this->BeginInUs, CPUTrace.GetTimeInUs());
+	}
+};
+
+#ifdef TUTORIAL_VK_CPU_PROFILER
+	#define TUTORIAL_VK_PROFILE_ZONE_VARIABLE(Line) CPUProfilerZone_##Line
+	#define TUTORIAL_VK_PROFILE_ZONE_EXPAND(Line) TUTORIAL_VK_PROFILE_ZONE_VARIABLE(Line)
+	#define TUTORIAL_VK_PROFILE_ZONE(Name) CPUProfilerZone TUTORIAL_VK_PROFILE_ZONE_EXPAND(__LINE__)(Name)
+	#define TUTORIAL_VK_PROFILE_THREAD(Name) CPUTrace.NameThread(Name)
+#else
+	#define TUTORIAL_VK_PROFILE_ZONE(Name)
+	#define TUTORIAL_VK_PROFILE_THREAD(Name)
+#endif
\ No newline at end of file
@@ -1,141 +1,109 @@
 #include "DeferredPass.hpp"
 #include "Helpers.hpp"
 
+#include <cstddef>
+
 DeferredPass::DeferredPass(VkDevice Device, const uint32_t GraphicsQueueIndex, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties, DeferredAdditionalRequiredInfo& AdditionalResources) : RenderPass(Device)
 {
-	// Setup result image.
-	{
-		// Setup image.
-		{
-			VkImageCreateInfo CreationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-				.pNext = nullptr,
-				.flags = 0,
-				.imageType = VK_IMAGE_TYPE_2D,
-				.format = VkFormat::VK_FORMAT_R16G16B16A16_UNORM,
-				.extent =
-				{
-					.width = 1600,
-					.height = 900,
-					.depth = 1
-				},
-				.mipLevels = 1,
-				.arrayLayers = 1,
-				.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
-				.tiling = VkImageTiling::VK_IMAGE_TILING_OPTIMAL,
-				.usage = VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
-				.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
-				.queueFamilyIndexCount = 1,
-				.pQueueFamilyIndices = &GraphicsQueueIndex,
-				.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
-			};
+	TUTORIAL_VK_PROFILE_ZONE("DeferredPass::DeferredPass");
 
-			vkCreateImage(Device, &CreationInfo, nullptr, &this->ResultImage);
-
-			this->SharedResources.ResultImage = &this->ResultImage;
-		}
-		// Allocate memory.
-		{
-			VkMemoryRequirements MemoryRequirements;
-			vkGetImageMemoryRequirements(Device, this->ResultImage, &MemoryRequirements);
+	this->GraphicsQueueIndex = GraphicsQueueIndex;
+	this->AdditionalResources = AdditionalResources;
+	this->LightSpaceUniformOffset = AdditionalResources.LightSpaceUniformOffset;
 
-			const auto MemorySegmentsInfo = ComputeMemorySegments(MemoryRequirements);
-			
-			VkMemoryAllocateInfo AllocationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-				.pNext = nullptr,
-				.allocationSize = MemorySegmentsInfo.SegmentSize * MemorySegmentsInfo.SegmentsCount,
-				.memoryTypeIndex = QueryMemoryTypeIndex(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryRequirements.memoryTypeBits, DeviceMemoryProperties)
-			};
-			
-			vkAllocateMemory(Device, &AllocationInfo, nullptr, &this->ResultImageMemory);
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	// Dynamic render pass is described while recording, only output locations of deferred shading are remapped by extension command.
+	{
+		this->CmdSetRenderingAttachmentLocations = reinterpret_cast<PFN_vkCmdSetRenderingAttachmentLocationsKHR>(vkGetDeviceProcAddr(Device, "vkCmdSetRenderingAttachmentLocationsKHR"));
 
-			vkBindImageMemory(Device, this->ResultImage, this->ResultImageMemory, 0);
-		}
-		// Setup image view.
+		this->SharedResources.SceneRenderPass =
 		{
-			VkImageSubresourceRange RangeInfo
-			{
-				.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT,
-				.baseMipLevel = 0,
-				.levelCount = 1,
-				.baseArrayLayer = 0,
-				.layerCount = 1
-			};
-
-			VkImageViewCreateInfo CreationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-				.pNext = nullptr,
-				.flags = 0,
-				.image = this->ResultImage,
-				.viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D,
-				.format = VkFormat::VK_FORMAT_R16G16B16A16_UNORM,
-				.components =
-				{
-					.r = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-					.g = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-					.b = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-					.a = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY
-				},
-				.subresourceRange = RangeInfo
-			};
-
-			vkCreateImageView(Device, &CreationInfo, nullptr, &this->ResultImageView);
-		}
+#ifdef TUTORIAL_VK_DIRECT_TO_SWAPCHAIN
+			.ResultFormat = AdditionalResources.SwapchainFormat,
+#else
+			.ResultFormat = VkFormat::VK_FORMAT_R16G16B16A16_UNORM,
+#endif
+			.ResultViews = &this->SceneResultViews
+		};
 	}
-
-	// Setup render pass.
+#else
+	// Setup scene render pass. G-buffer is generated in first subpass and read by deferred shading in second one,
+	// so tile-based devices keep it on-chip and never store it into memory.
 	{
 		std::vector<VkAttachmentDescription> AttachmentsInfos;
 		{
+			// Every pixel is written by full screen quad, so previous content is never loaded.
 			VkAttachmentDescription ResultAttachmentInfo
 			{
 				.flags = 0,
+#ifdef TUTORIAL_VK_DIRECT_TO_SWAPCHAIN
+				.format = AdditionalResources.SwapchainFormat,
+#else
 				.format = VkFormat::VK_FORMAT_R16G16B16A16_UNORM,
+#endif
 				.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
 				.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 				.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_STORE,
 				.stencilLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 				.stencilStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE,
-				.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED,
+				.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
 				.finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
 			};
 
-			VkAttachmentDescription ScenePositionAttachmentInfo
+			// G-buffer is cleared and dropped once scene render pass ends.
+			VkAttachmentDescription GBufferAttachmentInfo
 			{
 				.flags = 0,
 				.format = VkFormat::VK_FORMAT_R32G32B32A32_SFLOAT,
 				.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
-				.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_LOAD,
-				.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_NONE,
+				.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR,
+				.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE,
 				.stencilLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 				.stencilStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE,
-				.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-				.finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL
+				.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED,
+				.finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
 			};
 
-			VkAttachmentDescription SceneNormalAttachmentInfo
+			VkAttachmentDescription DepthAttachmentInfo
 			{
 				.flags = 0,
-				.format = VkFormat::VK_FORMAT_R32G32B32A32_SFLOAT,
+				.format = VkFormat::VK_FORMAT_D32_SFLOAT,
 				.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
-				.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_LOAD,
-				.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_NONE,
+				.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR,
+				.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE,
 				.stencilLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 				.stencilStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE,
-				.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-				.finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL
+				.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED,
+				.finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL
 			};
+
 			AttachmentsInfos =
 			{
 				ResultAttachmentInfo,
-				ScenePositionAttachmentInfo,
-				SceneNormalAttachmentInfo
+				GBufferAttachmentInfo,
+				GBufferAttachmentInfo,
+				DepthAttachmentInfo
 			};
 		}
+
+		std::vector<VkAttachmentReference> GBufferAttachments
+		{
+			{
+				.attachment = 1,
+				.layout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+			},
+			{
+				.attachment = 2,
+				.layout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+			}
+		};
+
+		VkAttachmentReference DepthAttachmentReferenceInfo
+		{
+			.attachment = 3,
+			.layout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL
+		};
+
 		std::vector<VkAttachmentReference> InputAttachments;
 		{
 			VkAttachmentReference ScenePositionAttachmentReferenceInfo
@@ -161,7 +129,20 @@ DeferredPass::DeferredPass(VkDevice Device, const uint32_t GraphicsQueueIndex, c
 			.layout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
 		};
 
-		VkSubpassDescription SubpassInfo
+		VkSubpassDescription GBufferSubpassInfo
+		{
+			.flags = 0,
+			.pipelineBindPoint = VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS,
+			.inputAttachmentCount = 0,
+			.pInputAttachments = nullptr,
+			.colorAttachmentCount = static_cast<uint32_t>(GBufferAttachments.size()),
+			.pColorAttachments = GBufferAttachments.data(),
+			.pResolveAttachments = nullptr,
+			.pDepthStencilAttachment = &DepthAttachmentReferenceInfo,
+			.preserveAttachmentCount = 0,
+			.pPreserveAttachments = nullptr
+		};
+		VkSubpassDescription DeferredShadingSubpassInfo
 		{
 			.flags = 0,
 			.pipelineBindPoint = VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -175,46 +156,54 @@ DeferredPass::DeferredPass(VkDevice Device, const uint32_t GraphicsQueueIndex, c
 			.pPreserveAttachments = nullptr
 		};
 
+		VkSubpassDescription SubpassesInfos[] = { GBufferSubpassInfo, DeferredShadingSubpassInfo };
+
+		// Result image and shadow map are synchronized by render graph. G-buffer and depth buffer only have to wait for previous frame,
+		// and every pixel of G-buffer is read by deferred shading only at the same pixel, so dependency between subpasses is by region.
+		std::vector<VkSubpassDependency> Dependencies
+		{
+			{
+				.srcSubpass = VK_SUBPASS_EXTERNAL,
+				.dstSubpass = 0,
+				.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+				.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				.dependencyFlags = 0
+			},
+			{
+				.srcSubpass = 0,
+				.dstSubpass = 1,
+				.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				.dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+				.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT
+			}
+		};
+
 		VkRenderPassCreateInfo RenderPassCreationInfo
 		{
 			.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
 			.pNext = nullptr,
 			.flags = 0,
-			.attachmentCount = 3,
+			.attachmentCount = static_cast<uint32_t>(AttachmentsInfos.size()),
 			.pAttachments = AttachmentsInfos.data(),
-			.subpassCount = 1,
-			.pSubpasses = &SubpassInfo,
-			.dependencyCount = 0,
-			.pDependencies = nullptr
+			.subpassCount = 2,
+			.pSubpasses = SubpassesInfos,
+			.dependencyCount = static_cast<uint32_t>(Dependencies.size()),
+			.pDependencies = Dependencies.data()
 		};
 
-		vkCreateRenderPass(Device, &RenderPassCreationInfo, nullptr, &this->DeferredRenderPass);
-	}
-
-	// Setup framebuffer.
-	{
-		std::vector<VkImageView> Attachments
-		{
-			this->ResultImageView,
-			*AdditionalResources.GBufferPositionView,
-			*AdditionalResources.GBufferNormalView
-		};
+		vkCreateRenderPass(Device, &RenderPassCreationInfo, nullptr, &this->SceneRenderPass);
 
-		VkFramebufferCreateInfo CreationInfo
+		this->SharedResources.SceneRenderPass =
 		{
-			.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-			.pNext = nullptr,
-			.flags = 0,
-			.renderPass = this->DeferredRenderPass,
-			.attachmentCount = 3,
-			.pAttachments = Attachments.data(),
-			.width = 1600,
-			.height = 900,
-			.layers = 1
+			.RenderPass = &this->SceneRenderPass,
+			.Framebuffers = &this->SceneFramebuffers
 		};
-
-		vkCreateFramebuffer(Device, &CreationInfo, nullptr, &this->DeferredFramebuffer);
 	}
+#endif
 
 	// Setup sampler.
 	{
@@ -252,7 +241,7 @@ DeferredPass::DeferredPass(VkDevice Device, const uint32_t GraphicsQueueIndex, c
 				VkDescriptorSetLayoutBinding LightSpaceUniformBufferBindingInfo
 				{
 					.binding = 0,
-					.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+					.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 					.descriptorCount = 1,
 					.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
 					.pImmutableSamplers = nullptr
@@ -329,7 +318,7 @@ DeferredPass::DeferredPass(VkDevice Device, const uint32_t GraphicsQueueIndex, c
 			{
 				VkDescriptorPoolSize LightSpaceUniformBufferPool
 				{
-					.type = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+					.type = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 					.descriptorCount = 1
 				};
 
@@ -384,34 +373,156 @@ DeferredPass::DeferredPass(VkDevice Device, const uint32_t GraphicsQueueIndex, c
 
 		vkAllocateDescriptorSets(Device, &AllocateInfo, this->DeferredDescriptorSets.data());
 	}
+}
+
+void DeferredPass::DeclareRenderTargets(RenderTargetHeap& Heap)
+{
+#ifdef TUTORIAL_VK_DIRECT_TO_SWAPCHAIN
+	// Swapchain images are render targets, there is nothing to declare.
+	this->SharedResources.ResultImage = nullptr;
+#else
+	VkImageCreateInfo CreationInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.imageType = VK_IMAGE_TYPE_2D,
+		.format = VkFormat::VK_FORMAT_R16G16B16A16_UNORM,
+		.extent =
+		{
+			.width = this->Extent.width,
+			.height = this->Extent.height,
+			.depth = 1
+		},
+		.mipLevels = 1,
+		.arrayLayers = 1,
+		.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
+		.tiling = VkImageTiling::VK_IMAGE_TILING_OPTIMAL,
+		.usage = VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
+		.queueFamilyIndexCount = 1,
+		.pQueueFamilyIndices = &this->GraphicsQueueIndex,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+	};
+
+	// Result is written here and copied into swapchain during presentation. It lives during whole scene render pass, as its attachments can't share memory.
+	this->ResultImage = Heap.DeclareImage(CreationInfo, "DeferredPass", "Result image", FrameStage::SceneRenderingStage, FrameStage::PresentationStage,
+		VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT,
+		VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_TRANSFER_READ_BIT);
+
+	this->SharedResources.ResultImage = &this->ResultImage;
+#endif
+}
+
+void DeferredPass::SetupRenderTargets()
+{
+	TUTORIAL_VK_PROFILE_ZONE("DeferredPass::SetupRenderTargets");
+
+#ifndef TUTORIAL_VK_DIRECT_TO_SWAPCHAIN
+	// Setup result image view.
+	{
+		VkImageSubresourceRange RangeInfo
+		{
+			.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1
+		};
+
+		VkImageViewCreateInfo CreationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.image = this->ResultImage,
+			.viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D,
+			.format = VkFormat::VK_FORMAT_R16G16B16A16_UNORM,
+			.components =
+			{
+				.r = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.g = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.b = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.a = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY
+			},
+			.subresourceRange = RangeInfo
+		};
+
+		vkCreateImageView(Device, &CreationInfo, nullptr, &this->ResultImageView);
+	}
+
+	const std::vector<VkImageView> ResultViews{ this->ResultImageView };
+#else
+	const std::vector<VkImageView>& ResultViews = *this->AdditionalResources.SwapchainViews;
+#endif
+
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	// Result views are attached while recording.
+	this->SceneResultViews = ResultViews;
+#else
+	// Setup framebuffers.
+	for (const auto ResultView : ResultViews)
+	{
+		std::vector<VkImageView> Attachments
+		{
+			ResultView,
+			*this->AdditionalResources.GBufferPositionView,
+			*this->AdditionalResources.GBufferNormalView,
+			*this->AdditionalResources.GBufferDepthView
+		};
+
+		VkFramebufferCreateInfo CreationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.renderPass = this->SceneRenderPass,
+			.attachmentCount = static_cast<uint32_t>(Attachments.size()),
+			.pAttachments = Attachments.data(),
+			.width = this->Extent.width,
+			.height = this->Extent.height,
+			.layers = 1
+		};
+
+		VkFramebuffer Framebuffer{};
+		vkCreateFramebuffer(Device, &CreationInfo, nullptr, &Framebuffer);
+		this->SceneFramebuffers.push_back(Framebuffer);
+	}
+#endif
+
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	const VkImageLayout GBufferLayout = VkImageLayout::VK_IMAGE_LAYOUT_RENDERING_LOCAL_READ_KHR;
+#else
+	const VkImageLayout GBufferLayout = VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+#endif
 
 	// Update descriptors.
 	{
 		VkDescriptorBufferInfo LightSpaceUniformBufferInfo
 		{
-			.buffer = *AdditionalResources.LightSpaceUniformBuffer,
+			.buffer = *this->AdditionalResources.LightSpaceUniformBuffer,
 			.offset = 0,
-			.range = VK_WHOLE_SIZE
+			.range = this->AdditionalResources.LightSpaceUniformRange
 		};
 
 		VkDescriptorImageInfo GBufferPositionImageInfo
 		{
 			.sampler = VK_NULL_HANDLE,
-			.imageView = *AdditionalResources.GBufferPositionView,
-			.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+			.imageView = *this->AdditionalResources.GBufferPositionView,
+			.imageLayout = GBufferLayout
 		};
 
 		VkDescriptorImageInfo GBufferNormalImageInfo
 		{
 			.sampler = VK_NULL_HANDLE,
-			.imageView = *AdditionalResources.GBufferNormalView,
-			.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+			.imageView = *this->AdditionalResources.GBufferNormalView,
+			.imageLayout = GBufferLayout
 		};
 
 		VkDescriptorImageInfo VarianceShadowMapImageInfo
 		{
 			.sampler = VK_NULL_HANDLE,
-			.imageView = *AdditionalResources.VarianceShadowMapView,
+			.imageView = *this->AdditionalResources.VarianceShadowMapView,
 			.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
 		};
 
@@ -425,7 +536,7 @@ DeferredPass::DeferredPass(VkDevice Device, const uint32_t GraphicsQueueIndex, c
 				.dstBinding = 0,
 				.dstArrayElement = 0,
 				.descriptorCount = 1,
-				.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				.pImageInfo = nullptr,
 				.pBufferInfo = &LightSpaceUniformBufferInfo,
 				.pTexelBufferView = nullptr
@@ -486,29 +597,82 @@ DeferredPass::DeferredPass(VkDevice Device, const uint32_t GraphicsQueueIndex, c
 	}
 }
 
+void DeferredPass::DeclareGraphUsage(RenderGraph& Graph, const uint32_t GraphPass)
+{
+	const RenderGraphUsage SampledImageUsage
+	{
+		.StageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+		.AccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+		.Layout = VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	};
+	const RenderGraphUsage ResultAttachmentUsage
+	{
+		.StageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+		.AccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+		.Layout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+	};
+
+	// G-buffer is passed between subpasses of scene render pass.
+	Graph.Read(GraphPass, Graph.FindResource("VarianceShadowMap"), SampledImageUsage);
+
+	// Every pixel is written by full screen quad.
+#ifdef TUTORIAL_VK_DIRECT_TO_SWAPCHAIN
+	Graph.Write(GraphPass, Graph.FindResource("Swapchain"), ResultAttachmentUsage, true);
+#else
+	Graph.Write(GraphPass, Graph.AddImage("DeferredResult", this->ResultImage, VK_IMAGE_ASPECT_COLOR_BIT), ResultAttachmentUsage, true);
+#endif
+}
+
+void DeferredPass::UpdateGraphImages(RenderGraph& Graph)
+{
+#ifndef TUTORIAL_VK_DIRECT_TO_SWAPCHAIN
+	Graph.SetImage(Graph.FindResource("DeferredResult"), this->ResultImage);
+#endif
+}
+
+void DeferredPass::FreeRenderTargets()
+{
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	this->SceneResultViews.clear();
+#else
+	for (const auto Framebuffer : this->SceneFramebuffers)
+	{
+		vkDestroyFramebuffer(Device, Framebuffer, nullptr);
+	}
+	this->SceneFramebuffers.clear();
+#endif
+
+	vkDestroyImageView(Device, this->ResultImageView, nullptr);
+	this->ResultImageView = VK_NULL_HANDLE;
+}
+
 void DeferredPass::FreeGPUResources()
 {
 	auto Device = this->Device;
 
-	vkDestroyShaderModule(Device, this->DeferredVertexShaderModule, nullptr);
-	vkDestroyShaderModule(Device, this->DeferredFragmentShaderModule, nullptr);
-	vkDestroyImage(Device, this->ResultImage, nullptr);
-	vkFreeMemory(Device, this->ResultImageMemory, nullptr);
-	vkDestroyImageView(Device, this->ResultImageView, nullptr);
-	vkDestroyRenderPass(Device, this->DeferredRenderPass, nullptr);
-	vkDestroyFramebuffer(Device, this->DeferredFramebuffer, nullptr);
+	FreeRenderTargets();
+#ifndef TUTORIAL_VK_DYNAMIC_RENDERING
+	vkDestroyRenderPass(Device, this->SceneRenderPass, nullptr);
+#endif
 
 	vkDestroyDescriptorPool(Device, this->DeferredDescriptorPool, nullptr);
 	vkDestroyDescriptorSetLayout(Device, this->DeferredDescriptorSetLayout, nullptr);
 	vkDestroyPipelineLayout(Device, this->PipelineLayout, nullptr);
-	vkDestroyPipeline(Device, this->Pipeline, nullptr);
+	for (const auto& [Variant, Pipeline] : this->VariantPipelines)
+	{
+		vkDestroyPipeline(Device, Pipeline, nullptr);
+	}
+	this->VariantPipelines.clear();
+	this->Pipeline = VK_NULL_HANDLE;
 
 	vkDestroySampler(Device, this->VarianceShadowMapSampler, nullptr);
 }
-void DeferredPass::SetupShaders()
+void DeferredPass::SetupShaders(ShaderArchive& Shaders)
 {
-	this->DeferredVertexShaderModule = CreateShaderModule(Device, "shaders/deferred_shading_pass_vert.spv");
-	this->DeferredFragmentShaderModule = CreateShaderModule(Device, "shaders/deferred_shading_pass_frag.spv");
+	TUTORIAL_VK_PROFILE_ZONE("DeferredPass::SetupShaders");
+
+	this->DeferredVertexShaderModule = Shaders.GetModule("deferred_shading_pass_vert.spv");
+	this->DeferredFragmentShaderModule = Shaders.GetModule("deferred_shading_pass_frag.spv");
 
 	ShaderStages =
 	{
@@ -535,8 +699,67 @@ void DeferredPass::SetupShaders()
 	};
 }
 
-void DeferredPass::SetupPipeline()
+void DeferredPass::SetupPipeline(VkPipelineCache PipelineCache)
+{
+	TUTORIAL_VK_PROFILE_ZONE("DeferredPass::SetupPipeline");
+
+	// Cache is kept for variants created later, while rendering.
+	this->PipelineCache = PipelineCache;
+
+	this->Pipeline = CreatePipeline(this->Variant);
+	this->VariantPipelines[this->Variant] = this->Pipeline;
+}
+
+void DeferredPass::SetVariant(const DeferredShadingVariant& Variant)
 {
+	if (Variant == this->Variant)
+		return;
+
+	auto& VariantPipeline = this->VariantPipelines[Variant];
+	if (VariantPipeline == VK_NULL_HANDLE)
+	{
+		VariantPipeline = CreatePipeline(Variant);
+	}
+
+	this->Variant = Variant;
+	this->Pipeline = VariantPipeline;
+
+	this->ContentVersion++;
+}
+
+const DeferredShadingVariant& DeferredPass::GetVariant() const
+{
+	return this->Variant;
+}
+
+VkPipeline DeferredPass::CreatePipeline(const DeferredShadingVariant& Variant)
+{
+	TUTORIAL_VK_PROFILE_ZONE("DeferredPass::CreatePipeline");
+
+	// Setup specialization constants of fragment shader.
+	const VkSpecializationMapEntry SpecializationEntries[] =
+	{
+		{ .constantID = 0, .offset = offsetof(DeferredShadingVariant, IsShadowEnabled), .size = sizeof(VkBool32) },
+		{ .constantID = 1, .offset = offsetof(DeferredShadingVariant, ShadowFiltering), .size = sizeof(uint32_t) },
+		{ .constantID = 2, .offset = offsetof(DeferredShadingVariant, Tonemapping), .size = sizeof(uint32_t) },
+		{ .constantID = 3, .offset = offsetof(DeferredShadingVariant, Exposure), .size = sizeof(float) },
+		{ .constantID = 4, .offset = offsetof(DeferredShadingVariant, Gamma), .size = sizeof(float) },
+		{ .constantID = 5, .offset = offsetof(DeferredShadingVariant, MinVariance), .size = sizeof(float) },
+		{ .constantID = 6, .offset = offsetof(DeferredShadingVariant, LightBleedingReduction), .size = sizeof(float) },
+		{ .constantID = 7, .offset = offsetof(DeferredShadingVariant, HardShadowBias), .size = sizeof(float) }
+	};
+
+	VkSpecializationInfo SpecializationInfo
+	{
+		.mapEntryCount = static_cast<uint32_t>(std::size(SpecializationEntries)),
+		.pMapEntries = SpecializationEntries,
+		.dataSize = sizeof(DeferredShadingVariant),
+		.pData = &Variant
+	};
+
+	std::vector<VkPipelineShaderStageCreateInfo> VariantShaderStages = ShaderStages;
+	VariantShaderStages[1].pSpecializationInfo = &SpecializationInfo;
+
 	VkPipelineVertexInputStateCreateInfo VertexInputInfo
 	{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
@@ -557,39 +780,26 @@ void DeferredPass::SetupPipeline()
 		.primitiveRestartEnable = false
 	};
 
-	VkViewport Viewport
-	{
-		.x = 0,
-		.y = 0,
-		.width = 1600,
-		.height = 900,
-		.minDepth = 0.0f,
-		.maxDepth = 1.0f
-	};
-
-	VkRect2D Scissor
-	{
-		.offset
-		{
-			.x = 0,
-			.y = 0
-		},
-		.extent
-		{
-			.width = 1600,
-			.height = 900
-		}
-	};
-
+	// Viewport and scissor are set while recording, so every variant stays valid across resizing.
 	VkPipelineViewportStateCreateInfo ViewportState
 	{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
 		.pNext = nullptr,
 		.flags = 0,
 		.viewportCount = 1,
-		.pViewports = &Viewport,
+		.pViewports = nullptr,
 		.scissorCount = 1,
-		.pScissors = &Scissor
+		.pScissors = nullptr
+	};
+
+	const VkDynamicState DynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo DynamicStateInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.dynamicStateCount = 2,
+		.pDynamicStates = DynamicStates
 	};
 
 	VkPipelineMultisampleStateCreateInfo SamplesInfo
@@ -638,6 +848,34 @@ void DeferredPass::SetupPipeline()
 		}
 	};
 
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	// G-buffer attachments precede result attachment within dynamic render pass, they are never written here.
+	VkPipelineColorBlendAttachmentState GBufferBlendState = PipelineBlendStates.front();
+	GBufferBlendState.colorWriteMask = 0;
+	PipelineBlendStates.insert(PipelineBlendStates.begin(), 2, GBufferBlendState);
+
+	const VkFormat ColorAttachmentsFormats[] = { VkFormat::VK_FORMAT_R32G32B32A32_SFLOAT, VkFormat::VK_FORMAT_R32G32B32A32_SFLOAT, this->SharedResources.SceneRenderPass.ResultFormat };
+
+	VkRenderingAttachmentLocationInfoKHR AttachmentsLocationsInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_LOCATION_INFO_KHR,
+		.pNext = nullptr,
+		.colorAttachmentCount = 3,
+		.pColorAttachmentLocations = this->ColorAttachmentsLocations
+	};
+
+	VkPipelineRenderingCreateInfo RenderingInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+		.pNext = &AttachmentsLocationsInfo,
+		.viewMask = 0,
+		.colorAttachmentCount = 3,
+		.pColorAttachmentFormats = ColorAttachmentsFormats,
+		.depthAttachmentFormat = VkFormat::VK_FORMAT_D32_SFLOAT,
+		.stencilAttachmentFormat = VkFormat::VK_FORMAT_UNDEFINED
+	};
+#endif
+
 	VkPipelineColorBlendStateCreateInfo ColorBlendInfo
 	{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
@@ -645,72 +883,91 @@ void DeferredPass::SetupPipeline()
 		.flags = 0,
 		.logicOpEnable = false,
 		.logicOp = VkLogicOp::VK_LOGIC_OP_AND,
-		.attachmentCount = 1,
+		.attachmentCount = static_cast<uint32_t>(PipelineBlendStates.size()),
 		.pAttachments = PipelineBlendStates.data(),
 		.blendConstants = { 0.0f, 0.0f, 0.0f, 0.0f }
 	};
 
+	// Depth buffer is shared with G-buffer generation, but shading neither tests nor writes it.
+	VkPipelineDepthStencilStateCreateInfo DepthStencilState
+	{
+		.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.depthTestEnable = false,
+		.depthWriteEnable = false,
+		.depthCompareOp = VkCompareOp::VK_COMPARE_OP_ALWAYS,
+		.depthBoundsTestEnable = false,
+		.stencilTestEnable = false,
+		.front = VkStencilOp::VK_STENCIL_OP_KEEP,
+		.back = VkStencilOp::VK_STENCIL_OP_KEEP,
+		.minDepthBounds = 0.0f,
+		.maxDepthBounds = 1.0f
+	};
+
 	VkGraphicsPipelineCreateInfo CreationInfo
 	{
 		.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+		.pNext = &RenderingInfo,
+#else
 		.pNext = nullptr,
+#endif
 		.flags = 0,
 		.stageCount = 2,
-		.pStages = ShaderStages.data(),
+		.pStages = VariantShaderStages.data(),
 		.pVertexInputState = &VertexInputInfo,
 		.pInputAssemblyState = &InputAssemblyInfo,
 		.pTessellationState = nullptr,
 		.pViewportState = &ViewportState,
 		.pRasterizationState = &RasterizerInfo,
 		.pMultisampleState = &SamplesInfo,
-		.pDepthStencilState = nullptr,
+		.pDepthStencilState = &DepthStencilState,
 		.pColorBlendState = &ColorBlendInfo,
-		.pDynamicState = nullptr,
+		.pDynamicState = &DynamicStateInfo,
 		.layout = this->PipelineLayout,
-		.renderPass = this->DeferredRenderPass,
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+		.renderPass = VK_NULL_HANDLE,
 		.subpass = 0,
+#else
+		.renderPass = this->SceneRenderPass,
+		.subpass = 1,
+#endif
 		.basePipelineHandle = nullptr,
 		.basePipelineIndex = -1
 	};
 
-	vkCreateGraphicsPipelines(Device, nullptr, 1, &CreationInfo, nullptr, &this->Pipeline);
+	VkPipeline VariantPipeline;
+	vkCreateGraphicsPipelines(Device, this->PipelineCache, 1, &CreationInfo, nullptr, &VariantPipeline);
+
+	return VariantPipeline;
 }
 
 void DeferredPass::RecordCommandBuffer(VkCommandBuffer CommandBuffer)
 {
-	VkClearValue ClearValue
-	{
-		.color =
-		{
-			.float32 = { 0.0f, 0.0f, 0.0f, 1.0f }
-		}
-	};
+	TUTORIAL_VK_PROFILE_ZONE("DeferredPass::RecordCommandBuffer");
 
-	VkRenderPassBeginInfo Info
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	VkRenderingAttachmentLocationInfoKHR AttachmentsLocationsInfo
 	{
-		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+		.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_LOCATION_INFO_KHR,
 		.pNext = nullptr,
-		.renderPass = this->DeferredRenderPass,
-		.framebuffer = this->DeferredFramebuffer,
-		.renderArea =
-		{
-			.offset = {},
-			.extent =
-			{
-				.width = 1600,
-				.height = 900
-			}
-		},
-		.clearValueCount = 1,
-		.pClearValues = &ClearValue
+		.colorAttachmentCount = 3,
+		.pColorAttachmentLocations = this->ColorAttachmentsLocations
 	};
 
-	vkCmdBeginRenderPass(CommandBuffer, &Info, VkSubpassContents::VK_SUBPASS_CONTENTS_INLINE);
+	this->CmdSetRenderingAttachmentLocations(CommandBuffer, &AttachmentsLocationsInfo);
+#endif
 
 	vkCmdBindPipeline(CommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, this->Pipeline);
+	RecordViewport(CommandBuffer, this->Extent);
 
-	vkCmdBindDescriptorSets(CommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, this->PipelineLayout, 0, 1, DeferredDescriptorSets.data(), 0, nullptr);
+	vkCmdBindDescriptorSets(CommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, this->PipelineLayout, 0, 1, DeferredDescriptorSets.data(), 1, this->LightSpaceUniformOffset);
 	vkCmdDraw(CommandBuffer, 4, 1, 0, 0);
 
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	vkCmdEndRendering(CommandBuffer);
+#else
 	vkCmdEndRenderPass(CommandBuffer);
+#endif
 }
\ No newline at end of file
@@ -1,14 +1,63 @@
 #pragma once
 
 #include "RenderPass.hpp"
+#include <compare>
+#include <map>
 #include <vector>
 
+#define TUTORIAL_VK_DIRECT_TO_SWAPCHAIN // Comment out to render into intermediate result image blitted into swapchain (needed once post-processing reads result).
+
+// Scene render pass begun by G-buffer generation and ended by deferred shading. Owned by deferred pass.
+struct SceneRenderPassInfo
+{
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	VkFormat ResultFormat;
+	std::vector<VkImageView>* ResultViews; // One per swapchain image when rendering directly into swapchain.
+#else
+	VkRenderPass* RenderPass;
+	std::vector<VkFramebuffer>* Framebuffers; // One per swapchain image when rendering directly into swapchain.
+#endif
+};
+
 struct DeferredAdditionalRequiredInfo
 {
 	VkImageView* GBufferPositionView;
 	VkImageView* GBufferNormalView;
+	VkImageView* GBufferDepthView;
 	VkBuffer* LightSpaceUniformBuffer;
+	uint32_t* LightSpaceUniformOffset;
+	VkDeviceSize LightSpaceUniformRange;
 	VkImageView* VarianceShadowMapView;
+	VkFormat SwapchainFormat;
+	const std::vector<VkImageView>* SwapchainViews;
+};
+
+enum DeferredShadowFiltering : uint32_t
+{
+	HardShadowFiltering, // Shadow map depth compared against pixel depth.
+	VarianceShadowFiltering // Chebyshev upper bound of shadow map moments.
+};
+
+enum DeferredTonemapping : uint32_t
+{
+	ExposureTonemapping,
+	ReinhardTonemapping
+};
+
+// Specialization constants of deferred shading fragment shader, laid out in order of their constant IDs. Each distinct
+// variant is compiled into its own pipeline, so branches not taken by it cost nothing.
+struct DeferredShadingVariant
+{
+	VkBool32 IsShadowEnabled = VK_TRUE;
+	DeferredShadowFiltering ShadowFiltering = VarianceShadowFiltering;
+	DeferredTonemapping Tonemapping = ExposureTonemapping;
+	float Exposure = 0.7f;
+	float Gamma = 2.2f;
+	float MinVariance = 0.0004f;
+	float LightBleedingReduction = 0.98f;
+	float HardShadowBias = 0.005f;
+
+	auto operator<=>(const DeferredShadingVariant& Other) const = default;
 };
 
 class DeferredPass : public RenderPass
@@ -18,12 +67,20 @@ private:
 	VkShaderModule DeferredFragmentShaderModule;
 	std::vector<VkPipelineShaderStageCreateInfo> ShaderStages;
 
-	VkImage ResultImage;
-	VkImageView ResultImageView;
-	VkDeviceMemory ResultImageMemory;
+	VkImage ResultImage{};
+	VkImageView ResultImageView{};
+
+	// G-buffer generation subpass followed by deferred shading subpass.
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	std::vector<VkImageView> SceneResultViews;
 
-	VkRenderPass DeferredRenderPass;
-	VkFramebuffer DeferredFramebuffer;
+	// G-buffer attachments precede result attachment, but only result is written. G-buffer is read through input attachments.
+	const uint32_t ColorAttachmentsLocations[3] = { VK_ATTACHMENT_UNUSED, VK_ATTACHMENT_UNUSED, 0 };
+	PFN_vkCmdSetRenderingAttachmentLocationsKHR CmdSetRenderingAttachmentLocations = nullptr;
+#else
+	VkRenderPass SceneRenderPass;
+	std::vector<VkFramebuffer> SceneFramebuffers;
+#endif
 
 	VkDescriptorSetLayout DeferredDescriptorSetLayout;
 	VkDescriptorPool DeferredDescriptorPool;
@@ -32,23 +89,52 @@ private:
 	VkPipelineLayout PipelineLayout;	
 	VkPipeline Pipeline;
 
+	// Pipelines of every variant used so far, kept so switching back doesn't compile it again.
+	std::map<DeferredShadingVariant, VkPipeline> VariantPipelines;
+	DeferredShadingVariant Variant{};
+	VkPipelineCache PipelineCache = VK_NULL_HANDLE;
+
+	VkPipeline CreatePipeline(const DeferredShadingVariant& Variant);
+
 	VkSampler VarianceShadowMapSampler;
 
+	uint32_t* LightSpaceUniformOffset = nullptr;
+
+	uint32_t GraphicsQueueIndex = 0;
+	DeferredAdditionalRequiredInfo AdditionalResources{};
+
 public:
 	DeferredPass(VkDevice Device, const uint32_t GraphicsQueueIndex, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties, DeferredAdditionalRequiredInfo& AdditionalInfo);
 
 	virtual void FreeGPUResources() override;
 
-	virtual void SetupShaders() override;
+	virtual void DeclareRenderTargets(RenderTargetHeap& Heap) override;
+
+	virtual void SetupRenderTargets() override;
+
+	virtual void FreeRenderTargets() override;
+
+	virtual void DeclareGraphUsage(RenderGraph& Graph, const uint32_t GraphPass) override;
+
+	virtual void UpdateGraphImages(RenderGraph& Graph) override;
+
+	virtual void SetupShaders(ShaderArchive& Shaders) override;
+
+	virtual void SetupPipeline(VkPipelineCache PipelineCache) override;
+
+	// Switches shading variant, creating its pipeline when used for the first time. Recorded command buffers become outdated.
+	void SetVariant(const DeferredShadingVariant& Variant);
 
-	virtual void SetupPipeline() override;
+	const DeferredShadingVariant& GetVariant() const;
 
+	// Records deferred shading subpass and ends scene render pass begun by G-buffer generation.
 	void RecordCommandBuffer(VkCommandBuffer CommandBuffer);
 
 	virtual ~DeferredPass() = default;
 
 	struct
 	{
-		VkImage* ResultImage;
+		VkImage* ResultImage; // Null when rendering directly into swapchain.
+		SceneRenderPassInfo SceneRenderPass;
 	} SharedResources;
 };
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "FrameBenchmark.hpp"
+#include "Helpers.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+FrameBenchmark::FrameBenchmark(const std::string& SceneName, const std::string& DeviceName, const uint32_t WarmupFramesCount, const uint32_t MeasuredFramesCount)
+{
+	this->SceneName = SceneName;
+	this->DeviceName = DeviceName;
+	this->WarmupFramesCount = WarmupFramesCount;
+	this->MeasuredFramesCount = MeasuredFramesCount;
+}
+
+uint32_t FrameBenchmark::GetTotalFramesCount() const
+{
+	return this->WarmupFramesCount + this->MeasuredFramesCount;
+}
+
+glm::mat4 FrameBenchmark::EvaluateCameraView(const uint32_t FrameIndex) const
+{
+	const float Progress = static_cast<float>(FrameIndex) / static_cast<float>(GetTotalFramesCount());
+
+	// Same starting point as default camera, orbiting around scene origin.
+	glm::mat4 ViewMatrix = glm::mat4(1.0f);
+	ViewMatrix = glm::rotate(ViewMatrix, glm::radians(-48.0f), glm::vec3(0.5f, 0.7f, 0.0f));
+	ViewMatrix = glm::translate(ViewMatrix, glm::vec3(-9.0f, 8.0f, -8.0f));
+	ViewMatrix = glm::rotate(ViewMatrix, Progress * glm::radians(360.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	return ViewMatrix;
+}
+
+glm::mat4 FrameBenchmark::EvaluateCameraProjection(const float AspectRatio) const
+{
+	return glm::perspective(glm::radians(45.0f), AspectRatio, 0.1f, 100.0f);
+}
+
+glm::vec3 FrameBenchmark::EvaluateLightDirection(const uint32_t FrameIndex) const
+{
+	const float Progress = static_cast<float>(FrameIndex) / static_cast<float>(GetTotalFramesCount());
+
+	const glm::mat4 Rotation = glm::rotate(glm::mat4(1.0f), Progress * glm::radians(720.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	return glm::vec3(Rotation * glm::vec4(-10.0f, 25.0f, 4.0f, 0.0f));
+}
+
+void FrameBenchmark::AddSample(const uint32_t FrameIndex, const std::string& Metric, const double Value, const std::string& Unit)
+{
+	if (FrameIndex < this->WarmupFramesCount)
+		return;
+
+	auto& MetricSamples = this->Samples[Metric];
+	MetricSamples.Unit = Unit;
+	MetricSamples.Values.push_back(Value);
+}
+
+FrameBenchmark::MetricSummary FrameBenchmark::Summarize(const std::vector<double>& Values)
+{
+	MetricSummary Summary;
+	if (Values.empty())
+		return Summary;
+
+	std::vector<double> SortedSamples = Values;
+	std::sort(SortedSamples.begin(), SortedSamples.end());
+
+	// Nearest-rank percentile.
+	const auto Percentile = [&](const double Rank)
+	{
+		const size_t Index = static_cast<size_t>(std::ceil(Rank / 100.0 * SortedSamples.size()));
+		return SortedSamples[std::clamp<size_t>(Index, 1, SortedSamples.size()) - 1];
+	};
+
+	double SummedSamples = 0.0;
+	for (const double Sample : SortedSamples)
+	{
+		SummedSamples += Sample;
+	}
+
+	Summary.SamplesCount = SortedSamples.size();
+	Summary.Mean = SummedSamples / SortedSamples.size();
+	Summary.P50 = Percentile(50.0);
+	Summary.P95 = Percentile(95.0);
+	Summary.P99 = Percentile(99.0);
+	Summary.Min = SortedSamples.front();
+	Summary.Max = SortedSamples.back();
+
+	return Summary;
+}
+
+// Every field is quoted, quotes inside are doubled.
+std::string FrameBenchmark::EscapeCSV(const std::string& Text)
+{
+	std::string Escaped = "\"";
+	for (const char Character : Text)
+	{
+		if (Character == '"')
+		{
+			Escaped += '"';
+		}
+		Escaped += Character;
+	}
+	return Escaped + "\"";
+}
+
+void FrameBenchmark::PrintSummary() const
+{
+	std::cout << "Benchmark of " << this->SceneName << " on " << this->DeviceName << ", " << this->MeasuredFramesCount << " frames after " << this->WarmupFramesCount << " warm-up frames:" << std::endl;
+
+	for (const auto& [Metric, MetricSamples] : this->Samples)
+	{
+		const auto Summary = Summarize(MetricSamples.Values);
+		const auto& Unit = MetricSamples.Unit;
+
+		std::cout << "\t" << Metric << ": mean " << Summary.Mean << Unit << ", p50 " << Summary.P50 << Unit << ", p95 " << Summary.P95 << Unit << ", p99 " << Summary.P99 << Unit << std::endl;
+	}
+}
+
+void FrameBenchmark::WriteJSON(const std::string& FilePath) const
+{
+	std::ofstream File(FilePath);
+
+	File << "{\n";
+	File << "\t\"scene\": \"" << EscapeJSON(this->SceneName) << "\",\n";
+	File << "\t\"device\": \"" << EscapeJSON(this->DeviceName) << "\",\n";
+	File << "\t\"warmupFrames\": " << this->WarmupFramesCount << ",\n";
+	File << "\t\"measuredFrames\": " << this->MeasuredFramesCount << ",\n";
+
+	File << "\t\"metrics\": [";
+	bool IsFirst = true;
+	for (const auto& [Metric, MetricSamples] : this->Samples)
+	{
+		const auto Summary = Summarize(MetricSamples.Values);
+
+		File << (IsFirst ? "\n" : ",\n") << "\t\t{ \"metric\": \"" << EscapeJSON(Metric) << "\", \"unit\": \"" << EscapeJSON(MetricSamples.Unit) << "\", \"samples\": " << Summary.SamplesCount
+			<< ", \"mean\": " << Summary.Mean << ", \"p50\": " << Summary.P50 << ", \"p95\": " << Summary.P95 << ", \"p99\": " << Summary.P99
+			<< ", \"min\": " << Summary.Min << ", \"max\": " << Summary.Max << " }";
+		IsFirst = false;
+	}
+	File << "\n\t]\n";
+	File << "}\n";
+
+	std::cout << "Benchmark results written into " << FilePath << "." << std::endl;
+}
+
+void FrameBenchmark::WriteCSV(const std::string& FilePath) const
+{
+	std::ofstream File(FilePath);
+
+	File << "scene,device,metric,unit,samples,mean,p50,p95,p99,min,max\n";
+	for (const auto& [Metric, MetricSamples] : this->Samples)
+	{
+		const auto Summary = Summarize(MetricSamples.Values);
+
+		File << EscapeCSV(this->SceneName) << "," << EscapeCSV(this->DeviceName) << "," << EscapeCSV(Metric) << "," << EscapeCSV(MetricSamples.Unit) << "," << Summary.SamplesCount << "," << Summary.Mean << "," << Summary.P50 << ","
+			<< Summary.P95 << "," << Summary.P99 << "," << Summary.Min << "," << Summary.Max << "\n";
+	}
+
+	std::cout << "Benchmark results written into " << FilePath << "." << std::endl;
+}
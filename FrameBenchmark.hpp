@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Deterministic benchmark run. Camera and light follow scripted path which depends only on frame index,
+// so every run renders exactly the same frames. Samples of named metrics are gathered after warm-up
+// and summarized as mean and percentiles, which can be written as JSON or CSV for comparison across commits and machines.
+class FrameBenchmark
+{
+private:
+	std::string SceneName;
+	std::string DeviceName;
+	uint32_t WarmupFramesCount = 0;
+	uint32_t MeasuredFramesCount = 0;
+
+	struct MetricSamples
+	{
+		std::string Unit;
+		std::vector<double> Values;
+	};
+	std::map<std::string, MetricSamples> Samples;
+
+	struct MetricSummary
+	{
+		size_t SamplesCount = 0;
+		double Mean = 0.0;
+		double P50 = 0.0;
+		double P95 = 0.0;
+		double P99 = 0.0;
+		double Min = 0.0;
+		double Max = 0.0;
+	};
+
+	static MetricSummary Summarize(const std::vector<double>& Values);
+
+	// Names come from command line and driver, so they may contain quotes, separators or control characters.
+	static std::string EscapeCSV(const std::string& Text);
+
+public:
+	FrameBenchmark(const std::string& SceneName, const std::string& DeviceName, const uint32_t WarmupFramesCount, const uint32_t MeasuredFramesCount);
+
+	uint32_t GetTotalFramesCount() const;
+
+	// Camera orbits scene once during whole run.
+	glm::mat4 EvaluateCameraView(const uint32_t FrameIndex) const;
+	glm::mat4 EvaluateCameraProjection(const float AspectRatio) const;
+
+	// Light rotates around vertical axis twice during whole run.
+	glm::vec3 EvaluateLightDirection(const uint32_t FrameIndex) const;
+
+	// Samples of warm-up frames are dropped. Unit is empty for plain counts.
+	void AddSample(const uint32_t FrameIndex, const std::string& Metric, const double Value, const std::string& Unit = "ms");
+
+	void PrintSummary() const;
+
+	void WriteJSON(const std::string& FilePath) const;
+
+	void WriteCSV(const std::string& FilePath) const;
+
+	~FrameBenchmark() = default;
+};
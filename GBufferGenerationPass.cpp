@@ -1,11 +1,20 @@
 #include "GBufferGenerationPass.hpp"
 #include "Helpers.hpp"
+#include "GPUMemoryTracker.hpp"
+
+#include <algorithm>
+#include <iostream>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-GBufferGenerationPass::GBufferGenerationPass(VkDevice Device, const uint32_t GraphicsQueueIndex, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties, VkImageView DepthBuffer) : RenderPass(Device)
+GBufferGenerationPass::GBufferGenerationPass(VkDevice Device, const uint32_t GraphicsQueueIndex, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties, UniformRingBuffer& FrameUniforms) : RenderPass(Device)
 {
+	TUTORIAL_VK_PROFILE_ZONE("GBufferGenerationPass::GBufferGenerationPass");
+
+	this->GraphicsQueueIndex = GraphicsQueueIndex;
+	this->DeviceMemoryProperties = &DeviceMemoryProperties;
+
 	// Setup uniform buffer.
 	{
 		// Setup descriptor layout.
@@ -13,7 +22,7 @@ GBufferGenerationPass::GBufferGenerationPass(VkDevice Device, const uint32_t Gra
 			VkDescriptorSetLayoutBinding DescriptorSetLayoutBinding
 			{
 				.binding = 0,
-				.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				.descriptorCount = 1,
 				.stageFlags = VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT,
 				.pImmutableSamplers = nullptr
@@ -31,75 +40,16 @@ GBufferGenerationPass::GBufferGenerationPass(VkDevice Device, const uint32_t Gra
 			vkCreateDescriptorSetLayout(Device, &CreationInfo, nullptr, &DeferredPassSetLayout);
 		}
 
-		// Setup uniform buffer itself.
+		// Setup camera.
 		{
-			VkBufferCreateInfo BufferCreationInfo
-			{
-				.sType = VkStructureType::VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-				.pNext = nullptr,
-				.flags = 0,
-				.size = 128,
-				.usage = VkBufferUsageFlagBits::VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
-				.queueFamilyIndexCount = 1,
-				.pQueueFamilyIndices = &GraphicsQueueIndex
-			};
-
-			vkCreateBuffer(Device, &BufferCreationInfo, nullptr, &SceneTransformationUBO);
+			this->FrameUniforms = &FrameUniforms;
 
-			VkMemoryRequirements MemoryRequirements;
-			vkGetBufferMemoryRequirements(Device, SceneTransformationUBO, &MemoryRequirements);
+			glm::mat4 ViewMatrix = glm::mat4(1.0f);
+			ViewMatrix = glm::rotate(ViewMatrix, glm::radians(-48.0f), glm::vec3(0.5f, 0.7f, 0.0f));
+			//ViewMatrix = glm::translate(ViewMatrix, glm::vec3(-9.0f, -5.0f, -10.0f));
+			ViewMatrix = glm::translate(ViewMatrix, glm::vec3(-9.0f, 8.0f, -8.0f));
 
-			VkMemoryAllocateInfo AllocationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-				.pNext = nullptr,
-				.allocationSize = MemoryRequirements.size,
-				.memoryTypeIndex = QueryMemoryTypeIndex(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, MemoryRequirements.memoryTypeBits, DeviceMemoryProperties)
-			};
-
-			vkAllocateMemory(Device, &AllocationInfo, nullptr, &SceneTransformationUBOMemory);
-
-			vkBindBufferMemory(Device, SceneTransformationUBO, SceneTransformationUBOMemory, 0);
-		}
-
-		// Update uniform buffer.
-		{
-			using namespace glm;
-
-			void* MappedBufferPtr = nullptr;
-			vkMapMemory(Device, SceneTransformationUBOMemory, 0, VK_WHOLE_SIZE, 0, &MappedBufferPtr);
-
-			struct BufferContent
-			{
-				mat4 ViewMatrix;
-				f32mat4 ProjectionMatrix;
-			} Content
-			{
-				.ViewMatrix = mat4(1.0f),
-				.ProjectionMatrix = mat4(1.0f)
-			};
-
-			Content.ViewMatrix = glm::rotate(Content.ViewMatrix, glm::radians(-48.0f), glm::vec3(0.5f, 0.7f, 0.0f));
-			//Content.ViewMatrix = glm::translate(Content.ViewMatrix, glm::vec3(-9.0f, -5.0f, -10.0f));
-			Content.ViewMatrix = glm::translate(Content.ViewMatrix, glm::vec3(-9.0f, 8.0f, -8.0f));
-
-			Content.ProjectionMatrix = glm::perspective(glm::radians(45.0f), 1600.0f / 900.0f, 0.1f, 100.0f);
-
-			std::memcpy(MappedBufferPtr, &Content, sizeof(Content));
-
-			VkMappedMemoryRange MappedRange
-			{
-				.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-				.pNext = nullptr,
-				.memory = SceneTransformationUBOMemory,
-				.offset = 0,
-				.size = VK_WHOLE_SIZE
-			};
-
-			vkFlushMappedMemoryRanges(Device, 1, &MappedRange);
-
-			vkUnmapMemory(Device, SceneTransformationUBOMemory);
+			SetCamera(ViewMatrix, glm::perspective(glm::radians(45.0f), static_cast<float>(this->Extent.width) / static_cast<float>(this->Extent.height), 0.1f, 100.0f));
 		}
 
 		// Setup descriptor pool.
@@ -107,7 +57,7 @@ GBufferGenerationPass::GBufferGenerationPass(VkDevice Device, const uint32_t Gra
 			std::vector<VkDescriptorPoolSize> PoolSizes
 			{
 				{
-					.type = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+					.type = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 					.descriptorCount = 1
 				}
 			};
@@ -146,9 +96,9 @@ GBufferGenerationPass::GBufferGenerationPass(VkDevice Device, const uint32_t Gra
 		{
 			VkDescriptorBufferInfo DescriptorBufferInfo
 			{
-				.buffer = SceneTransformationUBO,
+				.buffer = FrameUniforms.GetBuffer(),
 				.offset = 0,
-				.range = VK_WHOLE_SIZE
+				.range = sizeof(SceneTransformationContent)
 			};
 
 			VkWriteDescriptorSet DescriptorConfiguration
@@ -159,7 +109,7 @@ GBufferGenerationPass::GBufferGenerationPass(VkDevice Device, const uint32_t Gra
 				.dstBinding = 0,
 				.dstArrayElement = 0,
 				.descriptorCount = 1,
-				.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				.pImageInfo = nullptr,
 				.pBufferInfo = &DescriptorBufferInfo,
 				.pTexelBufferView = nullptr
@@ -169,254 +119,265 @@ GBufferGenerationPass::GBufferGenerationPass(VkDevice Device, const uint32_t Gra
 		}
 	}
 
-
-	// Setup G-buffer itself.
+	// Setup pipeline layout.
 	{
-		// Create images.
-		{
-			VkImageCreateInfo ImageCreationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-				.pNext = nullptr,
-				.flags = 0,
-				.imageType = VkImageType::VK_IMAGE_TYPE_2D,
-				.format = VkFormat::VK_FORMAT_R32G32B32A32_SFLOAT,
-				.extent =
-				{
-					.width = 1600,
-					.height = 900,
-					.depth = 1
-				},
-				.mipLevels = 1,
-				.arrayLayers = 1,
-				.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
-				.tiling = VkImageTiling::VK_IMAGE_TILING_OPTIMAL,
-				.usage = VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-				.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
-				.queueFamilyIndexCount = 1,
-				.pQueueFamilyIndices = &GraphicsQueueIndex,
-				.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED
-			};
-
-			vkCreateImage(Device, &ImageCreationInfo, nullptr, &GBufferPositionImage);
-			vkCreateImage(Device, &ImageCreationInfo, nullptr, &GBufferNormalImage);
-		}
-
-		// Allocate memory.
+		VkPipelineLayoutCreateInfo CreationInfo
 		{
-			VkMemoryRequirements MemoryRequirements{};
-			vkGetImageMemoryRequirements(Device, GBufferPositionImage, &MemoryRequirements);
-
-			const size_t MemoryToAlign = MemoryRequirements.size % MemoryRequirements.alignment;
-			const size_t MemoryWithoutAlign = (MemoryRequirements.size - MemoryToAlign) / MemoryRequirements.alignment;
-
-			const size_t RequiredSegments = MemoryWithoutAlign + (MemoryToAlign > 0 ? 1 : 0);
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.setLayoutCount = 1,
+			.pSetLayouts = &DeferredPassSetLayout,
+			.pushConstantRangeCount = 0,
+			.pPushConstantRanges = nullptr
+		};
 
-			VkMemoryAllocateInfo AllocationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-				.pNext = nullptr,
-				.allocationSize = RequiredSegments * MemoryRequirements.alignment * 2,
-				.memoryTypeIndex = QueryMemoryTypeIndex(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryRequirements.memoryTypeBits, DeviceMemoryProperties)
-			};
+		vkCreatePipelineLayout(Device, &CreationInfo, nullptr, &PipelineLayout);
+	}
+}
 
-			vkAllocateMemory(Device, &AllocationInfo, nullptr, &GBufferMemory);
-			vkBindImageMemory(Device, GBufferPositionImage, GBufferMemory, 0);
-			vkBindImageMemory(Device, GBufferNormalImage, GBufferMemory, RequiredSegments * MemoryRequirements.alignment);
-		}
+void GBufferGenerationPass::FreeGPUResources()
+{
+	vkDestroyDescriptorPool(Device, DeferredPassDescriptorPool, nullptr);
 
-		// Create image views.
-		{
-			VkImageSubresourceRange SubresourceViewInfo
-			{
-				.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT,
-				.baseMipLevel = 0,
-				.levelCount = 1,
-				.baseArrayLayer = 0,
-				.layerCount = 1
-			};
+	vkDestroyDescriptorSetLayout(Device, DeferredPassSetLayout, nullptr);
 
-			VkImageViewCreateInfo CreationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-				.pNext = nullptr,
-				.flags = 0,
-				.image = GBufferPositionImage,
-				.viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D,
-				.format = VkFormat::VK_FORMAT_R32G32B32A32_SFLOAT,
-				.components =
-				{
-					.r = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-					.g = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-					.b = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-					.a = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY
-				},
-				.subresourceRange = SubresourceViewInfo
-			};
+	FreeRenderTargets();
 
-			vkCreateImageView(Device, &CreationInfo, nullptr, &GBufferPositionImageView);
+	vkDestroyPipeline(Device, Pipeline, nullptr);
+	vkDestroyPipelineLayout(Device, PipelineLayout, nullptr);
+}
 
-			CreationInfo.image = GBufferNormalImage;
-			vkCreateImageView(Device, &CreationInfo, nullptr, &GBufferNormalImageView);
+void GBufferGenerationPass::SetSceneRenderPass(const SceneRenderPassInfo& SceneRenderPass)
+{
+	this->SceneRenderPass = SceneRenderPass;
+}
 
-			this->SharedResources.GBufferPositionImageViewLink = &this->GBufferPositionImageView;
-			this->SharedResources.GBufferNormalImageViewLink = &this->GBufferNormalImageView;
-		}
-	}
+void GBufferGenerationPass::DeclareRenderTargets(RenderTargetHeap& Heap)
+{
+	// G-buffer and depth buffer never leave scene render pass, so their content doesn't have to be stored into memory.
+	const VkImageUsageFlags ImageUsage = VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
 
-	// Setup render pass.
+	VkImageCreateInfo ImageCreationInfo
 	{
-		VkAttachmentDescription ColorAttachmentInfo
-		{
-			.flags = 0,
-			.format = VkFormat::VK_FORMAT_R32G32B32A32_SFLOAT,
-			.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
-			.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR,
-			.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_STORE,
-			.stencilLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-			.stencilStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE,
-			.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED,
-			.finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-		VkAttachmentDescription DepthAttachmentInfo
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.imageType = VkImageType::VK_IMAGE_TYPE_2D,
+		.format = VkFormat::VK_FORMAT_R32G32B32A32_SFLOAT,
+		.extent =
 		{
-			.flags = 0,
-			.format = VkFormat::VK_FORMAT_D32_SFLOAT,
-			.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
-			.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR,
-			.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE,
-			.stencilLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-			.stencilStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE,
-			.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED,
-			.finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL
-		};
+			.width = this->Extent.width,
+			.height = this->Extent.height,
+			.depth = 1
+		},
+		.mipLevels = 1,
+		.arrayLayers = 1,
+		.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
+		.tiling = VkImageTiling::VK_IMAGE_TILING_OPTIMAL,
+		.usage = ImageUsage,
+		.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
+		.queueFamilyIndexCount = 1,
+		.pQueueFamilyIndices = &this->GraphicsQueueIndex,
+		.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED
+	};
 
-		std::vector<VkAttachmentReference> ColorAttachments
-		{
-			{
-				.attachment = 0,
-				.layout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-			},
-			{
-				.attachment = 1,
-				.layout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-			}
-		};
+	// Setup G-buffer itself.
+	{
+#ifdef TUTORIAL_VK_TRANSIENT_GBUFFER
+		// Transient G-buffer keeps its own lazily allocated memory, aliasing it with other targets would force device to back it.
+		GPUMemory.CreateImage(Device, ImageCreationInfo, GBufferPositionImage, "GBufferGenerationPass", "G-buffer position");
+		GPUMemory.CreateImage(Device, ImageCreationInfo, GBufferNormalImage, "GBufferGenerationPass", "G-buffer normal");
 
-		VkAttachmentReference DepthAttachmentReference
-		{
-			.attachment = 2,
-			.layout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-		};
+		VkMemoryRequirements MemoryRequirements{};
+		vkGetImageMemoryRequirements(Device, GBufferPositionImage, &MemoryRequirements);
 
-		VkSubpassDependency SubpassDependencyInfo
-		{
-			.srcSubpass = VK_SUBPASS_EXTERNAL,
-			.dstSubpass = 0,
-			.srcStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-			.dstStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-			.srcAccessMask = 0,
-			.dstAccessMask = VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-			.dependencyFlags = 0
-		};
+		const auto Segments = ComputeMemorySegments(MemoryRequirements);
+		const VkDeviceSize ImageMemorySize = Segments.SegmentSize * Segments.SegmentsCount;
 
-		VkSubpassDescription SubpassInfo
+		// Transient attachments may live in lazily allocated memory, which tile-based devices keep on-chip.
+		uint32_t MemoryTypeIndex = 0;
+		this->IsGBufferMemoryLazilyAllocated = FindMemoryTypeIndex(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, MemoryRequirements.memoryTypeBits, *this->DeviceMemoryProperties, MemoryTypeIndex);
+		if (!this->IsGBufferMemoryLazilyAllocated)
 		{
-			.flags = 0,
-			.pipelineBindPoint = VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS,
-			.inputAttachmentCount = 0,
-			.pInputAttachments = nullptr,
-			.colorAttachmentCount = static_cast<uint32_t>(ColorAttachments.size()),
-			.pColorAttachments = ColorAttachments.data(),
-			.pResolveAttachments = nullptr,
-			.pDepthStencilAttachment = &DepthAttachmentReference,
-			.preserveAttachmentCount = 0,
-			.pPreserveAttachments = nullptr
-		};
+			MemoryTypeIndex = QueryMemoryTypeIndex(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryRequirements.memoryTypeBits, *this->DeviceMemoryProperties);
+		}
 
-		VkAttachmentDescription Attachments[] = { ColorAttachmentInfo, ColorAttachmentInfo, DepthAttachmentInfo };
+		this->GBufferMemorySize = ImageMemorySize * 2;
 
-		VkRenderPassCreateInfo CreationInfo
+		VkMemoryAllocateInfo AllocationInfo
 		{
-			.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
 			.pNext = nullptr,
-			.flags = 0,
-			.attachmentCount = 3,
-			.pAttachments = Attachments,
-			.subpassCount = 1,
-			.pSubpasses = &SubpassInfo,
-			.dependencyCount = 1,
-			.pDependencies = &SubpassDependencyInfo
+			.allocationSize = this->GBufferMemorySize,
+			.memoryTypeIndex = MemoryTypeIndex
 		};
 
-		vkCreateRenderPass(Device, &CreationInfo, nullptr, &SceneRenderPass);
+		GPUMemory.AllocateMemory(Device, AllocationInfo, GBufferMemory, "GBufferGenerationPass", "Transient G-buffer");
+		GPUMemory.BindImageMemory(Device, GBufferPositionImage, GBufferMemory, 0);
+		GPUMemory.BindImageMemory(Device, GBufferNormalImage, GBufferMemory, ImageMemorySize);
+#else
+		// G-buffer is written here and read by deferred shading subpass.
+		const VkPipelineStageFlags2 StageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+		const VkAccessFlags2 AccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_INPUT_ATTACHMENT_READ_BIT;
+
+		GBufferPositionImage = Heap.DeclareImage(ImageCreationInfo, "GBufferGenerationPass", "G-buffer position", FrameStage::SceneRenderingStage, FrameStage::SceneRenderingStage, StageMask, AccessMask);
+		GBufferNormalImage = Heap.DeclareImage(ImageCreationInfo, "GBufferGenerationPass", "G-buffer normal", FrameStage::SceneRenderingStage, FrameStage::SceneRenderingStage, StageMask, AccessMask);
+#endif
 	}
 
-	// Setup framebuffer.
+	// Setup depth buffer. It is needed only during scene render pass, which can't share memory between its attachments.
 	{
-		VkImageView Attachments[] = { GBufferPositionImageView, GBufferNormalImageView, DepthBuffer };
-
-		VkFramebufferCreateInfo CreationInfo
-		{
-			.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-			.pNext = nullptr,
-			.flags = 0,
-			.renderPass = SceneRenderPass,
-			.attachmentCount = 3,
-			.pAttachments = Attachments,
-			.width = 1600,
-			.height = 900,
-			.layers = 1
-		};
+		ImageCreationInfo.format = VkFormat::VK_FORMAT_D32_SFLOAT;
+		ImageCreationInfo.usage = VkImageUsageFlagBits::VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
 
-		vkCreateFramebuffer(Device, &CreationInfo, nullptr, &GBufferGenerationPassFramebuffer);
+		DepthBuffer = Heap.DeclareImage(ImageCreationInfo, "GBufferGenerationPass", "Scene depth buffer", FrameStage::SceneRenderingStage, FrameStage::SceneRenderingStage,
+			VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
 	}
+}
 
-	// Setup pipeline layout.
+void GBufferGenerationPass::SetupRenderTargets()
+{
+	TUTORIAL_VK_PROFILE_ZONE("GBufferGenerationPass::SetupRenderTargets");
+
+	// Create image views.
 	{
-		VkPipelineLayoutCreateInfo CreationInfo
+		VkImageSubresourceRange SubresourceViewInfo
 		{
-			.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+			.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1
+		};
+
+		VkImageViewCreateInfo CreationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
 			.pNext = nullptr,
 			.flags = 0,
-			.setLayoutCount = 1,
-			.pSetLayouts = &DeferredPassSetLayout,
-			.pushConstantRangeCount = 0,
-			.pPushConstantRanges = nullptr
+			.image = GBufferPositionImage,
+			.viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D,
+			.format = VkFormat::VK_FORMAT_R32G32B32A32_SFLOAT,
+			.components =
+			{
+				.r = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.g = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.b = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.a = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY
+			},
+			.subresourceRange = SubresourceViewInfo
 		};
 
-		vkCreatePipelineLayout(Device, &CreationInfo, nullptr, &PipelineLayout);
+		vkCreateImageView(Device, &CreationInfo, nullptr, &GBufferPositionImageView);
+
+		CreationInfo.image = GBufferNormalImage;
+		vkCreateImageView(Device, &CreationInfo, nullptr, &GBufferNormalImageView);
+
+		CreationInfo.image = DepthBuffer;
+		CreationInfo.format = VkFormat::VK_FORMAT_D32_SFLOAT;
+		CreationInfo.subresourceRange.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_DEPTH_BIT;
+		vkCreateImageView(Device, &CreationInfo, nullptr, &DepthBufferView);
+
+		this->SharedResources.GBufferPositionImageViewLink = &this->GBufferPositionImageView;
+		this->SharedResources.GBufferNormalImageViewLink = &this->GBufferNormalImageView;
+		this->SharedResources.DepthBufferViewLink = &this->DepthBufferView;
 	}
 }
 
-void GBufferGenerationPass::FreeGPUResources()
+void GBufferGenerationPass::DeclareGraphUsage(RenderGraph& Graph, const uint32_t GraphPass)
 {
-	vkDestroyDescriptorPool(Device, DeferredPassDescriptorPool, nullptr);
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	// Dynamic render pass doesn't transition its attachments. G-buffer is both written and read within it, which requires local read layout.
+	const RenderGraphUsage GBufferAttachmentUsage
+	{
+		.StageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+		.AccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_INPUT_ATTACHMENT_READ_BIT,
+		.Layout = VkImageLayout::VK_IMAGE_LAYOUT_RENDERING_LOCAL_READ_KHR
+	};
+	const RenderGraphUsage DepthAttachmentUsage
+	{
+		.StageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+		.AccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+		.Layout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL
+	};
 
-	vkDestroyBuffer(Device, SceneTransformationUBO, nullptr);
-	vkFreeMemory(Device, SceneTransformationUBOMemory, nullptr);
-	vkDestroyDescriptorSetLayout(Device, DeferredPassSetLayout, nullptr);
+	// All attachments are cleared.
+	Graph.Write(GraphPass, Graph.AddImage("GBufferPosition", GBufferPositionImage, VK_IMAGE_ASPECT_COLOR_BIT), GBufferAttachmentUsage, true);
+	Graph.Write(GraphPass, Graph.AddImage("GBufferNormal", GBufferNormalImage, VK_IMAGE_ASPECT_COLOR_BIT), GBufferAttachmentUsage, true);
+	Graph.Write(GraphPass, Graph.AddImage("SceneDepth", DepthBuffer, VK_IMAGE_ASPECT_DEPTH_BIT), DepthAttachmentUsage, true);
+#else
+	// G-buffer and depth buffer are created, transitioned and consumed within scene render pass, graph never sees them.
+#endif
+}
 
-	vkDestroyImage(Device, GBufferPositionImage, nullptr);
-	vkDestroyImage(Device, GBufferNormalImage, nullptr);
+void GBufferGenerationPass::UpdateGraphImages(RenderGraph& Graph)
+{
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	Graph.SetImage(Graph.FindResource("GBufferPosition"), GBufferPositionImage);
+	Graph.SetImage(Graph.FindResource("GBufferNormal"), GBufferNormalImage);
+	Graph.SetImage(Graph.FindResource("SceneDepth"), DepthBuffer);
+#endif
+}
+
+void GBufferGenerationPass::FreeRenderTargets()
+{
 	vkDestroyImageView(Device, GBufferPositionImageView, nullptr);
 	vkDestroyImageView(Device, GBufferNormalImageView, nullptr);
-	vkFreeMemory(Device, GBufferMemory, nullptr);
+	vkDestroyImageView(Device, DepthBufferView, nullptr);
 
-	vkDestroyFramebuffer(Device, GBufferGenerationPassFramebuffer, nullptr);
+#ifdef TUTORIAL_VK_TRANSIENT_GBUFFER
+	GPUMemory.DestroyImage(Device, GBufferPositionImage);
+	GPUMemory.DestroyImage(Device, GBufferNormalImage);
+	GPUMemory.FreeMemory(Device, GBufferMemory);
+#endif
+}
 
-	vkDestroyPipeline(Device, Pipeline, nullptr);
-	vkDestroyRenderPass(Device, SceneRenderPass, nullptr);
-	vkDestroyPipelineLayout(Device, PipelineLayout, nullptr);
+void GBufferGenerationPass::ReportGBufferMemory() const
+{
+	const VkDeviceSize AllocatedInMB = this->GBufferMemorySize / 1024 / 1024;
 
-	vkDestroyShaderModule(Device, GBufferGenerationVertexShaderModule, nullptr);
-	vkDestroyShaderModule(Device, GBufferGenerationFragmentShaderModule, nullptr);
+	if (!this->GBufferMemory)
+	{
+		std::cout << "G-buffer memory: placed in render target heap." << std::endl;
+		return;
+	}
+
+	if (!this->IsGBufferMemoryLazilyAllocated)
+	{
+		std::cout << "G-buffer memory: " << AllocatedInMB << "MB fully backed (lazily allocated memory not used)." << std::endl;
+		return;
+	}
+
+	VkDeviceSize CommittedMemory = 0;
+	vkGetDeviceMemoryCommitment(Device, this->GBufferMemory, &CommittedMemory);
+
+	std::cout << "G-buffer memory: " << AllocatedInMB << "MB requested, " << CommittedMemory / 1024 / 1024 << "MB committed, " << (this->GBufferMemorySize - CommittedMemory) / 1024 / 1024 << "MB saved." << std::endl;
+}
+
+void GBufferGenerationPass::SetCamera(const glm::mat4& ViewMatrix, const glm::mat4& ProjectionMatrix)
+{
+	this->SceneTransformation.ViewMatrix = ViewMatrix;
+	this->SceneTransformation.ProjectionMatrix = ProjectionMatrix;
+
+	this->ContentVersion++;
+}
+
+void GBufferGenerationPass::SetExtent(const VkExtent2D& Extent)
+{
+	RenderPass::SetExtent(Extent);
+
+	// Camera keeps its view, projection follows aspect ratio of new resolution.
+	SetCamera(this->SceneTransformation.ViewMatrix, glm::perspective(glm::radians(45.0f), static_cast<float>(Extent.width) / static_cast<float>(Extent.height), 0.1f, 100.0f));
 }
 
-void GBufferGenerationPass::SetupShaders()
+void GBufferGenerationPass::SetupShaders(ShaderArchive& Shaders)
 {
-	GBufferGenerationVertexShaderModule = CreateShaderModule(Device, "shaders/gbuffer_generation_pass_vert.spv");
-	GBufferGenerationFragmentShaderModule = CreateShaderModule(Device, "shaders/gbuffer_generation_pass_frag.spv");
+	TUTORIAL_VK_PROFILE_ZONE("GBufferGenerationPass::SetupShaders");
+
+	GBufferGenerationVertexShaderModule = Shaders.GetModule("gbuffer_generation_pass_vert.spv");
+	GBufferGenerationFragmentShaderModule = Shaders.GetModule("gbuffer_generation_pass_frag.spv");
 
 	ShaderStages =
 	{
@@ -443,8 +404,10 @@ void GBufferGenerationPass::SetupShaders()
 	};
 }
 
-void GBufferGenerationPass::SetupPipeline()
+void GBufferGenerationPass::SetupPipeline(VkPipelineCache PipelineCache)
 {
+	TUTORIAL_VK_PROFILE_ZONE("GBufferGenerationPass::SetupPipeline");
+
 	std::vector<VkVertexInputBindingDescription> VertexInputBindings
 	{
 		VkVertexInputBindingDescription
@@ -499,39 +462,26 @@ void GBufferGenerationPass::SetupPipeline()
 		.primitiveRestartEnable = false
 	};
 
-	VkViewport Viewport
-	{
-		.x = 0,
-		.y = 0,
-		.width = 1600,
-		.height = 900,
-		.minDepth = 0.0f,
-		.maxDepth = 1.0f
-	};
-
-	VkRect2D Scissor
-	{
-		.offset
-		{
-			.x = 0,
-			.y = 0
-		},
-		.extent
-		{
-			.width = 1600,
-			.height = 900
-		}
-	};
-
+	// Viewport and scissor are set while recording, so resizing doesn't recreate pipeline.
 	VkPipelineViewportStateCreateInfo ViewportState
 	{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
 		.pNext = nullptr,
 		.flags = 0,
 		.viewportCount = 1,
-		.pViewports = &Viewport,
+		.pViewports = nullptr,
 		.scissorCount = 1,
-		.pScissors = &Scissor
+		.pScissors = nullptr
+	};
+
+	const VkDynamicState DynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo DynamicStateInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.dynamicStateCount = 2,
+		.pDynamicStates = DynamicStates
 	};
 
 	VkPipelineMultisampleStateCreateInfo SamplesInfo
@@ -593,6 +543,25 @@ void GBufferGenerationPass::SetupPipeline()
 		}
 	};
 
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	// Result attachment is part of the same dynamic render pass, but it's written only by deferred shading.
+	PipelineBlendStates.push_back(PipelineBlendStates.back());
+	PipelineBlendStates.back().colorWriteMask = 0;
+
+	const VkFormat ColorAttachmentsFormats[] = { VkFormat::VK_FORMAT_R32G32B32A32_SFLOAT, VkFormat::VK_FORMAT_R32G32B32A32_SFLOAT, SceneRenderPass.ResultFormat };
+
+	VkPipelineRenderingCreateInfo RenderingInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+		.pNext = nullptr,
+		.viewMask = 0,
+		.colorAttachmentCount = 3,
+		.pColorAttachmentFormats = ColorAttachmentsFormats,
+		.depthAttachmentFormat = VkFormat::VK_FORMAT_D32_SFLOAT,
+		.stencilAttachmentFormat = VkFormat::VK_FORMAT_UNDEFINED
+	};
+#endif
+
 	VkPipelineColorBlendStateCreateInfo ColorBlendInfo
 	{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
@@ -600,7 +569,7 @@ void GBufferGenerationPass::SetupPipeline()
 		.flags = 0,
 		.logicOpEnable = false,
 		.logicOp = VkLogicOp::VK_LOGIC_OP_AND,
-		.attachmentCount = 2,
+		.attachmentCount = static_cast<uint32_t>(PipelineBlendStates.size()),
 		.pAttachments = PipelineBlendStates.data(),
 		.blendConstants = { 0.0f, 0.0f, 0.0f, 0.0f }
 	};
@@ -624,7 +593,11 @@ void GBufferGenerationPass::SetupPipeline()
 	VkGraphicsPipelineCreateInfo CreationInfo
 	{
 		.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+		.pNext = &RenderingInfo,
+#else
 		.pNext = nullptr,
+#endif
 		.flags = 0,
 		.stageCount = 2,
 		.pStages = ShaderStages.data(),
@@ -636,73 +609,173 @@ void GBufferGenerationPass::SetupPipeline()
 		.pMultisampleState = &SamplesInfo,
 		.pDepthStencilState = &DepthStencilState,
 		.pColorBlendState = &ColorBlendInfo,
-		.pDynamicState = nullptr,
+		.pDynamicState = &DynamicStateInfo,
 		.layout = PipelineLayout,
-		.renderPass = SceneRenderPass,
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+		.renderPass = VK_NULL_HANDLE,
+#else
+		.renderPass = *SceneRenderPass.RenderPass,
+#endif
 		.subpass = 0,
 		.basePipelineHandle = nullptr,
 		.basePipelineIndex = -1
 	};
 
-	vkCreateGraphicsPipelines(Device, nullptr, 1, &CreationInfo, nullptr, &Pipeline);
+	vkCreateGraphicsPipelines(Device, PipelineCache, 1, &CreationInfo, nullptr, &Pipeline);
 }
 
-void GBufferGenerationPass::RecordCommandBuffer(VkCommandBuffer CommandBuffer, const std::vector<SceneActor>& Actors)
+void GBufferGenerationPass::RecordCommandBuffer(VkCommandBuffer CommandBuffer, const uint32_t SwapchainImageIndex, const GeometryArena& Geometry, const std::vector<SceneActor>& Actors, ParallelCommandRecorder& Recorder)
 {
-	std::vector<VkClearValue> ClearValues
+	TUTORIAL_VK_PROFILE_ZONE("GBufferGenerationPass::RecordCommandBuffer");
+
+	const VkClearValue GBufferClearValue
+	{
+		.color = { 0.05f, 0.05f, 0.05f, 1.0f }
+	};
+	const VkClearValue DepthClearValue
 	{
-		VkClearValue
+		.depthStencil =
 		{
-			.color = { 0.05f, 0.05f, 0.05f, 1.0f }
-		},
-		VkClearValue
+			.depth = 1.0f,
+			.stencil = UINT32_MAX
+		}
+	};
+	const VkRect2D RenderArea
+	{
+		.offset
 		{
-			.color = { 0.05f, 0.05f, 0.05f, 1.0f }
+			.x = 0,
+			.y = 0
 		},
-		VkClearValue
-		{
-			.depthStencil =
-			{
-				.depth = 1.0f,
-				.stencil = UINT32_MAX
-			}
-		}
+		.extent = this->Extent
+	};
+
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	// Only one result view exists unless deferred shading renders directly into swapchain.
+	const auto& ResultViews = *SceneRenderPass.ResultViews;
+	const VkImageView ResultView = ResultViews[std::min<size_t>(SwapchainImageIndex, ResultViews.size() - 1)];
+
+	// Result attachment isn't touched until deferred shading remaps output locations onto it.
+	VkRenderingAttachmentInfo GBufferAttachmentInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+		.pNext = nullptr,
+		.imageView = GBufferPositionImageView,
+		.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_RENDERING_LOCAL_READ_KHR,
+		.resolveMode = VK_RESOLVE_MODE_NONE,
+		.resolveImageView = VK_NULL_HANDLE,
+		.resolveImageLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED,
+		.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR,
+		.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.clearValue = GBufferClearValue
+	};
+	std::vector<VkRenderingAttachmentInfo> ColorAttachmentsInfos(3, GBufferAttachmentInfo);
+	ColorAttachmentsInfos[1].imageView = GBufferNormalImageView;
+	ColorAttachmentsInfos[2].imageView = ResultView;
+	ColorAttachmentsInfos[2].imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	ColorAttachmentsInfos[2].loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	ColorAttachmentsInfos[2].storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_STORE;
+
+	VkRenderingAttachmentInfo DepthAttachmentInfo = GBufferAttachmentInfo;
+	DepthAttachmentInfo.imageView = DepthBufferView;
+	DepthAttachmentInfo.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+	DepthAttachmentInfo.clearValue = DepthClearValue;
+
+	VkRenderingInfo RenderingInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.renderArea = RenderArea,
+		.layerCount = 1,
+		.viewMask = 0,
+		.colorAttachmentCount = static_cast<uint32_t>(ColorAttachmentsInfos.size()),
+		.pColorAttachments = ColorAttachmentsInfos.data(),
+		.pDepthAttachment = &DepthAttachmentInfo,
+		.pStencilAttachment = nullptr
 	};
 
+	// Deferred shading is recorded inline into the same dynamic render pass, which can't mix inline commands with secondary command buffers.
+	vkCmdBeginRendering(CommandBuffer, &RenderingInfo);
+#else
+	// Result attachment isn't cleared, its clear value is ignored.
+	std::vector<VkClearValue> ClearValues{ GBufferClearValue, GBufferClearValue, GBufferClearValue, DepthClearValue };
+
+	// Only one framebuffer exists unless deferred shading renders directly into swapchain.
+	const auto& SceneFramebuffers = *SceneRenderPass.Framebuffers;
+	const VkFramebuffer SceneFramebuffer = SceneFramebuffers[std::min<size_t>(SwapchainImageIndex, SceneFramebuffers.size() - 1)];
+
 	VkRenderPassBeginInfo BeginRenderPassInfo
 	{
 		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
 		.pNext = nullptr,
-		.renderPass = SceneRenderPass,
-		.framebuffer = GBufferGenerationPassFramebuffer,
-		.renderArea = 
-		{
-			.offset
-			{
-				.x = 0,
-				.y = 0
-			},
-			.extent
-			{
-				.width = 1600,
-				.height = 900
-			}
-		},
+		.renderPass = *SceneRenderPass.RenderPass,
+		.framebuffer = SceneFramebuffer,
+		.renderArea = RenderArea,
 		.clearValueCount = static_cast<uint32_t>(ClearValues.size()),
 		.pClearValues = ClearValues.data(),
 	};
 
-	vkCmdBeginRenderPass(CommandBuffer, &BeginRenderPassInfo, VkSubpassContents::VK_SUBPASS_CONTENTS_INLINE);
+	const bool IsRecordedInParallel = Recorder.ShouldRecordInParallel(Actors.size());
 
-	vkCmdBindPipeline(CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline);
+	vkCmdBeginRenderPass(CommandBuffer, &BeginRenderPassInfo, IsRecordedInParallel ? VkSubpassContents::VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VkSubpassContents::VK_SUBPASS_CONTENTS_INLINE);
+#endif
+
+	// Uniforms are written once, before any worker starts recording.
+	const uint32_t SceneTransformationOffset = FrameUniforms->Write(SceneTransformation);
+
+	const auto RecordActors = [&](VkCommandBuffer TargetCommandBuffer, const uint32_t FirstActor, const uint32_t ActorsCount)
+	{
+		vkCmdBindPipeline(TargetCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline);
+		RecordViewport(TargetCommandBuffer, this->Extent);
 
-	vkCmdBindDescriptorSets(CommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineLayout, 0, 1, DescriptorSets.data(), 0, nullptr);
+		vkCmdBindDescriptorSets(TargetCommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, PipelineLayout, 0, 1, DescriptorSets.data(), 1, &SceneTransformationOffset);
 
-	for (const auto& Actor : Actors)
+		Geometry.Bind(TargetCommandBuffer, true);
+
+		for (uint32_t i = FirstActor; i < FirstActor + ActorsCount; i++)
+		{
+			vkCmdDraw(TargetCommandBuffer, Actors[i].VerticesCount, 1, Actors[i].FirstVertex, 0);
+		}
+	};
+
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	RecordActors(CommandBuffer, 0, static_cast<uint32_t>(Actors.size()));
+
+	// Deferred shading reads G-buffer only at pixel it shades, as it did in second subpass.
+	BarrierRecorder LocalReadBarrier;
+	LocalReadBarrier.AddMemoryBarrier(VkMemoryBarrier2
+	{
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+		.pNext = nullptr,
+		.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+		.srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+		.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+		.dstAccessMask = VK_ACCESS_2_INPUT_ATTACHMENT_READ_BIT
+	});
+	LocalReadBarrier.Flush(CommandBuffer, VK_DEPENDENCY_BY_REGION_BIT);
+#else
+	if (IsRecordedInParallel)
+	{
+		VkCommandBufferInheritanceInfo InheritanceInfo
+		{
+			.sType = VkStructureType::VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+			.pNext = nullptr,
+			.renderPass = *SceneRenderPass.RenderPass,
+			.subpass = 0,
+			.framebuffer = SceneFramebuffer,
+			.occlusionQueryEnable = VK_FALSE,
+			.queryFlags = 0,
+			.pipelineStatistics = 0
+		};
+
+		Recorder.RecordSlices(CommandBuffer, this, InheritanceInfo, static_cast<uint32_t>(Actors.size()), RecordActors);
+	}
+	else
 	{
-		vkCmdBindVertexBuffers(CommandBuffer, 0, 2, Actor.VertexBuffers.data(), Actor.Offsets.data());
-		vkCmdDraw(CommandBuffer, Actor.VerticesCount, 1, 0, 0);
+		RecordActors(CommandBuffer, 0, static_cast<uint32_t>(Actors.size()));
 	}
 
-	vkCmdEndRenderPass(CommandBuffer);
+	vkCmdNextSubpass(CommandBuffer, VkSubpassContents::VK_SUBPASS_CONTENTS_INLINE);
+#endif
 }
\ No newline at end of file
@@ -2,8 +2,16 @@
 
 #include <cstdint>
 #include "RenderPass.hpp"
+#include "DeferredPass.hpp"
 #include <vector>
 #include "Actor.hpp"
+#include "GeometryArena.hpp"
+#include "ParallelCommandRecorder.hpp"
+#include "UniformRingBuffer.hpp"
+
+#include <glm/glm.hpp>
+
+//#define TUTORIAL_VK_TRANSIENT_GBUFFER // Uncomment to back transient G-buffer images with their own lazily allocated memory (when device exposes such memory type) instead of render target heap.
 
 class GBufferGenerationPass : public RenderPass
 {
@@ -13,16 +21,27 @@ private:
 	VkImageView GBufferPositionImageView{};
 	VkImageView GBufferNormalImageView{};
 	VkDeviceMemory GBufferMemory{};
+	VkDeviceSize GBufferMemorySize = 0;
+	bool IsGBufferMemoryLazilyAllocated = false;
 
-	VkFramebuffer GBufferGenerationPassFramebuffer{};
+	VkImage DepthBuffer{};
+	VkImageView DepthBufferView{};
+
+	uint32_t GraphicsQueueIndex = 0;
+	const VkPhysicalDeviceMemoryProperties2* DeviceMemoryProperties = nullptr;
 
 	VkDescriptorSetLayout DeferredPassSetLayout{};
-	VkBuffer SceneTransformationUBO{};
-	VkDeviceMemory SceneTransformationUBOMemory{};
+	UniformRingBuffer* FrameUniforms = nullptr;
+	struct SceneTransformationContent
+	{
+		glm::mat4 ViewMatrix;
+		glm::mat4 ProjectionMatrix;
+	} SceneTransformation{};
 	VkDescriptorPool DeferredPassDescriptorPool{};
 	std::vector<VkDescriptorSet> DescriptorSets;
 
-	VkRenderPass SceneRenderPass{};
+	// G-buffer is generated in first subpass.
+	SceneRenderPassInfo SceneRenderPass{};
 
 	std::vector<VkPipelineShaderStageCreateInfo> ShaderStages;
 	VkShaderModule GBufferGenerationVertexShaderModule{};
@@ -31,15 +50,39 @@ private:
 	VkPipelineLayout PipelineLayout{};
 	VkPipeline Pipeline{};
 public:
-	GBufferGenerationPass(VkDevice Device, const uint32_t GraphicsQueueIndex, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties, VkImageView DepthBuffer);
+	GBufferGenerationPass(VkDevice Device, const uint32_t GraphicsQueueIndex, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties, UniformRingBuffer& FrameUniforms);
 
 	virtual void FreeGPUResources() override;
 
-	void RecordCommandBuffer(VkCommandBuffer CommandBuffer, const std::vector<SceneActor>& Actors);
+	// Must be called before pipeline is set up.
+	void SetSceneRenderPass(const SceneRenderPassInfo& SceneRenderPass);
+
+	virtual void DeclareRenderTargets(RenderTargetHeap& Heap) override;
+
+	virtual void SetupRenderTargets() override;
+
+	virtual void FreeRenderTargets() override;
+
+	virtual void DeclareGraphUsage(RenderGraph& Graph, const uint32_t GraphPass) override;
+
+	virtual void UpdateGraphImages(RenderGraph& Graph) override;
+
+	// Prints how much of G-buffer memory is really committed by device. Meaningful after G-buffer has been rendered at least once.
+	void ReportGBufferMemory() const;
+
+	// Camera data is written into frame uniforms during every recording.
+	void SetCamera(const glm::mat4& ViewMatrix, const glm::mat4& ProjectionMatrix);
+
+	// Aspect ratio of camera projection follows extent.
+	virtual void SetExtent(const VkExtent2D& Extent) override;
+
+	// Begins scene render pass and leaves it in deferred shading subpass. Swapchain image index selects framebuffer when rendering directly into swapchain.
+	// Large scenes are recorded in parallel into secondary command buffers.
+	void RecordCommandBuffer(VkCommandBuffer CommandBuffer, const uint32_t SwapchainImageIndex, const GeometryArena& Geometry, const std::vector<SceneActor>& Actors, ParallelCommandRecorder& Recorder);
 
-	virtual void SetupShaders() override;
+	virtual void SetupShaders(ShaderArchive& Shaders) override;
 
-	virtual void SetupPipeline() override;
+	virtual void SetupPipeline(VkPipelineCache PipelineCache) override;
 
 	virtual ~GBufferGenerationPass() = default;
 
@@ -47,5 +90,6 @@ public:
 	{
 		VkImageView* GBufferPositionImageViewLink = nullptr;
 		VkImageView* GBufferNormalImageViewLink = nullptr;
+		VkImageView* DepthBufferViewLink = nullptr;
 	} SharedResources;
 };
\ No newline at end of file
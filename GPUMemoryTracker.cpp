@@ -0,0 +1,306 @@
+#include "GPUMemoryTracker.hpp"
+#include "Helpers.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+GPUMemoryTracker GPUMemory;
+
+void GPUMemoryTracker::SetDeviceMemoryProperties(const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties)
+{
+	this->DeviceMemoryProperties = &DeviceMemoryProperties;
+}
+
+VkResult GPUMemoryTracker::AllocateMemory(VkDevice Device, const VkMemoryAllocateInfo& AllocationInfo, VkDeviceMemory& Memory, const std::string& Owner, const std::string& Purpose)
+{
+	std::lock_guard<std::mutex> Lock(this->Mutex);
+
+	const VkResult Result = vkAllocateMemory(Device, &AllocationInfo, nullptr, &Memory);
+
+	if (Result == VK_SUCCESS)
+	{
+		this->Allocations[Memory] = TrackedAllocation
+		{
+			.Owner = Owner,
+			.Purpose = Purpose,
+			.MemoryTypeIndex = AllocationInfo.memoryTypeIndex,
+			.Size = AllocationInfo.allocationSize,
+			.BoundSize = 0
+		};
+	}
+	else
+	{
+		std::cerr << "Failed to allocate " << AllocationInfo.allocationSize / 1024 << "KB for " << Owner << " (" << Purpose << ")." << std::endl;
+	}
+
+	return Result;
+}
+
+void GPUMemoryTracker::FreeMemory(VkDevice Device, VkDeviceMemory Memory)
+{
+	std::lock_guard<std::mutex> Lock(this->Mutex);
+
+	if (Memory == VK_NULL_HANDLE)
+		return;
+
+	this->Allocations.erase(Memory);
+
+	vkFreeMemory(Device, Memory, nullptr);
+}
+
+VkResult GPUMemoryTracker::CreateBuffer(VkDevice Device, const VkBufferCreateInfo& CreationInfo, VkBuffer& Buffer, const std::string& Owner, const std::string& Purpose)
+{
+	std::lock_guard<std::mutex> Lock(this->Mutex);
+
+	const VkResult Result = vkCreateBuffer(Device, &CreationInfo, nullptr, &Buffer);
+
+	if (Result == VK_SUCCESS)
+	{
+		VkMemoryRequirements MemoryRequirements{};
+		vkGetBufferMemoryRequirements(Device, Buffer, &MemoryRequirements);
+
+		this->Buffers[Buffer] = TrackedResource
+		{
+			.Owner = Owner,
+			.Purpose = Purpose,
+			.Size = MemoryRequirements.size,
+			.BoundMemory = VK_NULL_HANDLE
+		};
+	}
+
+	return Result;
+}
+
+void GPUMemoryTracker::DestroyBuffer(VkDevice Device, VkBuffer Buffer)
+{
+	std::lock_guard<std::mutex> Lock(this->Mutex);
+
+	if (Buffer == VK_NULL_HANDLE)
+		return;
+
+	const auto TrackedBuffer = this->Buffers.find(Buffer);
+	if (TrackedBuffer != this->Buffers.end())
+	{
+		UnbindResource(TrackedBuffer->second);
+		this->Buffers.erase(TrackedBuffer);
+	}
+
+	vkDestroyBuffer(Device, Buffer, nullptr);
+}
+
+VkResult GPUMemoryTracker::CreateImage(VkDevice Device, const VkImageCreateInfo& CreationInfo, VkImage& Image, const std::string& Owner, const std::string& Purpose)
+{
+	std::lock_guard<std::mutex> Lock(this->Mutex);
+
+	const VkResult Result = vkCreateImage(Device, &CreationInfo, nullptr, &Image);
+
+	if (Result == VK_SUCCESS)
+	{
+		VkMemoryRequirements MemoryRequirements{};
+		vkGetImageMemoryRequirements(Device, Image, &MemoryRequirements);
+
+		this->Images[Image] = TrackedResource
+		{
+			.Owner = Owner,
+			.Purpose = Purpose,
+			.Size = MemoryRequirements.size,
+			.BoundMemory = VK_NULL_HANDLE
+		};
+	}
+
+	return Result;
+}
+
+void GPUMemoryTracker::DestroyImage(VkDevice Device, VkImage Image)
+{
+	std::lock_guard<std::mutex> Lock(this->Mutex);
+
+	if (Image == VK_NULL_HANDLE)
+		return;
+
+	const auto TrackedImage = this->Images.find(Image);
+	if (TrackedImage != this->Images.end())
+	{
+		UnbindResource(TrackedImage->second);
+		this->Images.erase(TrackedImage);
+	}
+
+	vkDestroyImage(Device, Image, nullptr);
+}
+
+VkResult GPUMemoryTracker::BindBufferMemory(VkDevice Device, VkBuffer Buffer, VkDeviceMemory Memory, VkDeviceSize Offset)
+{
+	std::lock_guard<std::mutex> Lock(this->Mutex);
+
+	const auto TrackedBuffer = this->Buffers.find(Buffer);
+	if (TrackedBuffer != this->Buffers.end())
+	{
+		BindResource(TrackedBuffer->second, Memory);
+	}
+
+	return vkBindBufferMemory(Device, Buffer, Memory, Offset);
+}
+
+VkResult GPUMemoryTracker::BindImageMemory(VkDevice Device, VkImage Image, VkDeviceMemory Memory, VkDeviceSize Offset)
+{
+	std::lock_guard<std::mutex> Lock(this->Mutex);
+
+	const auto TrackedImage = this->Images.find(Image);
+	if (TrackedImage != this->Images.end())
+	{
+		BindResource(TrackedImage->second, Memory);
+	}
+
+	return vkBindImageMemory(Device, Image, Memory, Offset);
+}
+
+void GPUMemoryTracker::BindResource(TrackedResource& Resource, VkDeviceMemory Memory)
+{
+	Resource.BoundMemory = Memory;
+
+	const auto Allocation = this->Allocations.find(Memory);
+	if (Allocation != this->Allocations.end())
+	{
+		Allocation->second.BoundSize += Resource.Size;
+	}
+}
+
+void GPUMemoryTracker::UnbindResource(const TrackedResource& Resource)
+{
+	const auto Allocation = this->Allocations.find(Resource.BoundMemory);
+	if (Allocation != this->Allocations.end())
+	{
+		Allocation->second.BoundSize -= std::min(Allocation->second.BoundSize, Resource.Size);
+	}
+}
+
+GPUMemoryTracker::MemoryStatistics GPUMemoryTracker::ComputeStatistics() const
+{
+	MemoryStatistics Statistics;
+
+	for (const auto& [Memory, Allocation] : this->Allocations)
+	{
+		const uint32_t HeapIndex = this->DeviceMemoryProperties ? this->DeviceMemoryProperties->memoryProperties.memoryTypes[Allocation.MemoryTypeIndex].heapIndex : 0;
+
+		Statistics.AllocatedSizePerHeap[HeapIndex] += Allocation.Size;
+		Statistics.AllocatedSize += Allocation.Size;
+		Statistics.UnboundSize += Allocation.Size - std::min(Allocation.Size, Allocation.BoundSize);
+
+		auto& Owner = Statistics.Owners[Allocation.Owner];
+		Owner.AllocatedSize += Allocation.Size;
+		Owner.AllocationsCount++;
+	}
+
+	for (const auto& [Buffer, Resource] : this->Buffers)
+	{
+		Statistics.Owners[Resource.Owner].BuffersCount++;
+	}
+
+	for (const auto& [Image, Resource] : this->Images)
+	{
+		Statistics.Owners[Resource.Owner].ImagesCount++;
+	}
+
+	if (Statistics.AllocatedSize)
+	{
+		Statistics.Fragmentation = static_cast<float>(Statistics.UnboundSize) / static_cast<float>(Statistics.AllocatedSize);
+	}
+
+	return Statistics;
+}
+
+void GPUMemoryTracker::PrintSummary() const
+{
+	std::lock_guard<std::mutex> Lock(this->Mutex);
+
+	const auto Statistics = ComputeStatistics();
+
+	std::cout << "GPU memory: " << Statistics.AllocatedSize / 1024 / 1024 << "MB in " << this->Allocations.size() << " allocations, " << this->Buffers.size() << " buffers, " << this->Images.size() << " images." << std::endl;
+
+	for (const auto& [HeapIndex, AllocatedSize] : Statistics.AllocatedSizePerHeap)
+	{
+		std::cout << "\tHeap " << HeapIndex << ": " << AllocatedSize / 1024 / 1024 << "MB" << std::endl;
+	}
+
+	for (const auto& [Name, Owner] : Statistics.Owners)
+	{
+		std::cout << "\t" << Name << ": " << Owner.AllocatedSize / 1024 << "KB in " << Owner.AllocationsCount << " allocations, " << Owner.BuffersCount << " buffers, " << Owner.ImagesCount << " images" << std::endl;
+	}
+
+	std::cout << "\tFragmentation: " << Statistics.Fragmentation * 100.0f << "% (" << Statistics.UnboundSize / 1024 << "KB not bound to any resource)" << std::endl;
+}
+
+void GPUMemoryTracker::DumpJSON(const std::string& FilePath) const
+{
+	std::lock_guard<std::mutex> Lock(this->Mutex);
+
+	const auto Statistics = ComputeStatistics();
+
+	std::ofstream File(FilePath);
+
+	File << "{\n";
+	File << "\t\"allocatedBytes\": " << Statistics.AllocatedSize << ",\n";
+	File << "\t\"unboundBytes\": " << Statistics.UnboundSize << ",\n";
+	File << "\t\"fragmentation\": " << Statistics.Fragmentation << ",\n";
+
+	File << "\t\"heaps\": [";
+	bool IsFirst = true;
+	for (const auto& [HeapIndex, AllocatedSize] : Statistics.AllocatedSizePerHeap)
+	{
+		File << (IsFirst ? "\n" : ",\n") << "\t\t{ \"heap\": " << HeapIndex << ", \"allocatedBytes\": " << AllocatedSize << " }";
+		IsFirst = false;
+	}
+	File << "\n\t],\n";
+
+	File << "\t\"owners\": [";
+	IsFirst = true;
+	for (const auto& [Name, Owner] : Statistics.Owners)
+	{
+		File << (IsFirst ? "\n" : ",\n") << "\t\t{ \"owner\": \"" << EscapeJSON(Name) << "\", \"allocatedBytes\": " << Owner.AllocatedSize << ", \"allocations\": " << Owner.AllocationsCount << ", \"buffers\": " << Owner.BuffersCount << ", \"images\": " << Owner.ImagesCount << " }";
+		IsFirst = false;
+	}
+	File << "\n\t],\n";
+
+	File << "\t\"allocations\": [";
+	IsFirst = true;
+	for (const auto& [Memory, Allocation] : this->Allocations)
+	{
+		File << (IsFirst ? "\n" : ",\n") << "\t\t{ \"owner\": \"" << EscapeJSON(Allocation.Owner) << "\", \"purpose\": \"" << EscapeJSON(Allocation.Purpose) << "\", \"memoryType\": " << Allocation.MemoryTypeIndex << ", \"bytes\": " << Allocation.Size << ", \"boundBytes\": " << Allocation.BoundSize << " }";
+		IsFirst = false;
+	}
+	File << "\n\t]\n";
+	File << "}\n";
+
+	std::cout << "GPU memory statistics written into " << FilePath << "." << std::endl;
+}
+
+bool GPUMemoryTracker::ReportLeaks() const
+{
+	std::lock_guard<std::mutex> Lock(this->Mutex);
+
+	if (this->Allocations.empty() && this->Buffers.empty() && this->Images.empty())
+	{
+		std::cout << "No GPU memory leaks detected." << std::endl;
+		return true;
+	}
+
+	std::cerr << "GPU memory leaks detected:" << std::endl;
+
+	for (const auto& [Memory, Allocation] : this->Allocations)
+	{
+		std::cerr << "\tMemory: " << Allocation.Owner << " (" << Allocation.Purpose << "), " << Allocation.Size / 1024 << "KB" << std::endl;
+	}
+
+	for (const auto& [Buffer, Resource] : this->Buffers)
+	{
+		std::cerr << "\tBuffer: " << Resource.Owner << " (" << Resource.Purpose << "), " << Resource.Size / 1024 << "KB" << std::endl;
+	}
+
+	for (const auto& [Image, Resource] : this->Images)
+	{
+		std::cerr << "\tImage: " << Resource.Owner << " (" << Resource.Purpose << "), " << Resource.Size / 1024 << "KB" << std::endl;
+	}
+
+	return false;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+
+// Wrappers over Vulkan allocation entry points. Every memory allocation, buffer and image created through them
+// is tagged with owner (pass, actor, etc.) and purpose, so memory usage can be summarized and leaks reported.
+class GPUMemoryTracker
+{
+private:
+	// Resources are created by startup tasks running on several threads.
+	mutable std::mutex Mutex;
+
+	const VkPhysicalDeviceMemoryProperties2* DeviceMemoryProperties = nullptr;
+
+	struct TrackedAllocation
+	{
+		std::string Owner;
+		std::string Purpose;
+		uint32_t MemoryTypeIndex;
+		VkDeviceSize Size;
+		VkDeviceSize BoundSize; // May exceed Size when resources alias the same memory.
+	};
+	std::unordered_map<VkDeviceMemory, TrackedAllocation> Allocations;
+
+	struct TrackedResource
+	{
+		std::string Owner;
+		std::string Purpose;
+		VkDeviceSize Size;
+		VkDeviceMemory BoundMemory;
+	};
+	std::unordered_map<VkBuffer, TrackedResource> Buffers;
+	std::unordered_map<VkImage, TrackedResource> Images;
+
+	struct OwnerStatistics
+	{
+		VkDeviceSize AllocatedSize = 0;
+		uint32_t AllocationsCount = 0;
+		uint32_t BuffersCount = 0;
+		uint32_t ImagesCount = 0;
+	};
+
+	struct MemoryStatistics
+	{
+		std::map<uint32_t, VkDeviceSize> AllocatedSizePerHeap;
+		std::map<std::string, OwnerStatistics> Owners;
+		VkDeviceSize AllocatedSize = 0;
+		VkDeviceSize UnboundSize = 0;
+		float Fragmentation = 0.0f;
+	};
+
+	MemoryStatistics ComputeStatistics() const;
+
+	void BindResource(TrackedResource& Resource, VkDeviceMemory Memory);
+	void UnbindResource(const TrackedResource& Resource);
+
+public:
+	GPUMemoryTracker() = default;
+
+	void SetDeviceMemoryProperties(const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties);
+
+	VkResult AllocateMemory(VkDevice Device, const VkMemoryAllocateInfo& AllocationInfo, VkDeviceMemory& Memory, const std::string& Owner, const std::string& Purpose);
+	void FreeMemory(VkDevice Device, VkDeviceMemory Memory);
+
+	VkResult CreateBuffer(VkDevice Device, const VkBufferCreateInfo& CreationInfo, VkBuffer& Buffer, const std::string& Owner, const std::string& Purpose);
+	void DestroyBuffer(VkDevice Device, VkBuffer Buffer);
+
+	VkResult CreateImage(VkDevice Device, const VkImageCreateInfo& CreationInfo, VkImage& Image, const std::string& Owner, const std::string& Purpose);
+	void DestroyImage(VkDevice Device, VkImage Image);
+
+	VkResult BindBufferMemory(VkDevice Device, VkBuffer Buffer, VkDeviceMemory Memory, VkDeviceSize Offset);
+	VkResult BindImageMemory(VkDevice Device, VkImage Image, VkDeviceMemory Memory, VkDeviceSize Offset);
+
+	// Prints bytes per heap and per owner, allocation counts and fragmentation (memory allocated but not bound to any resource).
+	void PrintSummary() const;
+
+	void DumpJSON(const std::string& FilePath) const;
+
+	// Prints every allocation, buffer and image which hasn't been released yet. Returns true when nothing leaked.
+	bool ReportLeaks() const;
+
+	~GPUMemoryTracker() = default;
+};
+
+extern GPUMemoryTracker GPUMemory;
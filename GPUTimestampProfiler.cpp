@@ -0,0 +1,125 @@
+#include "GPUTimestampProfiler.hpp"
+
+#include <iostream>
+
+// Every zone has begin and end timestamp.
+GPUTimestampProfiler::GPUTimestampProfiler(VkDevice Device, const VkPhysicalDeviceLimits& DeviceLimits, const uint32_t TimestampValidBits, const uint32_t FramesInFlight)
+	: QueryProfiler(Device, TimestampValidBits > 0, VkQueryType::VK_QUERY_TYPE_TIMESTAMP, 0, 2, FramesInFlight)
+{
+	this->TimestampPeriodInMs = DeviceLimits.timestampPeriod / 1000000.0;
+	this->TimestampValidBits = TimestampValidBits;
+
+	if (!this->IsSupported)
+	{
+		std::cerr << "Graphics queue doesn't support timestamps, GPU pass times won't be measured." << std::endl;
+	}
+}
+
+uint32_t GPUTimestampProfiler::RegisterZone(const std::string& Name)
+{
+	return RegisterZone(Name, this->TimestampValidBits);
+}
+
+uint32_t GPUTimestampProfiler::RegisterZone(const std::string& Name, const uint32_t QueueTimestampValidBits)
+{
+	const uint32_t Zone = AddZone(Name);
+	if (Zone == MaxZonesCount)
+		return Zone;
+
+	if (!QueueTimestampValidBits)
+	{
+		std::cerr << "Queue of GPU profiler zone " << Name << " doesn't support timestamps, zone won't be measured." << std::endl;
+	}
+
+	this->ZonesTimestampMasks.push_back(QueueTimestampValidBits >= 64 ? UINT64_MAX : (uint64_t(1) << QueueTimestampValidBits) - 1);
+	this->LastTimings.push_back(-1.0);
+	this->ZonesHistory.emplace_back(AveragedFramesCount, -1.0);
+
+	return Zone;
+}
+
+void GPUTimestampProfiler::RecordZoneBegin(VkCommandBuffer CommandBuffer, const uint32_t FrameSlot, const uint32_t Zone) const
+{
+	if (!CanRecordZone(Zone) || !this->ZonesTimestampMasks[Zone])
+		return;
+
+	vkCmdWriteTimestamp2(CommandBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, this->QueryPool, GetFirstQuery(FrameSlot, Zone));
+}
+
+void GPUTimestampProfiler::RecordZoneEnd(VkCommandBuffer CommandBuffer, const uint32_t FrameSlot, const uint32_t Zone) const
+{
+	if (!CanRecordZone(Zone) || !this->ZonesTimestampMasks[Zone])
+		return;
+
+	vkCmdWriteTimestamp2(CommandBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, this->QueryPool, GetFirstQuery(FrameSlot, Zone) + 1);
+}
+
+bool GPUTimestampProfiler::ReadFrame(const uint32_t FrameSlot)
+{
+	struct QueryResult
+	{
+		uint64_t Timestamp;
+		uint64_t Availability;
+	};
+	std::vector<QueryResult> Results(this->ZonesNames.size() * this->QueriesPerZone);
+
+	if (!ReadQueryResults(FrameSlot, Results.data(), sizeof(QueryResult)))
+		return false;
+
+	for (size_t Zone = 0; Zone < this->ZonesNames.size(); Zone++)
+	{
+		const auto& Begin = Results[Zone * 2];
+		const auto& End = Results[Zone * 2 + 1];
+
+		if (Begin.Availability && End.Availability)
+		{
+			const uint64_t TimestampMask = this->ZonesTimestampMasks[Zone];
+			const uint64_t Ticks = ((End.Timestamp & TimestampMask) - (Begin.Timestamp & TimestampMask)) & TimestampMask;
+			this->LastTimings[Zone] = Ticks * this->TimestampPeriodInMs;
+		}
+		else
+		{
+			this->LastTimings[Zone] = -1.0;
+		}
+
+		this->ZonesHistory[Zone][this->HistoryCursor] = this->LastTimings[Zone];
+	}
+	this->HistoryCursor = (this->HistoryCursor + 1) % AveragedFramesCount;
+
+	return true;
+}
+
+double GPUTimestampProfiler::GetLastTiming(const uint32_t Zone) const
+{
+	return this->LastTimings[Zone];
+}
+
+double GPUTimestampProfiler::GetRollingAverage(const uint32_t Zone) const
+{
+	double SummedTimings = 0.0;
+	uint32_t TimingsCount = 0;
+
+	for (const double Timing : this->ZonesHistory[Zone])
+	{
+		if (Timing < 0.0)
+			continue;
+
+		SummedTimings += Timing;
+		TimingsCount++;
+	}
+
+	return TimingsCount ? SummedTimings / TimingsCount : 0.0;
+}
+
+void GPUTimestampProfiler::PrintAverages() const
+{
+	if (!this->IsSupported)
+		return;
+
+	std::cout << "GPU pass times (average of last " << AveragedFramesCount << " frames):" << std::endl;
+
+	for (uint32_t Zone = 0; Zone < GetZonesCount(); Zone++)
+	{
+		std::cout << "\t" << this->ZonesNames[Zone] << ": " << GetRollingAverage(Zone) << "ms" << std::endl;
+	}
+}
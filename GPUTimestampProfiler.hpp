@@ -0,0 +1,41 @@
+#pragma once
+#include "QueryProfiler.hpp"
+
+// Measures GPU time of named zones (passes) with timestamp queries.
+class GPUTimestampProfiler : public QueryProfiler
+{
+private:
+	double TimestampPeriodInMs = 0.0;
+	uint32_t TimestampValidBits = 0; // Of graphics queue family.
+
+	std::vector<uint64_t> ZonesTimestampMasks; // Zero for zones recorded on queue without timestamps.
+
+	std::vector<double> LastTimings; // Negative for zones which weren't measured.
+	std::vector<std::vector<double>> ZonesHistory; // Last timings of every zone, used as ring buffer.
+
+public:
+	GPUTimestampProfiler(VkDevice Device, const VkPhysicalDeviceLimits& DeviceLimits, const uint32_t TimestampValidBits, const uint32_t FramesInFlight);
+
+	// Returns zone index passed while recording.
+	uint32_t RegisterZone(const std::string& Name);
+
+	// Zone recorded on queue of other family than graphics one, which may have different timestamp valid bits.
+	// Zone is never measured when that family doesn't support timestamps.
+	uint32_t RegisterZone(const std::string& Name, const uint32_t QueueTimestampValidBits);
+
+	// Timestamps are written once all previous commands complete, so overlapping passes are attributed to the one finishing them.
+	void RecordZoneBegin(VkCommandBuffer CommandBuffer, const uint32_t FrameSlot, const uint32_t Zone) const;
+	void RecordZoneEnd(VkCommandBuffer CommandBuffer, const uint32_t FrameSlot, const uint32_t Zone) const;
+
+	// Reads timings of last frame submitted in slot, which must have finished on GPU. Returns false when there was nothing to read.
+	bool ReadFrame(const uint32_t FrameSlot);
+
+	// Timing of zone in last frame read back, negative when zone wasn't measured.
+	double GetLastTiming(const uint32_t Zone) const;
+
+	double GetRollingAverage(const uint32_t Zone) const;
+
+	void PrintAverages() const;
+
+	virtual ~GPUTimestampProfiler() = default;
+};
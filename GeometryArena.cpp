@@ -0,0 +1,184 @@
+#include "GeometryArena.hpp"
+#include "Helpers.hpp"
+#include "GPUMemoryTracker.hpp"
+#include "CPUProfiler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+GeometryArena::GeometryArena(VkDevice Device, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties, const uint32_t VerticesCapacity)
+{
+	this->Device = Device;
+	this->VerticesCapacity = (std::max)(VerticesCapacity, 1u); // Vulkan doesn't allow empty buffers.
+
+	// Setup buffers.
+	{
+		VkBufferCreateInfo CreationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.size = VertexAttributeStride * this->VerticesCapacity,
+			.usage = VkBufferUsageFlagBits::VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
+			.queueFamilyIndexCount = 0,
+			.pQueueFamilyIndices = nullptr
+		};
+
+		GPUMemory.CreateBuffer(Device, CreationInfo, this->PositionBuffer, "GeometryArena", "Vertex positions");
+		GPUMemory.CreateBuffer(Device, CreationInfo, this->NormalBuffer, "GeometryArena", "Vertex normals");
+	}
+
+	// Allocate memory for buffers.
+	{
+		VkMemoryRequirements MemoryRequirements;
+		vkGetBufferMemoryRequirements(Device, this->PositionBuffer, &MemoryRequirements);
+
+		this->NormalBufferOffset = AlignUp(MemoryRequirements.size, MemoryRequirements.alignment);
+
+		const uint32_t MemoryTypeIndex = QueryMemoryTypeIndex(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, MemoryRequirements.memoryTypeBits, DeviceMemoryProperties);
+		this->IsMemoryCoherent = DeviceMemoryProperties.memoryProperties.memoryTypes[MemoryTypeIndex].propertyFlags & VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		VkMemoryAllocateInfo AllocationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+			.pNext = nullptr,
+			.allocationSize = this->NormalBufferOffset + MemoryRequirements.size,
+			.memoryTypeIndex = MemoryTypeIndex
+		};
+
+		GPUMemory.AllocateMemory(Device, AllocationInfo, this->BuffersMemory, "GeometryArena", "Scene geometry");
+
+		GPUMemory.BindBufferMemory(Device, this->PositionBuffer, this->BuffersMemory, 0);
+		GPUMemory.BindBufferMemory(Device, this->NormalBuffer, this->BuffersMemory, this->NormalBufferOffset);
+	}
+
+	// Map memory for whole its lifetime.
+	{
+		void* MappedMemory = nullptr;
+		vkMapMemory(Device, this->BuffersMemory, 0, VK_WHOLE_SIZE, 0, &MappedMemory);
+
+		this->MappedAddress = reinterpret_cast<char*>(MappedMemory);
+	}
+
+	this->FreeRanges[0] = this->VerticesCapacity;
+}
+
+void GeometryArena::FreeGPUResources()
+{
+	vkUnmapMemory(Device, this->BuffersMemory);
+
+	GPUMemory.DestroyBuffer(Device, this->PositionBuffer);
+	GPUMemory.DestroyBuffer(Device, this->NormalBuffer);
+	GPUMemory.FreeMemory(Device, this->BuffersMemory);
+}
+
+bool GeometryArena::Allocate(const uint32_t VerticesCount, uint32_t& FirstVertex)
+{
+	for (auto Range = this->FreeRanges.begin(); Range != this->FreeRanges.end(); Range++)
+	{
+		if (Range->second < VerticesCount)
+			continue;
+
+		FirstVertex = Range->first;
+
+		const uint32_t RemainingVertices = Range->second - VerticesCount;
+		this->FreeRanges.erase(Range);
+
+		if (RemainingVertices)
+		{
+			this->FreeRanges[FirstVertex + VerticesCount] = RemainingVertices;
+		}
+
+		return true;
+	}
+
+	std::cerr << "Geometry arena has no free range for " << VerticesCount << " vertices." << std::endl;
+	return false;
+}
+
+void GeometryArena::Release(const uint32_t FirstVertex, const uint32_t VerticesCount)
+{
+	auto Range = this->FreeRanges.emplace(FirstVertex, VerticesCount).first;
+
+	// Coalesce with following range.
+	const auto NextRange = std::next(Range);
+	if (NextRange != this->FreeRanges.end() && Range->first + Range->second == NextRange->first)
+	{
+		Range->second += NextRange->second;
+		this->FreeRanges.erase(NextRange);
+	}
+
+	// Coalesce with preceding range.
+	if (Range != this->FreeRanges.begin())
+	{
+		const auto PreviousRange = std::prev(Range);
+		if (PreviousRange->first + PreviousRange->second == Range->first)
+		{
+			PreviousRange->second += Range->second;
+			this->FreeRanges.erase(Range);
+		}
+	}
+}
+
+void GeometryArena::Free(const uint32_t FirstVertex, const uint32_t VerticesCount, const uint64_t TimelineValue)
+{
+	this->PendingRanges.push_back({ FirstVertex, VerticesCount, TimelineValue });
+}
+
+void GeometryArena::ReleaseCompletedRanges(const uint64_t CompletedTimelineValue)
+{
+	std::erase_if(this->PendingRanges, [&](const PendingRange& Range)
+	{
+		if (Range.TimelineValue > CompletedTimelineValue)
+			return false;
+
+		Release(Range.FirstVertex, Range.VerticesCount);
+		return true;
+	});
+}
+
+void GeometryArena::Upload(const uint32_t FirstVertex, const uint32_t VerticesCount, const void* Positions, const void* Normals)
+{
+	TUTORIAL_VK_PROFILE_ZONE("GeometryArena::Upload");
+
+	const VkDeviceSize Offset = FirstVertex * VertexAttributeStride;
+	const VkDeviceSize Size = VerticesCount * VertexAttributeStride;
+
+	std::memcpy(this->MappedAddress + Offset, Positions, Size);
+	std::memcpy(this->MappedAddress + this->NormalBufferOffset + Offset, Normals, Size);
+
+	if (!this->IsMemoryCoherent)
+	{
+		VkMappedMemoryRange RangeInfo
+		{
+			.sType = VkStructureType::VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+			.pNext = nullptr,
+			.memory = this->BuffersMemory,
+			.offset = 0,
+			.size = VK_WHOLE_SIZE
+		};
+
+		vkFlushMappedMemoryRanges(Device, 1, &RangeInfo);
+	}
+}
+
+void GeometryArena::Bind(VkCommandBuffer CommandBuffer, const bool BindNormals) const
+{
+	const VkBuffer Buffers[] = { this->PositionBuffer, this->NormalBuffer };
+	const VkDeviceSize Offsets[] = { 0, 0 };
+
+	vkCmdBindVertexBuffers(CommandBuffer, 0, BindNormals ? 2 : 1, Buffers, Offsets);
+}
+
+uint32_t GeometryArena::GetFreeVerticesCount() const
+{
+	uint32_t FreeVertices = 0;
+	for (const auto& [FirstVertex, VerticesCount] : this->FreeRanges)
+	{
+		FreeVertices += VerticesCount;
+	}
+	return FreeVertices;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Vertex data of all actors packed into shared position and normal buffers living in one persistently mapped memory.
+// Actors are ranges of vertices within these buffers, so vertex buffers are bound once per pass.
+// Ranges are suballocated from first fitting free range and coalesced with neighbours when released.
+class GeometryArena
+{
+private:
+	VkDevice Device{};
+
+	VkBuffer PositionBuffer{};
+	VkBuffer NormalBuffer{};
+	VkDeviceMemory BuffersMemory{};
+	VkDeviceSize NormalBufferOffset = 0;
+	char* MappedAddress = nullptr;
+	bool IsMemoryCoherent = false;
+
+	uint32_t VerticesCapacity = 0;
+	std::map<uint32_t, uint32_t> FreeRanges; // First vertex and vertices count of every free range.
+
+	struct PendingRange
+	{
+		uint32_t FirstVertex;
+		uint32_t VerticesCount;
+		uint64_t TimelineValue; // Range may still be read by GPU until graphics timeline reaches this value.
+	};
+	std::vector<PendingRange> PendingRanges;
+
+	void Release(const uint32_t FirstVertex, const uint32_t VerticesCount);
+
+public:
+	// Position and normal are both three floats.
+	static constexpr VkDeviceSize VertexAttributeStride = 3 * sizeof(float);
+
+	GeometryArena(VkDevice Device, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties, const uint32_t VerticesCapacity);
+
+	void FreeGPUResources();
+
+	// Returns false when there is no free range big enough.
+	bool Allocate(const uint32_t VerticesCount, uint32_t& FirstVertex);
+
+	// Range becomes free only after graphics timeline reaches given value, so frames in flight can still draw it.
+	void Free(const uint32_t FirstVertex, const uint32_t VerticesCount, const uint64_t TimelineValue);
+
+	// Moves ranges no longer used by GPU into free ranges.
+	void ReleaseCompletedRanges(const uint64_t CompletedTimelineValue);
+
+	// Copies vertex attributes into allocated range. Range must not be in use by GPU.
+	void Upload(const uint32_t FirstVertex, const uint32_t VerticesCount, const void* Positions, const void* Normals);
+
+	// Binds position buffer at binding 0 and, when requested, normal buffer at binding 1.
+	void Bind(VkCommandBuffer CommandBuffer, const bool BindNormals) const;
+
+	// Counts only released ranges, not ones waiting for GPU.
+	uint32_t GetFreeVerticesCount() const;
+
+	~GeometryArena() = default;
+};
@@ -18,31 +18,19 @@ static uint32_t QueryMemoryTypeIndex(VkMemoryPropertyFlagBits PreferredMemoryTyp
 	return 0;
 }
 
-static VkShaderModule CreateShaderModule(VkDevice Device, const std::string& ShaderFilePath)
+// Unlike QueryMemoryTypeIndex, requires all of given property flags and reports whether such memory type exists.
+static bool FindMemoryTypeIndex(VkMemoryPropertyFlags RequiredProperties, uint32_t RequiredMemoryTypes, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryInfo, uint32_t& MemoryTypeIndex)
 {
-	std::vector<char> ShaderCodeBytes(std::filesystem::file_size(ShaderFilePath), 0);
-	// Load file content.
+	for (uint32_t i = 0; i < DeviceMemoryInfo.memoryProperties.memoryTypeCount; i++)
 	{
-		std::ifstream ShaderFile(ShaderFilePath, std::ios::binary);
-
-		ShaderFile.read(ShaderCodeBytes.data(), ShaderCodeBytes.size());
+		if ((RequiredMemoryTypes & (1 << i)) && (DeviceMemoryInfo.memoryProperties.memoryTypes[i].propertyFlags & RequiredProperties) == RequiredProperties)
+		{
+			MemoryTypeIndex = i;
+			return true;
+		}
 	}
 
-	// Create Vulkan shader module.
-	VkShaderModule ShaderModule{};
-
-	VkShaderModuleCreateInfo CreationInfo
-	{
-		.sType = VkStructureType::VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = 0,
-		.codeSize = ShaderCodeBytes.size(),
-		.pCode = reinterpret_cast<const uint32_t*>(ShaderCodeBytes.data())
-	};
-
-	vkCreateShaderModule(Device, &CreationInfo, nullptr, &ShaderModule);
-
-	return ShaderModule;
+	return false;
 }
 
 struct RequiredMemory
@@ -63,4 +51,50 @@ static RequiredMemory ComputeMemorySegments(VkMemoryRequirements Requirements)
 		.SegmentSize = Requirements.alignment,
 		.SegmentsCount = RequiredSegments
 	};
+}
+
+static VkDeviceSize AlignUp(const VkDeviceSize Value, const VkDeviceSize Alignment)
+{
+	return (Value + Alignment - 1) / Alignment * Alignment;
+}
+
+// Escapes text written into JSON string, including control characters.
+static std::string EscapeJSON(const std::string& Text)
+{
+	constexpr char HexDigits[] = "0123456789abcdef";
+
+	std::string Escaped;
+	for (const char Character : Text)
+	{
+		switch (Character)
+		{
+		case '"':
+			Escaped += "\\\"";
+			break;
+		case '\\':
+			Escaped += "\\\\";
+			break;
+		case '\n':
+			Escaped += "\\n";
+			break;
+		case '\r':
+			Escaped += "\\r";
+			break;
+		case '\t':
+			Escaped += "\\t";
+			break;
+		default:
+			if (static_cast<unsigned char>(Character) < 0x20)
+			{
+				Escaped += "\\u00";
+				Escaped += HexDigits[Character >> 4];
+				Escaped += HexDigits[Character & 0xF];
+			}
+			else
+			{
+				Escaped += Character;
+			}
+		}
+	}
+	return Escaped;
 }
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "ParallelCommandRecorder.hpp"
+#include "CPUProfiler.hpp"
+
+#include <algorithm>
+
+ParallelCommandRecorder::ParallelCommandRecorder(VkDevice Device, const uint32_t GraphicsQueueIndex, const uint32_t WorkersCount)
+{
+	this->Device = Device;
+
+	// Setup command pools.
+	{
+		VkCommandPoolCreateInfo CreationInfo
+		{
+			.sType = VkStructureType::VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = VkCommandPoolCreateFlagBits::VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+			.queueFamilyIndex = GraphicsQueueIndex
+		};
+
+		this->CommandPools.resize(WorkersCount);
+		for (auto& CommandPool : this->CommandPools)
+		{
+			vkCreateCommandPool(Device, &CreationInfo, nullptr, &CommandPool);
+		}
+	}
+
+	// Start workers.
+	for (uint32_t i = 0; i < WorkersCount; i++)
+	{
+		this->Workers.emplace_back(&ParallelCommandRecorder::RunWorker, this, i);
+	}
+}
+
+void ParallelCommandRecorder::FreeGPUResources()
+{
+	{
+		std::lock_guard<std::mutex> Lock(this->JobMutex);
+		this->IsShuttingDown = true;
+	}
+	this->JobStarted.notify_all();
+
+	for (auto& Worker : this->Workers)
+	{
+		Worker.join();
+	}
+	this->Workers.clear();
+
+	// Secondary command buffers are freed together with their pools.
+	for (const auto CommandPool : this->CommandPools)
+	{
+		vkDestroyCommandPool(Device, CommandPool, nullptr);
+	}
+	this->CommandPools.clear();
+	this->SecondaryCommandBuffers.clear();
+}
+
+void ParallelCommandRecorder::RunWorker(const uint32_t WorkerIndex)
+{
+	TUTORIAL_VK_PROFILE_THREAD("Recording worker " + std::to_string(WorkerIndex));
+
+	uint64_t LastJobGeneration = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> Lock(this->JobMutex);
+			this->JobStarted.wait(Lock, [&] { return this->IsShuttingDown || this->JobGeneration != LastJobGeneration; });
+
+			if (this->IsShuttingDown)
+				return;
+
+			LastJobGeneration = this->JobGeneration;
+		}
+
+		// Job isn't replaced until every worker reports it finished.
+		{
+			TUTORIAL_VK_PROFILE_ZONE("Record slice");
+			this->Job(WorkerIndex);
+		}
+
+		{
+			std::lock_guard<std::mutex> Lock(this->JobMutex);
+			this->PendingWorkersCount--;
+		}
+		this->JobFinished.notify_one();
+	}
+}
+
+bool ParallelCommandRecorder::ShouldRecordInParallel(const size_t ActorsCount) const
+{
+	return this->Workers.size() > 1 && ActorsCount >= this->Workers.size() * MinActorsPerWorker;
+}
+
+void ParallelCommandRecorder::SetInheritedPipelineStatistics(const VkQueryPipelineStatisticFlags PipelineStatistics)
+{
+	this->InheritedPipelineStatistics = PipelineStatistics;
+}
+
+void ParallelCommandRecorder::RecordSlices(VkCommandBuffer PrimaryCommandBuffer, const void* Pass, const VkCommandBufferInheritanceInfo& InheritanceInfo, const uint32_t ActorsCount, const std::function<void(VkCommandBuffer CommandBuffer, const uint32_t FirstActor, const uint32_t ActorsCount)>& RecordSlice)
+{
+	const uint32_t WorkersCount = static_cast<uint32_t>(this->Workers.size());
+
+	// Allocate secondary command buffers when primary command buffer records this pass for the first time.
+	auto& CommandBuffers = this->SecondaryCommandBuffers[{ PrimaryCommandBuffer, Pass }];
+	if (CommandBuffers.empty())
+	{
+		CommandBuffers.resize(WorkersCount);
+
+		for (uint32_t i = 0; i < WorkersCount; i++)
+		{
+			VkCommandBufferAllocateInfo AllocationInfo
+			{
+				.sType = VkStructureType::VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+				.pNext = nullptr,
+				.commandPool = this->CommandPools[i],
+				.level = VkCommandBufferLevel::VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+				.commandBufferCount = 1
+			};
+
+			vkAllocateCommandBuffers(Device, &AllocationInfo, &CommandBuffers[i]);
+		}
+	}
+
+	const uint32_t SliceSize = (ActorsCount + WorkersCount - 1) / WorkersCount;
+
+	VkCommandBufferInheritanceInfo SliceInheritanceInfo = InheritanceInfo;
+	SliceInheritanceInfo.pipelineStatistics = this->InheritedPipelineStatistics;
+
+	// Record slices.
+	{
+		std::unique_lock<std::mutex> Lock(this->JobMutex);
+
+		this->Job = [&](const uint32_t WorkerIndex)
+		{
+			const uint32_t FirstActor = std::min(WorkerIndex * SliceSize, ActorsCount);
+			const uint32_t SliceActorsCount = std::min(SliceSize, ActorsCount - FirstActor);
+
+			VkCommandBufferBeginInfo BeginInfo
+			{
+				.sType = VkStructureType::VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+				.pNext = nullptr,
+				.flags = VkCommandBufferUsageFlagBits::VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+				.pInheritanceInfo = &SliceInheritanceInfo
+			};
+
+			vkBeginCommandBuffer(CommandBuffers[WorkerIndex], &BeginInfo);
+			RecordSlice(CommandBuffers[WorkerIndex], FirstActor, SliceActorsCount);
+			vkEndCommandBuffer(CommandBuffers[WorkerIndex]);
+		};
+		this->PendingWorkersCount = WorkersCount;
+		this->JobGeneration++;
+
+		this->JobStarted.notify_all();
+		this->JobFinished.wait(Lock, [&] { return this->PendingWorkersCount == 0; });
+	}
+
+	vkCmdExecuteCommands(PrimaryCommandBuffer, WorkersCount, CommandBuffers.data());
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Persistent worker threads recording slices of actors into secondary command buffers.
+// Every worker owns its command pool, so workers never synchronize with each other while recording.
+// Secondary command buffers are kept per primary command buffer and pass, because cached primary command buffers keep executing them.
+class ParallelCommandRecorder
+{
+private:
+	VkDevice Device{};
+
+	std::vector<VkCommandPool> CommandPools;
+	std::vector<std::thread> Workers;
+
+	// One secondary command buffer per worker for every primary command buffer and pass recorded through recorder.
+	std::map<std::pair<VkCommandBuffer, const void*>, std::vector<VkCommandBuffer>> SecondaryCommandBuffers;
+
+	std::mutex JobMutex;
+	std::condition_variable JobStarted;
+	std::condition_variable JobFinished;
+	std::function<void(const uint32_t WorkerIndex)> Job;
+	uint64_t JobGeneration = 0;
+	uint32_t PendingWorkersCount = 0;
+	bool IsShuttingDown = false;
+
+	VkQueryPipelineStatisticFlags InheritedPipelineStatistics = 0;
+
+	void RunWorker(const uint32_t WorkerIndex);
+
+public:
+	// Below this number of actors per worker splitting work costs more than it saves, so passes record inline.
+	static constexpr uint32_t MinActorsPerWorker = 512;
+
+	ParallelCommandRecorder(VkDevice Device, const uint32_t GraphicsQueueIndex, const uint32_t WorkersCount);
+
+	// Stops workers and destroys their command pools. Device must be idle.
+	void FreeGPUResources();
+
+	bool ShouldRecordInParallel(const size_t ActorsCount) const;
+
+	// Pipeline statistics query which may be active in primary command buffer while it executes recorded slices.
+	void SetInheritedPipelineStatistics(const VkQueryPipelineStatisticFlags PipelineStatistics);
+
+	// Splits actors into contiguous slices, records every slice on its own worker into secondary command buffer continuing subpass
+	// described by inheritance info, then executes them in order within primary command buffer. Subpass must have been begun with
+	// VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS. State isn't inherited, so RecordSlice has to bind everything it draws with.
+	void RecordSlices(VkCommandBuffer PrimaryCommandBuffer, const void* Pass, const VkCommandBufferInheritanceInfo& InheritanceInfo, const uint32_t ActorsCount, const std::function<void(VkCommandBuffer CommandBuffer, const uint32_t FirstActor, const uint32_t ActorsCount)>& RecordSlice);
+
+	~ParallelCommandRecorder() = default;
+};
@@ -0,0 +1,119 @@
+#include "PersistentPipelineCache.hpp"
+#include "CPUProfiler.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+PersistentPipelineCache::PersistentPipelineCache(VkDevice Device, const VkPhysicalDeviceProperties& DeviceProperties, const std::string& FilePath)
+{
+	TUTORIAL_VK_PROFILE_ZONE("PersistentPipelineCache::PersistentPipelineCache");
+
+	this->Device = Device;
+	this->FilePath = FilePath;
+
+	// Load cache of previous launch.
+	std::vector<char> Data;
+	if (std::filesystem::exists(FilePath))
+	{
+		Data.resize(std::filesystem::file_size(FilePath));
+
+		std::ifstream File(FilePath, std::ios::binary);
+		File.read(Data.data(), Data.size());
+
+		if (!File || !IsHeaderCompatible(Data, DeviceProperties))
+		{
+			std::cout << "Pipeline cache " << FilePath << " was made by other device or driver, pipelines are compiled from scratch." << std::endl;
+			Data.clear();
+		}
+	}
+
+	VkPipelineCacheCreateInfo CreationInfo
+	{
+		.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.initialDataSize = Data.size(),
+		.pInitialData = Data.data()
+	};
+
+	vkCreatePipelineCache(Device, &CreationInfo, nullptr, &this->Cache);
+
+	this->IsLoaded = !Data.empty();
+	this->SavedData = std::move(Data);
+}
+
+bool PersistentPipelineCache::IsHeaderCompatible(const std::vector<char>& Data, const VkPhysicalDeviceProperties& DeviceProperties)
+{
+	VkPipelineCacheHeaderVersionOne Header{};
+	if (Data.size() < sizeof(Header))
+		return false;
+
+	std::memcpy(&Header, Data.data(), sizeof(Header));
+
+	return Header.headerSize >= sizeof(Header) && Header.headerVersion == VkPipelineCacheHeaderVersion::VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		Header.vendorID == DeviceProperties.vendorID && Header.deviceID == DeviceProperties.deviceID &&
+		std::memcmp(Header.pipelineCacheUUID, DeviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void PersistentPipelineCache::FreeGPUResources()
+{
+	Save();
+
+	vkDestroyPipelineCache(Device, this->Cache, nullptr);
+	this->Cache = VK_NULL_HANDLE;
+}
+
+VkPipelineCache PersistentPipelineCache::GetCache() const
+{
+	return this->Cache;
+}
+
+bool PersistentPipelineCache::IsWarm() const
+{
+	return this->IsLoaded;
+}
+
+void PersistentPipelineCache::Save()
+{
+	TUTORIAL_VK_PROFILE_ZONE("PersistentPipelineCache::Save");
+
+	size_t DataSize = 0;
+	vkGetPipelineCacheData(Device, this->Cache, &DataSize, nullptr);
+
+	std::vector<char> Data(DataSize);
+	vkGetPipelineCacheData(Device, this->Cache, &DataSize, Data.data());
+	Data.resize(DataSize);
+
+	if (Data == this->SavedData)
+		return;
+
+	const std::string TemporaryFilePath = this->FilePath + ".tmp";
+	{
+		std::ofstream File(TemporaryFilePath, std::ios::binary | std::ios::trunc);
+		File.write(Data.data(), DataSize);
+
+		// Data is flushed on close, which may fail too.
+		File.close();
+		if (!File)
+		{
+			std::cerr << "Failed to write pipeline cache into " << TemporaryFilePath << "." << std::endl;
+
+			std::error_code Error;
+			std::filesystem::remove(TemporaryFilePath, Error);
+			return;
+		}
+	}
+
+	std::error_code Error;
+	std::filesystem::rename(TemporaryFilePath, this->FilePath, Error);
+	if (Error)
+	{
+		std::cerr << "Failed to replace pipeline cache " << this->FilePath << ": " << Error.message() << std::endl;
+		std::filesystem::remove(TemporaryFilePath, Error);
+		return;
+	}
+
+	this->SavedData = std::move(Data);
+}
\ No newline at end of file
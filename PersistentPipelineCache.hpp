@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Pipeline cache shared by all passes and kept on disk between launches, so pipelines are compiled from SPIR-V
+// only by first launch on given device and driver. Data made by other device or driver is rejected by its header.
+class PersistentPipelineCache
+{
+private:
+	VkDevice Device{};
+	VkPipelineCache Cache{};
+
+	std::string FilePath;
+	bool IsLoaded = false;
+	std::vector<char> SavedData; // Data loaded or saved last time, identical data isn't written again.
+
+	static bool IsHeaderCompatible(const std::vector<char>& Data, const VkPhysicalDeviceProperties& DeviceProperties);
+
+public:
+	PersistentPipelineCache(VkDevice Device, const VkPhysicalDeviceProperties& DeviceProperties, const std::string& FilePath);
+
+	// Saves cache before destroying it.
+	void FreeGPUResources();
+
+	VkPipelineCache GetCache() const;
+
+	// Whether pipelines are created from cache of previous launch.
+	bool IsWarm() const;
+
+	// Data is written into temporary file which then replaces cache file, so interrupted save never leaves truncated cache behind.
+	void Save();
+
+	~PersistentPipelineCache() = default;
+};
\ No newline at end of file
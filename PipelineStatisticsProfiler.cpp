@@ -0,0 +1,142 @@
+#include "PipelineStatisticsProfiler.hpp"
+
+#include <iostream>
+
+// Every zone has single query.
+PipelineStatisticsProfiler::PipelineStatisticsProfiler(VkDevice Device, const bool IsSupported, const uint32_t FramesInFlight)
+	: QueryProfiler(Device, IsSupported, VkQueryType::VK_QUERY_TYPE_PIPELINE_STATISTICS, CountedStatistics, 1, FramesInFlight)
+{
+	if (!this->IsSupported)
+	{
+		std::cerr << "Device doesn't support pipeline statistics queries, pass statistics won't be gathered." << std::endl;
+	}
+}
+
+VkQueryPipelineStatisticFlags PipelineStatisticsProfiler::GetInheritedStatistics() const
+{
+	return this->IsSupported ? CountedStatistics : 0;
+}
+
+const char* PipelineStatisticsProfiler::GetCounterName(const Counter CounterIndex)
+{
+	switch (CounterIndex)
+	{
+	case Counter::VertexShaderInvocations:
+		return "vertex shader invocations";
+	case Counter::ClippingPrimitives:
+		return "clipping primitives";
+	case Counter::FragmentShaderInvocations:
+		return "fragment shader invocations";
+	default:
+		return "";
+	}
+}
+
+uint32_t PipelineStatisticsProfiler::RegisterZone(const std::string& Name)
+{
+	const uint32_t Zone = AddZone(Name);
+	if (Zone == MaxZonesCount)
+		return Zone;
+
+	this->IsLastStatisticsValid.push_back(false);
+	this->LastStatistics.push_back({});
+	this->ZonesHistory.emplace_back(AveragedFramesCount, Statistics{});
+	this->IsZonesHistoryValid.emplace_back(AveragedFramesCount, false);
+
+	return Zone;
+}
+
+void PipelineStatisticsProfiler::RecordZoneBegin(VkCommandBuffer CommandBuffer, const uint32_t FrameSlot, const uint32_t Zone) const
+{
+	if (!CanRecordZone(Zone))
+		return;
+
+	vkCmdBeginQuery(CommandBuffer, this->QueryPool, GetFirstQuery(FrameSlot, Zone), 0);
+}
+
+void PipelineStatisticsProfiler::RecordZoneEnd(VkCommandBuffer CommandBuffer, const uint32_t FrameSlot, const uint32_t Zone) const
+{
+	if (!CanRecordZone(Zone))
+		return;
+
+	vkCmdEndQuery(CommandBuffer, this->QueryPool, GetFirstQuery(FrameSlot, Zone));
+}
+
+bool PipelineStatisticsProfiler::ReadFrame(const uint32_t FrameSlot)
+{
+	struct QueryResult
+	{
+		Statistics Counters;
+		uint64_t Availability;
+	};
+	std::vector<QueryResult> Results(this->ZonesNames.size() * this->QueriesPerZone);
+
+	if (!ReadQueryResults(FrameSlot, Results.data(), sizeof(QueryResult)))
+		return false;
+
+	for (size_t Zone = 0; Zone < this->ZonesNames.size(); Zone++)
+	{
+		this->IsLastStatisticsValid[Zone] = Results[Zone].Availability != 0;
+		this->LastStatistics[Zone] = Results[Zone].Counters;
+
+		this->ZonesHistory[Zone][this->HistoryCursor] = this->LastStatistics[Zone];
+		this->IsZonesHistoryValid[Zone][this->HistoryCursor] = this->IsLastStatisticsValid[Zone];
+	}
+	this->HistoryCursor = (this->HistoryCursor + 1) % AveragedFramesCount;
+
+	return true;
+}
+
+bool PipelineStatisticsProfiler::GetLastStatistics(const uint32_t Zone, Statistics& ZoneStatistics) const
+{
+	ZoneStatistics = this->LastStatistics[Zone];
+	return this->IsLastStatisticsValid[Zone];
+}
+
+PipelineStatisticsProfiler::Statistics PipelineStatisticsProfiler::GetRollingAverage(const uint32_t Zone) const
+{
+	Statistics SummedStatistics{};
+	uint32_t StatisticsCount = 0;
+
+	for (uint32_t i = 0; i < AveragedFramesCount; i++)
+	{
+		if (!this->IsZonesHistoryValid[Zone][i])
+			continue;
+
+		for (uint32_t CounterIndex = 0; CounterIndex < Counter::CountersCount; CounterIndex++)
+		{
+			SummedStatistics[CounterIndex] += this->ZonesHistory[Zone][i][CounterIndex];
+		}
+		StatisticsCount++;
+	}
+
+	if (StatisticsCount)
+	{
+		for (auto& SummedCounter : SummedStatistics)
+		{
+			SummedCounter /= StatisticsCount;
+		}
+	}
+
+	return SummedStatistics;
+}
+
+void PipelineStatisticsProfiler::PrintAverages() const
+{
+	if (!this->IsSupported)
+		return;
+
+	std::cout << "Pass pipeline statistics (average of last " << AveragedFramesCount << " frames):" << std::endl;
+
+	for (uint32_t Zone = 0; Zone < GetZonesCount(); Zone++)
+	{
+		const Statistics Average = GetRollingAverage(Zone);
+
+		std::cout << "\t" << this->ZonesNames[Zone] << ":";
+		for (uint32_t CounterIndex = 0; CounterIndex < Counter::CountersCount; CounterIndex++)
+		{
+			std::cout << (CounterIndex ? ", " : " ") << Average[CounterIndex] << " " << GetCounterName(static_cast<Counter>(CounterIndex));
+		}
+		std::cout << std::endl;
+	}
+}
\ No newline at end of file
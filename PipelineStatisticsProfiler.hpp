@@ -0,0 +1,59 @@
+#pragma once
+#include "QueryProfiler.hpp"
+#include <array>
+
+// Counts shader invocations and primitives of named zones (passes) with pipeline statistics queries.
+class PipelineStatisticsProfiler : public QueryProfiler
+{
+public:
+	enum Counter
+	{
+		VertexShaderInvocations,
+		ClippingPrimitives,
+		FragmentShaderInvocations,
+		CountersCount
+	};
+
+	using Statistics = std::array<uint64_t, Counter::CountersCount>;
+
+private:
+	// Order of counters written by query matches order of bits, so it must follow Counter enum.
+	static constexpr VkQueryPipelineStatisticFlags CountedStatistics =
+		VkQueryPipelineStatisticFlagBits::VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+		VkQueryPipelineStatisticFlagBits::VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+		VkQueryPipelineStatisticFlagBits::VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+	std::vector<bool> IsLastStatisticsValid;
+	std::vector<Statistics> LastStatistics;
+	std::vector<std::vector<Statistics>> ZonesHistory; // Last statistics of every zone, used as ring buffer.
+	std::vector<std::vector<bool>> IsZonesHistoryValid;
+
+public:
+	// Queries stay active while passes execute secondary command buffers, so besides pipelineStatisticsQuery
+	// inheritedQueries feature has to be enabled as well, otherwise nothing is counted.
+	PipelineStatisticsProfiler(VkDevice Device, const bool IsSupported, const uint32_t FramesInFlight);
+
+	// Statistics which secondary command buffers executed within zone must declare in their inheritance info.
+	VkQueryPipelineStatisticFlags GetInheritedStatistics() const;
+
+	static const char* GetCounterName(const Counter CounterIndex);
+
+	// Returns zone index passed while recording.
+	uint32_t RegisterZone(const std::string& Name);
+
+	// Zones can't overlap, query must be ended before next one is begun.
+	void RecordZoneBegin(VkCommandBuffer CommandBuffer, const uint32_t FrameSlot, const uint32_t Zone) const;
+	void RecordZoneEnd(VkCommandBuffer CommandBuffer, const uint32_t FrameSlot, const uint32_t Zone) const;
+
+	// Reads statistics of last frame submitted in slot, which must have finished on GPU. Returns false when there was nothing to read.
+	bool ReadFrame(const uint32_t FrameSlot);
+
+	// Statistics of zone in last frame read back. Returns false when zone wasn't measured.
+	bool GetLastStatistics(const uint32_t Zone, Statistics& ZoneStatistics) const;
+
+	Statistics GetRollingAverage(const uint32_t Zone) const;
+
+	void PrintAverages() const;
+
+	virtual ~PipelineStatisticsProfiler() = default;
+};
\ No newline at end of file
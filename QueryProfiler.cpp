@@ -0,0 +1,95 @@
+#include "QueryProfiler.hpp"
+
+#include <iostream>
+
+QueryProfiler::QueryProfiler(VkDevice Device, const bool IsSupported, const VkQueryType QueryType, const VkQueryPipelineStatisticFlags PipelineStatistics,
+	const uint32_t QueriesPerZone, const uint32_t FramesInFlight)
+{
+	this->Device = Device;
+	this->IsSupported = IsSupported;
+	this->QueriesPerZone = QueriesPerZone;
+	this->IsFrameSlotSubmitted.resize(FramesInFlight, false);
+
+	if (!this->IsSupported)
+		return;
+
+	// Setup query pool. Every zone of every frame in flight has its own queries.
+	{
+		VkQueryPoolCreateInfo CreationInfo
+		{
+			.sType = VkStructureType::VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.queryType = QueryType,
+			.queryCount = FramesInFlight * MaxZonesCount * QueriesPerZone,
+			.pipelineStatistics = PipelineStatistics
+		};
+
+		vkCreateQueryPool(Device, &CreationInfo, nullptr, &this->QueryPool);
+	}
+}
+
+void QueryProfiler::FreeGPUResources()
+{
+	vkDestroyQueryPool(Device, this->QueryPool, nullptr);
+}
+
+uint32_t QueryProfiler::GetFirstQuery(const uint32_t FrameSlot, const uint32_t Zone) const
+{
+	return (FrameSlot * MaxZonesCount + Zone) * this->QueriesPerZone;
+}
+
+uint32_t QueryProfiler::AddZone(const std::string& Name)
+{
+	if (this->ZonesNames.size() == MaxZonesCount)
+	{
+		std::cerr << "Too many GPU profiler zones, " << Name << " won't be measured." << std::endl;
+		return MaxZonesCount;
+	}
+
+	this->ZonesNames.push_back(Name);
+
+	return static_cast<uint32_t>(this->ZonesNames.size() - 1);
+}
+
+bool QueryProfiler::CanRecordZone(const uint32_t Zone) const
+{
+	return this->IsSupported && Zone < MaxZonesCount;
+}
+
+bool QueryProfiler::ReadQueryResults(const uint32_t FrameSlot, void* Results, const VkDeviceSize ResultStride)
+{
+	if (!this->IsSupported || !this->IsFrameSlotSubmitted[FrameSlot] || this->ZonesNames.empty())
+		return false;
+
+	this->IsFrameSlotSubmitted[FrameSlot] = false;
+
+	const uint32_t QueriesCount = static_cast<uint32_t>(this->ZonesNames.size()) * this->QueriesPerZone;
+	vkGetQueryPoolResults(Device, this->QueryPool, GetFirstQuery(FrameSlot, 0), QueriesCount, QueriesCount * ResultStride, Results, ResultStride,
+		VkQueryResultFlagBits::VK_QUERY_RESULT_64_BIT | VkQueryResultFlagBits::VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+	return true;
+}
+
+void QueryProfiler::RecordReset(VkCommandBuffer CommandBuffer, const uint32_t FrameSlot) const
+{
+	if (!this->IsSupported)
+		return;
+
+	vkCmdResetQueryPool(CommandBuffer, this->QueryPool, GetFirstQuery(FrameSlot, 0), MaxZonesCount * this->QueriesPerZone);
+}
+
+void QueryProfiler::MarkFrameSubmitted(const uint32_t FrameSlot)
+{
+	this->IsFrameSlotSubmitted[FrameSlot] = true;
+}
+
+uint32_t QueryProfiler::GetZonesCount() const
+{
+	return static_cast<uint32_t>(this->ZonesNames.size());
+}
+
+const std::string& QueryProfiler::GetZoneName(const uint32_t Zone) const
+{
+	return this->ZonesNames[Zone];
+}
\ No newline at end of file
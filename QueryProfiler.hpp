@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+// Named zones (passes) measured by queries of one type. Every frame in flight owns its own range of queries, which is read back
+// once frame slot is reused, when frame is known to be finished, so reading never stalls. Derived profilers record zones
+// and interpret query results.
+class QueryProfiler
+{
+protected:
+	VkDevice Device{};
+
+	VkQueryPool QueryPool{};
+	bool IsSupported = false;
+	uint32_t QueriesPerZone = 0;
+
+	static constexpr uint32_t MaxZonesCount = 8;
+	static constexpr uint32_t AveragedFramesCount = 64;
+
+	std::vector<std::string> ZonesNames;
+	std::vector<bool> IsFrameSlotSubmitted;
+
+	uint32_t HistoryCursor = 0; // Slot of zones history written by next frame read back, advanced by derived profilers.
+
+	// Query pool isn't created when queries aren't supported, then nothing is recorded nor read.
+	QueryProfiler(VkDevice Device, const bool IsSupported, const VkQueryType QueryType, const VkQueryPipelineStatisticFlags PipelineStatistics,
+		const uint32_t QueriesPerZone, const uint32_t FramesInFlight);
+
+	uint32_t GetFirstQuery(const uint32_t FrameSlot, const uint32_t Zone) const;
+
+	// Returns index of added zone, or MaxZonesCount when there is no room for it.
+	uint32_t AddZone(const std::string& Name);
+
+	bool CanRecordZone(const uint32_t Zone) const;
+
+	// Copies results of all queries of registered zones, every result followed by its availability. Zones which weren't
+	// recorded are left unavailable after reset. Returns false when there was nothing to read.
+	bool ReadQueryResults(const uint32_t FrameSlot, void* Results, const VkDeviceSize ResultStride);
+
+public:
+	void FreeGPUResources();
+
+	// Resets queries of frame slot. Must be recorded before any zone of frame.
+	void RecordReset(VkCommandBuffer CommandBuffer, const uint32_t FrameSlot) const;
+
+	void MarkFrameSubmitted(const uint32_t FrameSlot);
+
+	uint32_t GetZonesCount() const;
+	const std::string& GetZoneName(const uint32_t Zone) const;
+
+	virtual ~QueryProfiler() = default;
+};
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "QueueTimeline.hpp"
+
+QueueTimeline::QueueTimeline(VkDevice Device)
+{
+	this->Device = Device;
+
+	VkSemaphoreTypeCreateInfo TypeInfo
+	{
+		.sType = VkStructureType::VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+		.pNext = nullptr,
+		.semaphoreType = VkSemaphoreType::VK_SEMAPHORE_TYPE_TIMELINE,
+		.initialValue = 0
+	};
+
+	VkSemaphoreCreateInfo CreationInfo
+	{
+		.sType = VkStructureType::VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+		.pNext = &TypeInfo,
+		.flags = 0
+	};
+
+	vkCreateSemaphore(Device, &CreationInfo, nullptr, &this->Semaphore);
+}
+
+void QueueTimeline::FreeGPUResources()
+{
+	vkDestroySemaphore(Device, this->Semaphore, nullptr);
+}
+
+uint64_t QueueTimeline::AdvanceValue()
+{
+	return ++this->LastSubmittedValue;
+}
+
+uint64_t QueueTimeline::GetLastSubmittedValue() const
+{
+	return this->LastSubmittedValue;
+}
+
+uint64_t QueueTimeline::GetCompletedValue() const
+{
+	uint64_t Value = 0;
+	vkGetSemaphoreCounterValue(Device, this->Semaphore, &Value);
+	return Value;
+}
+
+void QueueTimeline::Wait(const uint64_t Value) const
+{
+	VkSemaphoreWaitInfo WaitInfo
+	{
+		.sType = VkStructureType::VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.semaphoreCount = 1,
+		.pSemaphores = &this->Semaphore,
+		.pValues = &Value
+	};
+
+	vkWaitSemaphores(Device, &WaitInfo, UINT64_MAX);
+}
+
+VkSemaphoreSubmitInfo QueueTimeline::MakeSubmitInfo(const uint64_t Value, const VkPipelineStageFlags2 StageMask) const
+{
+	return VkSemaphoreSubmitInfo
+	{
+		.sType = VkStructureType::VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+		.pNext = nullptr,
+		.semaphore = this->Semaphore,
+		.value = Value,
+		.stageMask = StageMask,
+		.deviceIndex = 0
+	};
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+// Timeline semaphore of one queue. Every submission to queue signals next, monotonically increasing value,
+// so CPU and other queues wait for specific submission instead of resetting fences or binary semaphores.
+class QueueTimeline
+{
+private:
+	VkDevice Device{};
+
+	VkSemaphore Semaphore{};
+	uint64_t LastSubmittedValue = 0;
+
+public:
+	QueueTimeline(VkDevice Device);
+
+	void FreeGPUResources();
+
+	// Reserves value signaled by next submission to queue.
+	uint64_t AdvanceValue();
+
+	uint64_t GetLastSubmittedValue() const;
+
+	// Value of last submission finished by GPU.
+	uint64_t GetCompletedValue() const;
+
+	// Blocks until GPU reaches given value. Value 0 is reached from the beginning.
+	void Wait(const uint64_t Value) const;
+
+	VkSemaphoreSubmitInfo MakeSubmitInfo(const uint64_t Value, const VkPipelineStageFlags2 StageMask) const;
+
+	~QueueTimeline() = default;
+};
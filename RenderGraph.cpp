@@ -0,0 +1,465 @@
+#include "RenderGraph.hpp"
+
+#include <iostream>
+
+// Only writes have to be made available by barriers, reads are only waited for.
+static constexpr VkAccessFlags2 WriteAccessBits = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+RenderGraph::RenderGraph(const RenderTargetHeap& Heap)
+{
+	this->Heap = &Heap;
+}
+
+uint32_t RenderGraph::AddImage(const std::string& Name, VkImage Image, VkImageAspectFlags AspectMask)
+{
+	Resource NewResource
+	{
+		.Name = Name,
+		.Image = Image,
+		.AspectMask = AspectMask,
+		.IsImported = false,
+		.IsOutput = false,
+		.InitialUsage = {},
+		.FinalUsage = {},
+		.FrameStartState = {}
+	};
+	this->Resources.push_back(NewResource);
+
+	return static_cast<uint32_t>(this->Resources.size() - 1);
+}
+
+uint32_t RenderGraph::ImportImage(const std::string& Name, VkImageAspectFlags AspectMask, const RenderGraphUsage& InitialUsage, const RenderGraphUsage& FinalUsage)
+{
+	Resource NewResource
+	{
+		.Name = Name,
+		.Image = VK_NULL_HANDLE,
+		.AspectMask = AspectMask,
+		.IsImported = true,
+		.IsOutput = false,
+		.InitialUsage = InitialUsage,
+		.FinalUsage = FinalUsage,
+		.FrameStartState =
+		{
+			.Layout = InitialUsage.Layout,
+			.WriteStageMask = InitialUsage.StageMask,
+			.WriteAccessMask = InitialUsage.AccessMask & WriteAccessBits,
+			.ReadStageMask = VK_PIPELINE_STAGE_2_NONE,
+			.ReadAccessMask = VK_ACCESS_2_NONE,
+			.Queue = GraphicsGraphQueue
+		}
+	};
+	this->Resources.push_back(NewResource);
+
+	return static_cast<uint32_t>(this->Resources.size() - 1);
+}
+
+void RenderGraph::SetImage(const uint32_t Resource, VkImage Image)
+{
+	this->Resources[Resource].Image = Image;
+}
+
+void RenderGraph::MarkOutput(const uint32_t Resource)
+{
+	this->Resources[Resource].IsOutput = true;
+}
+
+uint32_t RenderGraph::FindResource(const std::string& Name) const
+{
+	for (uint32_t i = 0; i < this->Resources.size(); i++)
+	{
+		if (this->Resources[i].Name == Name)
+			return i;
+	}
+
+	std::cerr << "Render graph has no resource named " << Name << "." << std::endl;
+	exit(0);
+}
+
+uint32_t RenderGraph::AddPass(const std::string& Name, FrameStage Stage, const std::function<void(const RenderGraphContext& Context)>& Record, RenderGraphQueue Queue)
+{
+	PassNode NewPass
+	{
+		.Name = Name,
+		.Stage = Stage,
+		.Queue = Queue,
+		.Record = Record,
+		.Accesses = {},
+		.IsCulled = false
+	};
+	this->Passes.push_back(NewPass);
+
+	return static_cast<uint32_t>(this->Passes.size() - 1);
+}
+
+void RenderGraph::Read(const uint32_t Pass, const uint32_t Resource, const RenderGraphUsage& Usage)
+{
+	this->Passes[Pass].Accesses.push_back({ .Resource = Resource, .Usage = Usage, .IsWrite = false, .IsDiscarding = false });
+}
+
+void RenderGraph::Write(const uint32_t Pass, const uint32_t Resource, const RenderGraphUsage& Usage, const bool IsDiscarding)
+{
+	this->Passes[Pass].Accesses.push_back({ .Resource = Resource, .Usage = Usage, .IsWrite = true, .IsDiscarding = IsDiscarding });
+}
+
+void RenderGraph::SortPasses()
+{
+	// Writers of image run in order of declaration, every reader of image runs after all its writers.
+	std::vector<std::vector<uint32_t>> Dependents(this->Passes.size());
+	std::vector<uint32_t> DependenciesCount(this->Passes.size(), 0);
+	{
+		std::vector<std::vector<uint32_t>> Writers(this->Resources.size());
+		for (uint32_t Pass = 0; Pass < this->Passes.size(); Pass++)
+		{
+			for (const auto& Access : this->Passes[Pass].Accesses)
+			{
+				if (Access.IsWrite)
+				{
+					Writers[Access.Resource].push_back(Pass);
+				}
+			}
+		}
+
+		for (uint32_t Pass = 0; Pass < this->Passes.size(); Pass++)
+		{
+			for (const auto& Access : this->Passes[Pass].Accesses)
+			{
+				for (const auto Writer : Writers[Access.Resource])
+				{
+					if (Access.IsWrite ? Writer >= Pass : Writer == Pass)
+						continue;
+
+					Dependents[Writer].push_back(Pass);
+					DependenciesCount[Pass]++;
+				}
+			}
+		}
+	}
+
+	// Among passes ready to run, the one declared first goes first.
+	this->ExecutionOrder.clear();
+	std::vector<bool> IsScheduled(this->Passes.size(), false);
+	while (this->ExecutionOrder.size() < this->Passes.size())
+	{
+		uint32_t ReadyPass = static_cast<uint32_t>(this->Passes.size());
+		for (uint32_t Pass = 0; Pass < this->Passes.size(); Pass++)
+		{
+			if (!IsScheduled[Pass] && DependenciesCount[Pass] == 0)
+			{
+				ReadyPass = Pass;
+				break;
+			}
+		}
+
+		if (ReadyPass == this->Passes.size())
+		{
+			std::cerr << "Render graph passes depend on each other cyclically." << std::endl;
+			exit(0);
+		}
+
+		IsScheduled[ReadyPass] = true;
+		this->ExecutionOrder.push_back(ReadyPass);
+		for (const auto Dependent : Dependents[ReadyPass])
+		{
+			DependenciesCount[Dependent]--;
+		}
+	}
+}
+
+void RenderGraph::CullPasses()
+{
+	// Walking backwards, pass is needed when it writes image which is output or is read by needed pass.
+	std::vector<bool> IsResourceNeeded(this->Resources.size());
+	for (size_t i = 0; i < this->Resources.size(); i++)
+	{
+		IsResourceNeeded[i] = this->Resources[i].IsOutput;
+	}
+
+	for (auto Pass = this->ExecutionOrder.rbegin(); Pass != this->ExecutionOrder.rend(); Pass++)
+	{
+		auto& Node = this->Passes[*Pass];
+
+		Node.IsCulled = true;
+		for (const auto& Access : Node.Accesses)
+		{
+			if (Access.IsWrite && IsResourceNeeded[Access.Resource])
+			{
+				Node.IsCulled = false;
+			}
+		}
+
+		if (Node.IsCulled)
+			continue;
+
+		// Writes which don't discard keep previous content, so its writers are needed too.
+		for (const auto& Access : Node.Accesses)
+		{
+			if (!Access.IsWrite || !Access.IsDiscarding)
+			{
+				IsResourceNeeded[Access.Resource] = true;
+			}
+		}
+	}
+
+	std::erase_if(this->ExecutionOrder, [this](const uint32_t Pass) { return this->Passes[Pass].IsCulled; });
+}
+
+void RenderGraph::SplitBatches()
+{
+	this->Batches.clear();
+	for (uint32_t i = 0; i < this->ExecutionOrder.size(); i++)
+	{
+		const RenderGraphQueue Queue = this->Passes[this->ExecutionOrder[i]].Queue;
+
+		if (this->Batches.empty() || this->Batches.back().Queue != Queue)
+		{
+			this->Batches.push_back({ .Queue = Queue, .FirstPass = i, .PassesCount = 0, .WaitStageMask = VK_PIPELINE_STAGE_2_NONE });
+		}
+		this->Batches.back().PassesCount++;
+	}
+
+	if (!this->Batches.empty() && (this->Batches.front().Queue != GraphicsGraphQueue || this->Batches.back().Queue != GraphicsGraphQueue))
+	{
+		std::cerr << "Render graph has to start and end on graphics queue, which acquires and presents frame." << std::endl;
+		exit(0);
+	}
+}
+
+void RenderGraph::Compile()
+{
+	SortPasses();
+	CullPasses();
+	SplitBatches();
+
+	// Images owned by graph start frame in state in which frame leaves them. Executed passes are the same every frame,
+	// so state after one frame started from scratch is that state.
+	std::vector<ImageState> States(this->Resources.size());
+	for (size_t i = 0; i < this->Resources.size(); i++)
+	{
+		States[i] = this->Resources[i].IsImported ? this->Resources[i].FrameStartState : ImageState{ .Layout = VK_IMAGE_LAYOUT_UNDEFINED, .Queue = GraphicsGraphQueue };
+	}
+	std::vector<VkPipelineStageFlags2> WaitStageMasks;
+	BuildBarriers(States, WaitStageMasks);
+
+	for (size_t i = 0; i < this->Resources.size(); i++)
+	{
+		if (!this->Resources[i].IsImported)
+		{
+			this->Resources[i].FrameStartState = States[i];
+		}
+	}
+
+	// Batches wait for what frame really uses across queues, including images left on other queue by previous frame.
+	for (size_t i = 0; i < this->Resources.size(); i++)
+	{
+		States[i] = this->Resources[i].FrameStartState;
+	}
+	BuildBarriers(States, WaitStageMasks);
+
+	for (auto& Batch : this->Batches)
+	{
+		for (uint32_t i = Batch.FirstPass; i < Batch.FirstPass + Batch.PassesCount; i++)
+		{
+			Batch.WaitStageMask |= WaitStageMasks[i];
+		}
+	}
+
+	this->IsCompiled = true;
+}
+
+uint32_t RenderGraph::GetBatchesCount() const
+{
+	return static_cast<uint32_t>(this->Batches.size());
+}
+
+RenderGraphQueue RenderGraph::GetBatchQueue(const uint32_t Batch) const
+{
+	return this->Batches[Batch].Queue;
+}
+
+VkPipelineStageFlags2 RenderGraph::GetBatchWaitStageMask(const uint32_t Batch) const
+{
+	return this->Batches[Batch].WaitStageMask;
+}
+
+std::vector<std::vector<VkImageMemoryBarrier2>> RenderGraph::BuildBarriers(std::vector<ImageState>& States, std::vector<VkPipelineStageFlags2>& WaitStageMasks) const
+{
+	std::vector<std::vector<VkImageMemoryBarrier2>> Barriers(this->ExecutionOrder.size() + 1);
+	WaitStageMasks.assign(this->ExecutionOrder.size() + 1, VK_PIPELINE_STAGE_2_NONE);
+
+	const auto AddBarrier = [&](std::vector<VkImageMemoryBarrier2>& PassBarriers, const uint32_t ResourceIndex, const RenderGraphUsage& Usage,
+		const VkPipelineStageFlags2 SrcStageMask, const VkAccessFlags2 SrcAccessMask, const VkImageLayout OldLayout)
+	{
+		PassBarriers.push_back(
+		{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+			.pNext = nullptr,
+			.srcStageMask = SrcStageMask,
+			.srcAccessMask = SrcAccessMask,
+			.dstStageMask = Usage.StageMask,
+			.dstAccessMask = Usage.AccessMask,
+			.oldLayout = OldLayout,
+			.newLayout = Usage.Layout,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = this->Resources[ResourceIndex].Image,
+			.subresourceRange =
+			{
+				.aspectMask = this->Resources[ResourceIndex].AspectMask,
+				.baseMipLevel = 0,
+				.levelCount = VK_REMAINING_MIP_LEVELS,
+				.baseArrayLayer = 0,
+				.layerCount = VK_REMAINING_ARRAY_LAYERS
+			}
+		});
+	};
+
+	const auto Access = [&](const size_t PassIndex, const uint32_t ResourceIndex, const RenderGraphUsage& Usage, const RenderGraphQueue Queue, const bool IsWrite, const bool IsDiscarding)
+	{
+		auto& PassBarriers = Barriers[PassIndex];
+		auto& State = States[ResourceIndex];
+
+		// Discarded image is transitioned even within the same layout, because its memory may have been used by aliased image.
+		const bool IsTransition = IsDiscarding || State.Layout != Usage.Layout;
+
+		if (State.Queue != Queue)
+		{
+			// Semaphore waited by batch at stages of this usage makes everything done on other queue visible to them,
+			// so only layout transition is left, chained after semaphore wait.
+			if (IsTransition)
+			{
+				AddBarrier(PassBarriers, ResourceIndex, Usage, Usage.StageMask, VK_ACCESS_2_NONE, IsDiscarding ? VK_IMAGE_LAYOUT_UNDEFINED : State.Layout);
+			}
+			WaitStageMasks[PassIndex] |= Usage.StageMask;
+
+			// Following usages on this queue chain after semaphore wait as if it was write.
+			State.Layout = Usage.Layout;
+			State.WriteStageMask = Usage.StageMask;
+			State.WriteAccessMask = IsWrite ? Usage.AccessMask & WriteAccessBits : VK_ACCESS_2_NONE;
+			State.ReadStageMask = IsWrite ? VK_PIPELINE_STAGE_2_NONE : Usage.StageMask;
+			State.ReadAccessMask = IsWrite ? VK_ACCESS_2_NONE : Usage.AccessMask;
+			State.Queue = Queue;
+		}
+		else if (IsWrite || IsTransition)
+		{
+			// Writes and transitions wait for every earlier usage, but only earlier writes have to be made available.
+			const VkPipelineStageFlags2 SrcStageMask = State.WriteStageMask | State.ReadStageMask;
+			if (IsTransition || SrcStageMask != VK_PIPELINE_STAGE_2_NONE)
+			{
+				AddBarrier(PassBarriers, ResourceIndex, Usage, SrcStageMask, State.WriteAccessMask, IsDiscarding ? VK_IMAGE_LAYOUT_UNDEFINED : State.Layout);
+			}
+
+			// Transition is write too, made visible to stages of this usage.
+			State.Layout = Usage.Layout;
+			State.WriteStageMask = Usage.StageMask;
+			State.WriteAccessMask = IsWrite ? Usage.AccessMask & WriteAccessBits : VK_ACCESS_2_NONE;
+			State.ReadStageMask = IsWrite ? VK_PIPELINE_STAGE_2_NONE : Usage.StageMask;
+			State.ReadAccessMask = IsWrite ? VK_ACCESS_2_NONE : Usage.AccessMask;
+		}
+		else if ((Usage.StageMask & ~State.ReadStageMask) || (Usage.AccessMask & ~State.ReadAccessMask))
+		{
+			// Read in the same layout waits only when last write hasn't been made visible to it yet.
+			if (State.WriteStageMask != VK_PIPELINE_STAGE_2_NONE)
+			{
+				AddBarrier(PassBarriers, ResourceIndex, Usage, State.WriteStageMask, State.WriteAccessMask, State.Layout);
+			}
+
+			State.ReadStageMask |= Usage.StageMask;
+			State.ReadAccessMask |= Usage.AccessMask;
+		}
+	};
+
+	for (size_t i = 0; i < this->ExecutionOrder.size(); i++)
+	{
+		const auto& Pass = this->Passes[this->ExecutionOrder[i]];
+
+		for (const auto& ResourceAccess : Pass.Accesses)
+		{
+			Access(i, ResourceAccess.Resource, ResourceAccess.Usage, Pass.Queue, ResourceAccess.IsWrite, ResourceAccess.IsDiscarding);
+		}
+	}
+
+	for (uint32_t i = 0; i < this->Resources.size(); i++)
+	{
+		if (this->Resources[i].IsImported)
+		{
+			Access(this->ExecutionOrder.size(), i, this->Resources[i].FinalUsage, GraphicsGraphQueue, false, false);
+		}
+	}
+
+	return Barriers;
+}
+
+void RenderGraph::Record(const uint32_t Batch, const RenderGraphContext& Context) const
+{
+	std::vector<ImageState> States(this->Resources.size());
+	for (size_t i = 0; i < this->Resources.size(); i++)
+	{
+		States[i] = this->Resources[i].FrameStartState;
+	}
+
+	std::vector<VkPipelineStageFlags2> WaitStageMasks;
+	const auto Barriers = BuildBarriers(States, WaitStageMasks);
+
+	// Aliasing and image barriers preceding pass are flushed together right before it.
+	BarrierRecorder PendingBarriers;
+	const auto& RecordedBatch = this->Batches[Batch];
+	for (size_t i = RecordedBatch.FirstPass; i < RecordedBatch.FirstPass + RecordedBatch.PassesCount; i++)
+	{
+		const auto& Pass = this->Passes[this->ExecutionOrder[i]];
+
+		if (i == 0 || this->Passes[this->ExecutionOrder[i - 1]].Stage != Pass.Stage)
+		{
+			this->Heap->AddAliasingBarriers(PendingBarriers, Pass.Stage);
+		}
+		for (const auto& Barrier : Barriers[i])
+		{
+			PendingBarriers.AddImageBarrier(Barrier);
+		}
+
+		PendingBarriers.Flush(Context.CommandBuffer);
+		Pass.Record(Context);
+	}
+
+	if (Batch != this->Batches.size() - 1)
+		return;
+
+	for (const auto& Barrier : Barriers.back())
+	{
+		PendingBarriers.AddImageBarrier(Barrier);
+	}
+	PendingBarriers.Flush(Context.CommandBuffer);
+}
+
+void RenderGraph::ReportPasses() const
+{
+	if (!this->IsCompiled)
+		return;
+
+	std::vector<ImageState> States(this->Resources.size());
+	for (size_t i = 0; i < this->Resources.size(); i++)
+	{
+		States[i] = this->Resources[i].FrameStartState;
+	}
+	std::vector<VkPipelineStageFlags2> WaitStageMasks;
+	const auto Barriers = BuildBarriers(States, WaitStageMasks);
+
+	std::cout << "Render graph passes:" << std::endl;
+	for (size_t i = 0; i < this->ExecutionOrder.size(); i++)
+	{
+		const auto& Pass = this->Passes[this->ExecutionOrder[i]];
+
+		std::cout << "\t" << Pass.Name << (Pass.Queue == AsyncComputeGraphQueue ? " on async compute queue" : "") << " (" << Barriers[i].size() << " image barriers"
+			<< (WaitStageMasks[i] != VK_PIPELINE_STAGE_2_NONE ? ", waits for other queue" : "") << ")" << std::endl;
+	}
+	std::cout << "\tEnd of frame (" << Barriers.back().size() << " image barriers)" << std::endl;
+
+	for (const auto& Pass : this->Passes)
+	{
+		if (Pass.IsCulled)
+		{
+			std::cout << "\t" << Pass.Name << " culled, its results aren't used." << std::endl;
+		}
+	}
+}
\ No newline at end of file
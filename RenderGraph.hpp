@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "RenderTargetHeap.hpp"
+#include "BarrierRecorder.hpp"
+
+// How pass uses image. Stage and access masks are as narrow as pass really needs, barriers are derived from them.
+struct RenderGraphUsage
+{
+	VkPipelineStageFlags2 StageMask;
+	VkAccessFlags2 AccessMask;
+	VkImageLayout Layout;
+};
+
+// Queue executing pass. Work on async compute queue overlaps with graphics work which doesn't depend on it.
+enum RenderGraphQueue : uint32_t
+{
+	GraphicsGraphQueue,
+	AsyncComputeGraphQueue
+};
+
+// Passed to every pass recorded by graph.
+struct RenderGraphContext
+{
+	VkCommandBuffer CommandBuffer;
+	uint32_t FrameSlot;
+	uint32_t SwapchainImageIndex;
+};
+
+// Frame graph. Passes declare images they read and write, graph orders passes by these dependencies, culls passes
+// whose results aren't used by any output and records barriers between them with minimal stage and access masks.
+// Layouts are tracked across frames: image starts every frame in state left by previous frame, so recorded
+// command buffer is valid for any frame and can be cached. Consecutive passes on the same queue form batch submitted
+// as one command buffer, batches on different queues are synchronized by timeline semaphores instead of barriers.
+class RenderGraph
+{
+private:
+	const RenderTargetHeap* Heap = nullptr;
+
+	struct ImageState
+	{
+		VkImageLayout Layout;
+		VkPipelineStageFlags2 WriteStageMask; // Last write (or layout transition), which following usages have to wait for.
+		VkAccessFlags2 WriteAccessMask;
+		VkPipelineStageFlags2 ReadStageMask; // Reads since last write, which following write has to wait for.
+		VkAccessFlags2 ReadAccessMask;
+		RenderGraphQueue Queue; // Of last usage.
+	};
+
+	struct Resource
+	{
+		std::string Name;
+		VkImage Image;
+		VkImageAspectFlags AspectMask;
+		bool IsImported; // Image is set before every recording, with given state on frame start and end.
+		bool IsOutput;
+		RenderGraphUsage InitialUsage;
+		RenderGraphUsage FinalUsage;
+		ImageState FrameStartState; // Of images owned by graph, equal to state at end of frame.
+	};
+	std::vector<Resource> Resources;
+
+	struct ResourceAccess
+	{
+		uint32_t Resource;
+		RenderGraphUsage Usage;
+		bool IsWrite;
+		bool IsDiscarding; // Previous content isn't needed, so image is transitioned from undefined layout.
+	};
+
+	struct PassNode
+	{
+		std::string Name;
+		FrameStage Stage;
+		RenderGraphQueue Queue;
+		std::function<void(const RenderGraphContext& Context)> Record;
+		std::vector<ResourceAccess> Accesses;
+		bool IsCulled;
+	};
+	std::vector<PassNode> Passes;
+	std::vector<uint32_t> ExecutionOrder;
+	bool IsCompiled = false;
+
+	struct SubmitBatch
+	{
+		RenderGraphQueue Queue;
+		uint32_t FirstPass; // Within execution order.
+		uint32_t PassesCount;
+		VkPipelineStageFlags2 WaitStageMask; // Stages using images last used on other queue.
+	};
+	std::vector<SubmitBatch> Batches;
+
+	// Barriers preceding every executed pass, followed by barriers bringing imported images into their final state.
+	// Stages of every executed pass which use images last used on other queue are returned too.
+	std::vector<std::vector<VkImageMemoryBarrier2>> BuildBarriers(std::vector<ImageState>& States, std::vector<VkPipelineStageFlags2>& WaitStageMasks) const;
+
+	void SortPasses();
+	void CullPasses();
+	void SplitBatches();
+
+public:
+	// Aliasing barriers of heap are recorded before every pass, in the same batch as barriers of pass.
+	RenderGraph(const RenderTargetHeap& Heap);
+
+	// Image owned by passes, its state is carried over from previous frame.
+	uint32_t AddImage(const std::string& Name, VkImage Image, VkImageAspectFlags AspectMask);
+
+	// Image coming from outside of frame (like swapchain image), which enters frame in initial state and must leave it in final state.
+	uint32_t ImportImage(const std::string& Name, VkImageAspectFlags AspectMask, const RenderGraphUsage& InitialUsage, const RenderGraphUsage& FinalUsage);
+
+	// Imported images have to be set before every recording. Images owned by passes change only when recreated.
+	void SetImage(const uint32_t Resource, VkImage Image);
+
+	// Outputs are consumed outside of frame. Passes not contributing to any output are culled.
+	void MarkOutput(const uint32_t Resource);
+
+	uint32_t FindResource(const std::string& Name) const;
+
+	uint32_t AddPass(const std::string& Name, FrameStage Stage, const std::function<void(const RenderGraphContext& Context)>& Record, RenderGraphQueue Queue = GraphicsGraphQueue);
+
+	void Read(const uint32_t Pass, const uint32_t Resource, const RenderGraphUsage& Usage);
+
+	// Discarding write overwrites whole image, so its previous content (and layout) doesn't matter.
+	void Write(const uint32_t Pass, const uint32_t Resource, const RenderGraphUsage& Usage, const bool IsDiscarding);
+
+	// Orders and culls passes, splits them into batches, then computes state in which images start every frame. Must be called after all declarations.
+	// Imported images enter and leave frame on graphics queue, so frame has to start and end with graphics batch.
+	void Compile();
+
+	uint32_t GetBatchesCount() const;
+
+	RenderGraphQueue GetBatchQueue(const uint32_t Batch) const;
+
+	// Batch has to wait for last submission to other queue at these stages. None when batch doesn't depend on other queue.
+	VkPipelineStageFlags2 GetBatchWaitStageMask(const uint32_t Batch) const;
+
+	// Records every executed pass of batch preceded by its barriers. Last batch brings imported images into their final state too.
+	void Record(const uint32_t Batch, const RenderGraphContext& Context) const;
+
+	void ReportPasses() const;
+
+	~RenderGraph() = default;
+};
\ No newline at end of file
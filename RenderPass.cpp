@@ -3,4 +3,42 @@
 RenderPass::RenderPass(VkDevice Device)
 {
 	this->Device = Device;
+}
+
+uint64_t RenderPass::GetContentVersion() const
+{
+	return this->ContentVersion;
+}
+
+void RenderPass::SetExtent(const VkExtent2D& Extent)
+{
+	this->Extent = Extent;
+
+	this->ContentVersion++;
+}
+
+void RenderPass::RecordViewport(VkCommandBuffer CommandBuffer, const VkExtent2D& Extent)
+{
+	const VkViewport Viewport
+	{
+		.x = 0,
+		.y = 0,
+		.width = static_cast<float>(Extent.width),
+		.height = static_cast<float>(Extent.height),
+		.minDepth = 0.0f,
+		.maxDepth = 1.0f
+	};
+
+	const VkRect2D Scissor
+	{
+		.offset
+		{
+			.x = 0,
+			.y = 0
+		},
+		.extent = Extent
+	};
+
+	vkCmdSetViewport(CommandBuffer, 0, 1, &Viewport);
+	vkCmdSetScissor(CommandBuffer, 0, 1, &Scissor);
 }
\ No newline at end of file
@@ -1,18 +1,59 @@
 #pragma once
+#include <cstdint>
 #include <vulkan/vulkan.h>
+#include "RenderTargetHeap.hpp"
+#include "RenderGraph.hpp"
+#include "CPUProfiler.hpp"
+#include "ShaderArchive.hpp"
+
+//#define TUTORIAL_VK_DYNAMIC_RENDERING // Uncomment to record passes with dynamic rendering instead of render pass and framebuffer objects (deferred shading reads G-buffer through VK_KHR_dynamic_rendering_local_read).
+//#define TUTORIAL_VK_ASYNC_COMPUTE // Uncomment to blur variance shadow map by compute pass on async compute queue, overlapped with scene rendering (needs shaders/shadow_map_filtering_comp.spv built by compile_shaders.ps1).
 
 class RenderPass
 {
 protected:
 	VkDevice Device{};
+
+	// Incremented whenever data baked into recorded commands changes.
+	uint64_t ContentVersion = 0;
+
+	// Size of screen-sized render targets and of area they are rendered in.
+	VkExtent2D Extent{ .width = 1600, .height = 900 };
+
+	// Viewport and scissor are dynamic state of every pipeline, so pipelines don't depend on resolution.
+	// Secondary command buffers don't inherit dynamic state, so each of them records it too.
+	static void RecordViewport(VkCommandBuffer CommandBuffer, const VkExtent2D& Extent);
 public:
 	RenderPass(VkDevice Device);
 
+	uint64_t GetContentVersion() const;
+
+	// Takes effect once render targets are freed, declared and set up again. Pipelines stay valid.
+	virtual void SetExtent(const VkExtent2D& Extent);
+
 	virtual void FreeGPUResources() = 0;
 
-	virtual void SetupShaders() = 0;
+	// Creates images used as render targets. Memory of images declared in heap is bound once heap is committed.
+	virtual void DeclareRenderTargets(RenderTargetHeap& Heap) = 0;
+
+	// Creates views, framebuffers and descriptors referencing render targets. Called after heap is committed.
+	virtual void SetupRenderTargets() = 0;
+
+	virtual void FreeRenderTargets() = 0;
+
+	// Registers render targets in graph and declares how given graph pass reads and writes them. Attachments are kept
+	// in layouts declared here, so render pass neither transitions them nor depends on commands outside of it.
+	// Attachments living only within one render pass aren't registered at all.
+	virtual void DeclareGraphUsage(RenderGraph& Graph, const uint32_t GraphPass) = 0;
+
+	// Points graph at images registered by DeclareGraphUsage, after render targets have been declared again.
+	virtual void UpdateGraphImages(RenderGraph& Graph) = 0;
+
+	// Shader modules belong to archive, which outlives pipelines created from them.
+	virtual void SetupShaders(ShaderArchive& Shaders) = 0;
 
-	virtual void SetupPipeline() = 0;
+	// Pipelines are created through cache shared by all passes.
+	virtual void SetupPipeline(VkPipelineCache PipelineCache) = 0;
 
 	virtual ~RenderPass() = default;
 };
\ No newline at end of file
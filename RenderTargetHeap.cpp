@@ -0,0 +1,215 @@
+#include "RenderTargetHeap.hpp"
+#include "Helpers.hpp"
+#include "GPUMemoryTracker.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <iostream>
+
+static bool LifetimesOverlap(FrameStage FirstA, FrameStage LastA, FrameStage FirstB, FrameStage LastB)
+{
+	return FirstA <= LastB && FirstB <= LastA;
+}
+
+static bool RangesOverlap(VkDeviceSize OffsetA, VkDeviceSize SizeA, VkDeviceSize OffsetB, VkDeviceSize SizeB)
+{
+	return OffsetA < OffsetB + SizeB && OffsetB < OffsetA + SizeA;
+}
+
+RenderTargetHeap::RenderTargetHeap(VkDevice Device, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties)
+{
+	this->Device = Device;
+	this->DeviceMemoryProperties = &DeviceMemoryProperties;
+}
+
+VkImage RenderTargetHeap::DeclareImage(const VkImageCreateInfo& CreationInfo, const std::string& Owner, const std::string& Purpose, FrameStage FirstUse, FrameStage LastUse, VkPipelineStageFlags2 StageMask, VkAccessFlags2 AccessMask)
+{
+	RenderTarget Target
+	{
+		.Image = VK_NULL_HANDLE,
+		.MemoryRequirements = {},
+		.FirstUse = FirstUse,
+		.LastUse = LastUse,
+		.StageMask = StageMask,
+		.AccessMask = AccessMask,
+		.Offset = 0
+	};
+
+	GPUMemory.CreateImage(Device, CreationInfo, Target.Image, Owner, Purpose);
+	vkGetImageMemoryRequirements(Device, Target.Image, &Target.MemoryRequirements);
+
+	this->RenderTargets.push_back(Target);
+
+	return Target.Image;
+}
+
+void RenderTargetHeap::PlaceRenderTargets()
+{
+	// Greedy placement, biggest targets first. Every target takes lowest offset which doesn't collide with targets alive in the same time.
+	std::vector<size_t> PlacementOrder(this->RenderTargets.size());
+	std::iota(PlacementOrder.begin(), PlacementOrder.end(), 0);
+	std::stable_sort(PlacementOrder.begin(), PlacementOrder.end(), [this](size_t A, size_t B)
+	{
+		return this->RenderTargets[A].MemoryRequirements.size > this->RenderTargets[B].MemoryRequirements.size;
+	});
+
+	std::vector<size_t> PlacedTargets;
+	this->HeapSize = 0;
+
+	for (const auto TargetID : PlacementOrder)
+	{
+		auto& Target = this->RenderTargets[TargetID];
+
+		std::vector<VkDeviceSize> CandidateOffsets{ 0 };
+		for (const auto PlacedID : PlacedTargets)
+		{
+			const auto& Placed = this->RenderTargets[PlacedID];
+			if (LifetimesOverlap(Target.FirstUse, Target.LastUse, Placed.FirstUse, Placed.LastUse))
+			{
+				CandidateOffsets.push_back(AlignUp(Placed.Offset + Placed.MemoryRequirements.size, Target.MemoryRequirements.alignment));
+			}
+		}
+		std::sort(CandidateOffsets.begin(), CandidateOffsets.end());
+
+		for (const auto Offset : CandidateOffsets)
+		{
+			bool IsCollisionFree = true;
+			for (const auto PlacedID : PlacedTargets)
+			{
+				const auto& Placed = this->RenderTargets[PlacedID];
+				if (LifetimesOverlap(Target.FirstUse, Target.LastUse, Placed.FirstUse, Placed.LastUse) && RangesOverlap(Offset, Target.MemoryRequirements.size, Placed.Offset, Placed.MemoryRequirements.size))
+				{
+					IsCollisionFree = false;
+					break;
+				}
+			}
+
+			if (IsCollisionFree)
+			{
+				Target.Offset = Offset;
+				break;
+			}
+		}
+
+		PlacedTargets.push_back(TargetID);
+		this->HeapSize = std::max(this->HeapSize, Target.Offset + Target.MemoryRequirements.size);
+	}
+}
+
+void RenderTargetHeap::ComputeAliasingBarriers()
+{
+	for (auto& AliasingBarrier : this->AliasingBarriers)
+	{
+		AliasingBarrier.IsRequired = false;
+		AliasingBarrier.Barrier =
+		{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+			.pNext = nullptr,
+			.srcStageMask = VK_PIPELINE_STAGE_2_NONE,
+			.srcAccessMask = VK_ACCESS_2_NONE,
+			.dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+			.dstAccessMask = VK_ACCESS_2_NONE
+		};
+	}
+
+	// Target starting its lifetime has to wait for every other target which used the same memory earlier.
+	// Targets used later in frame are covered too, because they have been used by previous frame.
+	for (const auto& Target : this->RenderTargets)
+	{
+		for (const auto& OtherTarget : this->RenderTargets)
+		{
+			if (&Target == &OtherTarget)
+				continue;
+
+			if (LifetimesOverlap(Target.FirstUse, Target.LastUse, OtherTarget.FirstUse, OtherTarget.LastUse))
+				continue;
+
+			if (!RangesOverlap(Target.Offset, Target.MemoryRequirements.size, OtherTarget.Offset, OtherTarget.MemoryRequirements.size))
+				continue;
+
+			auto& AliasingBarrier = this->AliasingBarriers[Target.FirstUse];
+			AliasingBarrier.IsRequired = true;
+			AliasingBarrier.Barrier.srcStageMask |= OtherTarget.StageMask;
+			AliasingBarrier.Barrier.srcAccessMask |= OtherTarget.AccessMask;
+			AliasingBarrier.Barrier.dstStageMask |= Target.StageMask;
+			AliasingBarrier.Barrier.dstAccessMask |= Target.AccessMask;
+		}
+	}
+}
+
+void RenderTargetHeap::Commit()
+{
+	if (this->RenderTargets.empty())
+		return;
+
+	PlaceRenderTargets();
+	ComputeAliasingBarriers();
+
+	// Allocate memory.
+	{
+		uint32_t SupportedMemoryTypes = UINT32_MAX;
+		for (const auto& Target : this->RenderTargets)
+		{
+			SupportedMemoryTypes &= Target.MemoryRequirements.memoryTypeBits;
+		}
+
+		if (!SupportedMemoryTypes)
+		{
+			std::cerr << "Render targets don't share any memory type." << std::endl;
+			exit(0);
+		}
+
+		VkMemoryAllocateInfo AllocationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+			.pNext = nullptr,
+			.allocationSize = this->HeapSize,
+			.memoryTypeIndex = QueryMemoryTypeIndex(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, SupportedMemoryTypes, *this->DeviceMemoryProperties)
+		};
+
+		GPUMemory.AllocateMemory(Device, AllocationInfo, this->HeapMemory, "RenderTargetHeap", "Aliased render targets");
+	}
+
+	// Bind images.
+	for (const auto& Target : this->RenderTargets)
+	{
+		GPUMemory.BindImageMemory(Device, Target.Image, this->HeapMemory, Target.Offset);
+	}
+}
+
+void RenderTargetHeap::AddAliasingBarriers(BarrierRecorder& Barriers, FrameStage Stage) const
+{
+	const auto& AliasingBarrier = this->AliasingBarriers[Stage];
+
+	if (!AliasingBarrier.IsRequired)
+		return;
+
+	Barriers.AddMemoryBarrier(AliasingBarrier.Barrier);
+}
+
+void RenderTargetHeap::ReportFootprint() const
+{
+	VkDeviceSize SeparateSize = 0;
+	for (const auto& Target : this->RenderTargets)
+	{
+		SeparateSize += AlignUp(Target.MemoryRequirements.size, Target.MemoryRequirements.alignment);
+	}
+
+	if (!SeparateSize)
+		return;
+
+	std::cout << "Render targets memory: " << this->HeapSize / 1024 / 1024 << "MB aliased, " << SeparateSize / 1024 / 1024 << "MB without aliasing (" << 100 - this->HeapSize * 100 / SeparateSize << "% saved)." << std::endl;
+}
+
+void RenderTargetHeap::FreeGPUResources()
+{
+	for (const auto& Target : this->RenderTargets)
+	{
+		GPUMemory.DestroyImage(Device, Target.Image);
+	}
+	this->RenderTargets.clear();
+
+	GPUMemory.FreeMemory(Device, this->HeapMemory);
+	this->HeapMemory = VK_NULL_HANDLE;
+	this->HeapSize = 0;
+}
\ No newline at end of file
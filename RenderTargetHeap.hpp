@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "BarrierRecorder.hpp"
+
+// Order in which frame uses render targets. Lifetimes of render targets are expressed in these stages.
+enum FrameStage : uint32_t
+{
+	ShadowMapGenerationStage, // Shadow map rasterization and its filtering.
+	SceneRenderingStage, // G-buffer generation and deferred shading, subpasses of one render pass.
+	PresentationStage,
+	FrameStagesCount
+};
+
+// Places render targets within one VkDeviceMemory. Targets whose lifetimes within frame don't overlap
+// are bound to overlapping memory ranges, so memory is shared between them.
+class RenderTargetHeap
+{
+private:
+	VkDevice Device{};
+	const VkPhysicalDeviceMemoryProperties2* DeviceMemoryProperties = nullptr;
+
+	struct RenderTarget
+	{
+		VkImage Image;
+		VkMemoryRequirements MemoryRequirements;
+		FrameStage FirstUse;
+		FrameStage LastUse;
+		VkPipelineStageFlags2 StageMask;
+		VkAccessFlags2 AccessMask;
+		VkDeviceSize Offset;
+	};
+	std::vector<RenderTarget> RenderTargets;
+
+	VkDeviceMemory HeapMemory{};
+	VkDeviceSize HeapSize = 0;
+
+	// Global barriers which have to precede given stage, because its render targets reuse memory of other render targets.
+	struct StageAliasingBarrier
+	{
+		bool IsRequired;
+		VkMemoryBarrier2 Barrier;
+	};
+	std::vector<StageAliasingBarrier> AliasingBarriers = std::vector<StageAliasingBarrier>(FrameStage::FrameStagesCount);
+
+	void PlaceRenderTargets();
+	void ComputeAliasingBarriers();
+
+public:
+	RenderTargetHeap(VkDevice Device, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties);
+
+	// Creates image without memory. Memory is bound during Commit. Stage and access masks describe every usage of image within frame.
+	VkImage DeclareImage(const VkImageCreateInfo& CreationInfo, const std::string& Owner, const std::string& Purpose, FrameStage FirstUse, FrameStage LastUse, VkPipelineStageFlags2 StageMask, VkAccessFlags2 AccessMask);
+
+	// Computes placement of all declared images, allocates heap memory and binds images.
+	void Commit();
+
+	// Adds barrier which has to precede given stage into barriers recorded before it.
+	void AddAliasingBarriers(BarrierRecorder& Barriers, FrameStage Stage) const;
+
+	void ReportFootprint() const;
+
+	// Destroys all declared images and heap memory.
+	void FreeGPUResources();
+
+	~RenderTargetHeap() = default;
+};
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "ShaderArchive.hpp"
+#include "CPUProfiler.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(ShaderArchive::ArchiveHeader) == 16 && sizeof(ShaderArchive::ArchiveEntry) == 88, "Layout of archive has to match compile_shaders.ps1.");
+
+ShaderArchive::ShaderArchive(VkDevice Device, const std::string& FilePath)
+{
+	TUTORIAL_VK_PROFILE_ZONE("ShaderArchive::ShaderArchive");
+
+	this->Device = Device;
+
+	MapFile(FilePath);
+
+	// Validate layout, so modules can be created from mapped memory without further checks.
+	ArchiveHeader Header{};
+	if (this->MappedSize >= sizeof(Header))
+	{
+		std::memcpy(&Header, this->MappedData, sizeof(Header));
+	}
+	if (Header.Magic != Magic || Header.Version != Version || this->MappedSize < sizeof(Header) + Header.ModulesCount * sizeof(ArchiveEntry))
+	{
+		std::cerr << "Shader archive " << FilePath << " is corrupted or made by other version of compile_shaders.ps1." << std::endl;
+		exit(0);
+	}
+
+	this->Entries = reinterpret_cast<const ArchiveEntry*>(this->MappedData + sizeof(Header));
+	this->EntriesCount = Header.ModulesCount;
+
+	for (uint32_t i = 0; i < this->EntriesCount; i++)
+	{
+		const auto& Entry = this->Entries[i];
+
+		// Offset and size are compared separately, so their sum can't overflow.
+		const bool IsInFile = Entry.Size != 0 && Entry.Offset <= this->MappedSize && Entry.Size <= this->MappedSize - Entry.Offset;
+		if (Entry.Name[MaxNameLength - 1] != '\0' || Entry.Offset % ModuleAlignment != 0 || Entry.Size % sizeof(uint32_t) != 0 || !IsInFile)
+		{
+			std::cerr << "Shader archive " << FilePath << " has invalid entry of module " << i << "." << std::endl;
+			exit(0);
+		}
+	}
+}
+
+void ShaderArchive::MapFile(const std::string& FilePath)
+{
+#ifdef _WIN32
+	HANDLE File = CreateFileA(FilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER FileSize{};
+	if (File == INVALID_HANDLE_VALUE || !GetFileSizeEx(File, &FileSize) || FileSize.QuadPart == 0)
+	{
+		std::cerr << "Failed to open shader archive " << FilePath << ", run compile_shaders.ps1." << std::endl;
+		exit(0);
+	}
+
+	HANDLE Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* MappedView = Mapping ? MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!MappedView)
+	{
+		std::cerr << "Failed to map shader archive " << FilePath << "." << std::endl;
+		exit(0);
+	}
+
+	this->FileHandle = File;
+	this->MappingHandle = Mapping;
+	this->MappedData = static_cast<const uint8_t*>(MappedView);
+	this->MappedSize = static_cast<size_t>(FileSize.QuadPart);
+#else
+	const int File = open(FilePath.c_str(), O_RDONLY);
+	struct stat FileStatus{};
+	if (File < 0 || fstat(File, &FileStatus) != 0 || FileStatus.st_size == 0)
+	{
+		std::cerr << "Failed to open shader archive " << FilePath << ", run compile_shaders.ps1." << std::endl;
+		exit(0);
+	}
+
+	void* MappedView = mmap(nullptr, FileStatus.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+	if (MappedView == MAP_FAILED)
+	{
+		std::cerr << "Failed to map shader archive " << FilePath << "." << std::endl;
+		exit(0);
+	}
+
+	// Mapping stays valid after its file is closed.
+	close(File);
+
+	this->MappedData = static_cast<const uint8_t*>(MappedView);
+	this->MappedSize = static_cast<size_t>(FileStatus.st_size);
+#endif
+}
+
+void ShaderArchive::UnmapFile()
+{
+	if (!this->MappedData)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(this->MappedData);
+	CloseHandle(this->MappingHandle);
+	CloseHandle(this->FileHandle);
+#else
+	munmap(const_cast<uint8_t*>(this->MappedData), this->MappedSize);
+#endif
+
+	this->MappedData = nullptr;
+	this->MappedSize = 0;
+	this->Entries = nullptr;
+	this->EntriesCount = 0;
+}
+
+void ShaderArchive::FreeGPUResources()
+{
+	for (const auto& [Hash, Created] : this->Modules)
+	{
+		vkDestroyShaderModule(Device, Created.Module, nullptr);
+	}
+	this->Modules.clear();
+
+	UnmapFile();
+}
+
+VkShaderModule ShaderArchive::GetModule(const std::string& Name)
+{
+	const ArchiveEntry* FoundEntry = nullptr;
+	for (uint32_t i = 0; i < this->EntriesCount; i++)
+	{
+		if (Name == this->Entries[i].Name)
+		{
+			FoundEntry = &this->Entries[i];
+			break;
+		}
+	}
+
+	if (!FoundEntry)
+	{
+		std::cerr << "Shader module " << Name << " isn't in shader archive, run compile_shaders.ps1." << std::endl;
+		exit(0);
+	}
+
+	std::lock_guard<std::mutex> Lock(this->ModulesMutex);
+
+	const auto [FirstCreated, LastCreated] = this->Modules.equal_range(FoundEntry->Hash);
+	for (auto Created = FirstCreated; Created != LastCreated; Created++)
+	{
+		const ArchiveEntry* CreatedEntry = Created->second.Entry;
+		if (CreatedEntry->Size == FoundEntry->Size && std::memcmp(this->MappedData + CreatedEntry->Offset, this->MappedData + FoundEntry->Offset, static_cast<size_t>(FoundEntry->Size)) == 0)
+			return Created->second.Module;
+	}
+
+	VkShaderModule Module = VK_NULL_HANDLE;
+	{
+		VkShaderModuleCreateInfo CreationInfo
+		{
+			.sType = VkStructureType::VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.codeSize = static_cast<size_t>(FoundEntry->Size),
+			.pCode = reinterpret_cast<const uint32_t*>(this->MappedData + FoundEntry->Offset)
+		};
+
+		vkCreateShaderModule(Device, &CreationInfo, nullptr, &Module);
+	}
+	this->Modules.emplace(FoundEntry->Hash, CreatedModule{ .Entry = FoundEntry, .Module = Module });
+
+	return Module;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+
+// Every SPIR-V module of application packed by compile_shaders.ps1 into one file, which is mapped into memory at startup.
+// Modules are created straight from mapped words and shared when their code is identical, so identical modules are created once.
+// Archive starts with header, followed by entry of every module and words of modules, each aligned to ModuleAlignment.
+class ShaderArchive
+{
+public:
+	static constexpr uint32_t Magic = 0x41565053; // "SPVA" in little endian.
+	static constexpr uint32_t Version = 1;
+	static constexpr uint32_t ModuleAlignment = 16;
+	static constexpr uint32_t MaxNameLength = 64; // Including terminating zero.
+
+	struct ArchiveHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t ModulesCount;
+		uint32_t Reserved;
+	};
+
+	struct ArchiveEntry
+	{
+		char Name[MaxNameLength]; // File name of module, zero padded.
+		uint64_t Hash; // First 8 bytes of SHA-256 of module code.
+		uint64_t Offset; // From beginning of archive.
+		uint64_t Size; // In bytes.
+	};
+
+private:
+	VkDevice Device{};
+
+	const uint8_t* MappedData = nullptr;
+	size_t MappedSize = 0;
+
+	// Handles of file and its mapping, used only on Windows.
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+
+	const ArchiveEntry* Entries = nullptr;
+	uint32_t EntriesCount = 0;
+
+	struct CreatedModule
+	{
+		const ArchiveEntry* Entry; // Code module was created from.
+		VkShaderModule Module;
+	};
+
+	// Passes setup their shaders on several startup workers.
+	std::mutex ModulesMutex;
+	std::unordered_multimap<uint64_t, CreatedModule> Modules; // By hash of module code. Hash only narrows search, code is compared before sharing.
+
+	void MapFile(const std::string& FilePath);
+	void UnmapFile();
+
+public:
+	ShaderArchive(VkDevice Device, const std::string& FilePath);
+
+	// Destroys every created module, so pipelines using them have to be created already.
+	void FreeGPUResources();
+
+	// Module is owned by archive and may be shared by several passes.
+	VkShaderModule GetModule(const std::string& Name);
+
+	~ShaderArchive() = default;
+};
\ No newline at end of file
@@ -0,0 +1,327 @@
+#include "ShadowMapFilteringPass.hpp"
+#include "Helpers.hpp"
+#include "BarrierRecorder.hpp"
+
+ShadowMapFilteringPass::ShadowMapFilteringPass(VkDevice Device, const uint32_t ComputeQueueIndex, VkImageView* VarianceShadowMapView) : RenderPass(Device)
+{
+	TUTORIAL_VK_PROFILE_ZONE("ShadowMapFilteringPass::ShadowMapFilteringPass");
+
+	this->ComputeQueueIndex = ComputeQueueIndex;
+	this->VarianceShadowMapView = VarianceShadowMapView;
+
+	// Setup pipeline layout.
+	{
+		// Setup descriptor set layout. Both blurs read one storage image and write other one.
+		{
+			std::vector<VkDescriptorSetLayoutBinding> SetLayoutBindings
+			{
+				VkDescriptorSetLayoutBinding
+				{
+					.binding = 0,
+					.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+					.descriptorCount = 1,
+					.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+					.pImmutableSamplers = nullptr
+				},
+				VkDescriptorSetLayoutBinding
+				{
+					.binding = 1,
+					.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+					.descriptorCount = 1,
+					.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+					.pImmutableSamplers = nullptr
+				}
+			};
+
+			VkDescriptorSetLayoutCreateInfo CreationInfo
+			{
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.bindingCount = static_cast<uint32_t>(SetLayoutBindings.size()),
+				.pBindings = SetLayoutBindings.data()
+			};
+
+			vkCreateDescriptorSetLayout(Device, &CreationInfo, nullptr, &this->FilteringDescriptorSetLayout);
+		}
+
+		// Direction of blur.
+		VkPushConstantRange PushConstantRange
+		{
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+			.offset = 0,
+			.size = 2 * sizeof(int32_t)
+		};
+
+		VkPipelineLayoutCreateInfo CreationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.setLayoutCount = 1,
+			.pSetLayouts = &this->FilteringDescriptorSetLayout,
+			.pushConstantRangeCount = 1,
+			.pPushConstantRanges = &PushConstantRange
+		};
+
+		vkCreatePipelineLayout(Device, &CreationInfo, nullptr, &this->PipelineLayout);
+	}
+
+	// Setup descriptor sets.
+	{
+		// Setup descriptor pool.
+		{
+			VkDescriptorPoolSize StorageImagesPool
+			{
+				.type = VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+				.descriptorCount = 2 * static_cast<uint32_t>(this->FilteringDescriptorSets.size())
+			};
+
+			VkDescriptorPoolCreateInfo CreationInfo
+			{
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.maxSets = static_cast<uint32_t>(this->FilteringDescriptorSets.size()),
+				.poolSizeCount = 1,
+				.pPoolSizes = &StorageImagesPool
+			};
+
+			vkCreateDescriptorPool(Device, &CreationInfo, nullptr, &this->FilteringDescriptorPool);
+		}
+
+		const std::vector<VkDescriptorSetLayout> SetLayouts(this->FilteringDescriptorSets.size(), this->FilteringDescriptorSetLayout);
+
+		VkDescriptorSetAllocateInfo AllocateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+			.pNext = nullptr,
+			.descriptorPool = this->FilteringDescriptorPool,
+			.descriptorSetCount = static_cast<uint32_t>(SetLayouts.size()),
+			.pSetLayouts = SetLayouts.data()
+		};
+
+		vkAllocateDescriptorSets(Device, &AllocateInfo, this->FilteringDescriptorSets.data());
+	}
+}
+
+void ShadowMapFilteringPass::DeclareRenderTargets(RenderTargetHeap& Heap)
+{
+	VkImageCreateInfo CreationInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.imageType = VkImageType::VK_IMAGE_TYPE_2D,
+		.format = ShadowMapGenerationPass::VarianceShadowMapFormat,
+		.extent =
+		{
+			.width = ShadowMapGenerationPass::ShadowMapResolution,
+			.height = ShadowMapGenerationPass::ShadowMapResolution,
+			.depth = 1
+		},
+		.mipLevels = 1,
+		.arrayLayers = 1,
+		.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
+		.tiling = VkImageTiling::VK_IMAGE_TILING_OPTIMAL,
+		.usage = VkImageUsageFlagBits::VK_IMAGE_USAGE_STORAGE_BIT,
+		.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
+		.queueFamilyIndexCount = 1,
+		.pQueueFamilyIndices = &this->ComputeQueueIndex,
+		.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED
+	};
+
+	// Lives during whole frame, because filtering may overlap with any graphics work and aliasing barriers don't cross queues.
+	this->IntermediateImage = Heap.DeclareImage(CreationInfo, "ShadowMapFilteringPass", "Shadow map filtering intermediate image", FrameStage::ShadowMapGenerationStage, FrameStage::PresentationStage,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+		VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+}
+
+void ShadowMapFilteringPass::SetupRenderTargets()
+{
+	TUTORIAL_VK_PROFILE_ZONE("ShadowMapFilteringPass::SetupRenderTargets");
+
+	// Setup intermediate image view.
+	{
+		VkImageSubresourceRange RangeInfo
+		{
+			.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1
+		};
+
+		VkImageViewCreateInfo CreationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.image = this->IntermediateImage,
+			.viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D,
+			.format = ShadowMapGenerationPass::VarianceShadowMapFormat,
+			.components =
+			{
+				.r = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.g = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.b = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.a = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY
+			},
+			.subresourceRange = RangeInfo
+		};
+
+		vkCreateImageView(Device, &CreationInfo, nullptr, &this->IntermediateImageView);
+	}
+
+	// Update descriptors. Horizontal blur reads shadow map, vertical one writes it back.
+	{
+		VkDescriptorImageInfo VarianceShadowMapImageInfo
+		{
+			.sampler = VK_NULL_HANDLE,
+			.imageView = *this->VarianceShadowMapView,
+			.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_GENERAL
+		};
+
+		VkDescriptorImageInfo IntermediateImageInfo
+		{
+			.sampler = VK_NULL_HANDLE,
+			.imageView = this->IntermediateImageView,
+			.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_GENERAL
+		};
+
+		const auto MakeWriteSetInfo = [](VkDescriptorSet DescriptorSet, const uint32_t Binding, const VkDescriptorImageInfo* ImageInfo)
+		{
+			return VkWriteDescriptorSet
+			{
+				.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+				.pNext = nullptr,
+				.dstSet = DescriptorSet,
+				.dstBinding = Binding,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+				.pImageInfo = ImageInfo,
+				.pBufferInfo = nullptr,
+				.pTexelBufferView = nullptr
+			};
+		};
+
+		std::vector<VkWriteDescriptorSet> WriteSetInfos
+		{
+			MakeWriteSetInfo(this->FilteringDescriptorSets[0], 0, &VarianceShadowMapImageInfo),
+			MakeWriteSetInfo(this->FilteringDescriptorSets[0], 1, &IntermediateImageInfo),
+			MakeWriteSetInfo(this->FilteringDescriptorSets[1], 0, &IntermediateImageInfo),
+			MakeWriteSetInfo(this->FilteringDescriptorSets[1], 1, &VarianceShadowMapImageInfo)
+		};
+
+		vkUpdateDescriptorSets(Device, static_cast<uint32_t>(WriteSetInfos.size()), WriteSetInfos.data(), 0, nullptr);
+	}
+}
+
+void ShadowMapFilteringPass::DeclareGraphUsage(RenderGraph& Graph, const uint32_t GraphPass)
+{
+	const RenderGraphUsage StorageImageUsage
+	{
+		.StageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+		.AccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+		.Layout = VkImageLayout::VK_IMAGE_LAYOUT_GENERAL
+	};
+
+	// Shadow map is filtered in place, intermediate image is fully overwritten by horizontal blur.
+	Graph.Write(GraphPass, Graph.FindResource("VarianceShadowMap"), StorageImageUsage, false);
+	Graph.Write(GraphPass, Graph.AddImage("ShadowMapFilteringIntermediate", this->IntermediateImage, VK_IMAGE_ASPECT_COLOR_BIT), StorageImageUsage, true);
+}
+
+void ShadowMapFilteringPass::UpdateGraphImages(RenderGraph& Graph)
+{
+	Graph.SetImage(Graph.FindResource("ShadowMapFilteringIntermediate"), this->IntermediateImage);
+}
+
+void ShadowMapFilteringPass::FreeRenderTargets()
+{
+	vkDestroyImageView(Device, this->IntermediateImageView, nullptr);
+	this->IntermediateImageView = VK_NULL_HANDLE;
+}
+
+void ShadowMapFilteringPass::FreeGPUResources()
+{
+	FreeRenderTargets();
+
+	vkDestroyDescriptorPool(Device, this->FilteringDescriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(Device, this->FilteringDescriptorSetLayout, nullptr);
+	vkDestroyPipelineLayout(Device, this->PipelineLayout, nullptr);
+	vkDestroyPipeline(Device, this->Pipeline, nullptr);
+}
+
+void ShadowMapFilteringPass::SetupShaders(ShaderArchive& Shaders)
+{
+	TUTORIAL_VK_PROFILE_ZONE("ShadowMapFilteringPass::SetupShaders");
+
+	this->FilteringComputeShaderModule = Shaders.GetModule("shadow_map_filtering_comp.spv");
+
+	this->ShaderStage =
+	{
+		.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.stage = VkShaderStageFlagBits::VK_SHADER_STAGE_COMPUTE_BIT,
+		.module = this->FilteringComputeShaderModule,
+		.pName = "main",
+		.pSpecializationInfo = nullptr
+	};
+}
+
+void ShadowMapFilteringPass::SetupPipeline(VkPipelineCache PipelineCache)
+{
+	TUTORIAL_VK_PROFILE_ZONE("ShadowMapFilteringPass::SetupPipeline");
+
+	VkComputePipelineCreateInfo PipelineCreationInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.stage = this->ShaderStage,
+		.layout = this->PipelineLayout,
+		.basePipelineHandle = VK_NULL_HANDLE,
+		.basePipelineIndex = -1
+	};
+
+	vkCreateComputePipelines(Device, PipelineCache, 1, &PipelineCreationInfo, nullptr, &this->Pipeline);
+}
+
+void ShadowMapFilteringPass::RecordCommandBuffer(VkCommandBuffer CommandBuffer)
+{
+	TUTORIAL_VK_PROFILE_ZONE("ShadowMapFilteringPass::RecordCommandBuffer");
+
+	const uint32_t WorkgroupsCount = (ShadowMapGenerationPass::ShadowMapResolution + WorkgroupSize - 1) / WorkgroupSize;
+	const int32_t Directions[2][2] =
+	{
+		{ 1, 0 },
+		{ 0, 1 }
+	};
+
+	vkCmdBindPipeline(CommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_COMPUTE, this->Pipeline);
+
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		// Vertical blur reads intermediate image written by horizontal one and overwrites shadow map read by it.
+		if (i > 0)
+		{
+			BarrierRecorder Barriers;
+			Barriers.AddMemoryBarrier(
+			{
+				.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+				.pNext = nullptr,
+				.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+				.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT
+			});
+			Barriers.Flush(CommandBuffer);
+		}
+
+		vkCmdBindDescriptorSets(CommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_COMPUTE, this->PipelineLayout, 0, 1, &this->FilteringDescriptorSets[i], 0, nullptr);
+		vkCmdPushConstants(CommandBuffer, this->PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Directions[i]), Directions[i]);
+		vkCmdDispatch(CommandBuffer, WorkgroupsCount, WorkgroupsCount, 1);
+	}
+}
\ No newline at end of file
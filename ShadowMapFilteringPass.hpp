@@ -0,0 +1,54 @@
+#pragma once
+
+#include "RenderPass.hpp"
+#include <vector>
+#include "ShadowMapGenerationPass.hpp"
+
+// Separable Gaussian blur of variance shadow map moments, softening shadow edges. Shadow map is blurred horizontally
+// into intermediate image and vertically back into shadow map by compute shader, so pass can run on async compute queue.
+class ShadowMapFilteringPass : public RenderPass
+{
+private:
+	VkImage IntermediateImage{};
+	VkImageView IntermediateImageView{};
+
+	VkImageView* VarianceShadowMapView = nullptr;
+
+	VkShaderModule FilteringComputeShaderModule;
+	VkPipelineShaderStageCreateInfo ShaderStage{};
+
+	VkDescriptorSetLayout FilteringDescriptorSetLayout;
+	VkDescriptorPool FilteringDescriptorPool;
+	std::vector<VkDescriptorSet> FilteringDescriptorSets = std::vector<VkDescriptorSet>(2); // Horizontal blur, then vertical one.
+
+	VkPipelineLayout PipelineLayout;
+	VkPipeline Pipeline;
+
+	static constexpr uint32_t WorkgroupSize = 16;
+
+	uint32_t ComputeQueueIndex = 0;
+
+public:
+	ShadowMapFilteringPass(VkDevice Device, const uint32_t ComputeQueueIndex, VkImageView* VarianceShadowMapView);
+
+	virtual void FreeGPUResources() override;
+
+	virtual void DeclareRenderTargets(RenderTargetHeap& Heap) override;
+
+	virtual void SetupRenderTargets() override;
+
+	virtual void FreeRenderTargets() override;
+
+	virtual void DeclareGraphUsage(RenderGraph& Graph, const uint32_t GraphPass) override;
+
+	virtual void UpdateGraphImages(RenderGraph& Graph) override;
+
+	virtual void SetupShaders(ShaderArchive& Shaders) override;
+
+	virtual void SetupPipeline(VkPipelineCache PipelineCache) override;
+
+	// Recorded outside of any render pass, on graphics or compute queue.
+	void RecordCommandBuffer(VkCommandBuffer CommandBuffer);
+
+	virtual ~ShadowMapFilteringPass() = default;
+};
\ No newline at end of file
@@ -4,181 +4,16 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-ShadowMapGenerationPass::ShadowMapGenerationPass(VkDevice Device, const uint32_t GraphicsQueueIndex, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties) : RenderPass(Device)
+ShadowMapGenerationPass::ShadowMapGenerationPass(VkDevice Device, const uint32_t GraphicsQueueIndex, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties, UniformRingBuffer& FrameUniforms) : RenderPass(Device)
 {
-	// Shadow map creation.
-	{
-		const auto MipMapLevels = log(this->ShadowMapResolution) + 1;
-
-		// Setup image.
-		{
-			VkImageCreateInfo CreationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-				.pNext = nullptr,
-				.flags = 0,
-				.imageType = VkImageType::VK_IMAGE_TYPE_2D,
-				.format = VkFormat::VK_FORMAT_R32G32_SFLOAT,
-				.extent =
-				{
-					.width = ShadowMapResolution,
-					.height = ShadowMapResolution,
-					.depth = 1
-				},
-				.mipLevels = static_cast<uint32_t>(MipMapLevels),
-				.arrayLayers = 1,
-				.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
-				.tiling = VkImageTiling::VK_IMAGE_TILING_OPTIMAL,
-				.usage = VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_SAMPLED_BIT,
-				.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
-				.queueFamilyIndexCount = 1,
-				.pQueueFamilyIndices = &GraphicsQueueIndex,
-				.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED
-			};
-
-			vkCreateImage(Device, &CreationInfo, nullptr, &this->VarianceShadowMap);
-		}
-		// Allocate memory.
-		{
-			VkMemoryRequirements MemoryRequirements;
-			vkGetImageMemoryRequirements(Device, this->VarianceShadowMap, &MemoryRequirements);
-
-			const auto MemorySegments = ComputeMemorySegments(MemoryRequirements);
-
-			VkMemoryAllocateInfo AllocationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-				.pNext = nullptr,
-				.allocationSize = MemorySegments.SegmentsCount * MemorySegments.SegmentSize,
-				.memoryTypeIndex = QueryMemoryTypeIndex(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryRequirements.memoryTypeBits, DeviceMemoryProperties)
-			};
+	TUTORIAL_VK_PROFILE_ZONE("ShadowMapGenerationPass::ShadowMapGenerationPass");
 
-			vkAllocateMemory(Device, &AllocationInfo, nullptr, &this->VarianceShadowMapMemory);
-
-			vkBindImageMemory(Device, this->VarianceShadowMap, this->VarianceShadowMapMemory, 0);
-		}
-
-		// Setup image view.
-		{
-			VkImageSubresourceRange Range
-			{
-				.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT,
-				.baseMipLevel = 0,
-				.levelCount = 1,
-				.baseArrayLayer = 0,
-				.layerCount = 1
-			};
-
-			VkImageViewCreateInfo ViewCreationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-				.pNext = nullptr,
-				.flags = 0,
-				.image = this->VarianceShadowMap,
-				.viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D,
-				.format = VkFormat::VK_FORMAT_R32G32_SFLOAT,
-				.components =
-				{
-					.r = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-					.g = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-					.b = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-					.a = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY
-				},
-				.subresourceRange = Range
-			};
-
-			vkCreateImageView(Device, &ViewCreationInfo, nullptr, &this->VarianceShadowMapView);
-
-			this->SharedResources.VarianceShadowMap = &this->VarianceShadowMapView;
-		}
-	}
-
-	// Setup depth buffer.
-	{
-		// Create image.
-		{
-			VkImageCreateInfo CreationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-				.pNext = nullptr,
-				.flags = 0,
-				.imageType = VkImageType::VK_IMAGE_TYPE_2D,
-				.format = VkFormat::VK_FORMAT_D32_SFLOAT,
-				.extent =
-				{
-					.width = ShadowMapResolution,
-					.height = ShadowMapResolution,
-					.depth = 1
-				},
-				.mipLevels = 1,
-				.arrayLayers = 1,
-				.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
-				.tiling = VkImageTiling::VK_IMAGE_TILING_OPTIMAL,
-				.usage = VkImageUsageFlagBits::VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-				.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
-				.queueFamilyIndexCount = 1,
-				.pQueueFamilyIndices = &GraphicsQueueIndex,
-				.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED
-			};
-
-			vkCreateImage(Device, &CreationInfo, nullptr, &this->DepthBuffer);
-		}
-		// Allocate memory.
-		{
-			VkMemoryRequirements MemoryRequirements;
-			vkGetImageMemoryRequirements(Device, this->DepthBuffer, &MemoryRequirements);
-
-			const size_t MemoryToAlign = MemoryRequirements.size % MemoryRequirements.alignment;
-			const size_t MemoryWithoutAlign = (MemoryRequirements.size - MemoryToAlign) / MemoryRequirements.alignment;
-
-			const size_t RequiredSegments = MemoryWithoutAlign + (MemoryToAlign > 0 ? 1 : 0);
-
-			VkMemoryAllocateInfo AllocationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-				.pNext = nullptr,
-				.allocationSize = RequiredSegments * MemoryRequirements.alignment,
-				.memoryTypeIndex = QueryMemoryTypeIndex(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryRequirements.memoryTypeBits, DeviceMemoryProperties)
-			};
-
-			vkAllocateMemory(Device, &AllocationInfo, nullptr, &this->DepthBufferMemory);
-
-			vkBindImageMemory(Device, this->DepthBuffer, this->DepthBufferMemory, 0);
-		}
-
-		// Setup image view.
-		{
-			VkImageSubresourceRange Range
-			{
-				.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_DEPTH_BIT,
-				.baseMipLevel = 0,
-				.levelCount = 1,
-				.baseArrayLayer = 0,
-				.layerCount = 1
-			};
-
-			VkImageViewCreateInfo ViewCreationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-				.pNext = nullptr,
-				.flags = 0,
-				.image = this->DepthBuffer,
-				.viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D,
-				.format = VkFormat::VK_FORMAT_D32_SFLOAT,
-				.components =
-				{
-					.r = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-					.g = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-					.b = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-					.a = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY
-				},
-				.subresourceRange = Range
-			};
-
-			vkCreateImageView(Device, &ViewCreationInfo, nullptr, &this->DepthBufferView);
-		}
-	}
+	this->GraphicsQueueIndex = GraphicsQueueIndex;
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+	this->FilteringQueueIndex = GraphicsQueueIndex;
+#endif
 
+#ifndef TUTORIAL_VK_DYNAMIC_RENDERING
 	// Setup render pass.
 	{
 		std::vector<VkAttachmentDescription> Attachments
@@ -186,25 +21,25 @@ ShadowMapGenerationPass::ShadowMapGenerationPass(VkDevice Device, const uint32_t
 			VkAttachmentDescription
 			{
 				.flags = 0,
-				.format = VkFormat::VK_FORMAT_R32G32_SFLOAT,
+				.format = VarianceShadowMapFormat,
 				.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
 				.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 				.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_STORE,
 				.stencilLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 				.stencilStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE,
-				.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED,
-				.finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+				.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+				.finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
 			},
 			VkAttachmentDescription
 			{
 				.flags = 0,
-				.format = VkFormat::VK_FORMAT_D32_SFLOAT,
+				.format = DepthBufferFormat,
 				.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
 				.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR,
 				.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_STORE,
 				.stencilLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE,
 				.stencilStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE,
-				.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED,
+				.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
 				.finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL
 			}
 		};
@@ -217,7 +52,7 @@ ShadowMapGenerationPass::ShadowMapGenerationPass(VkDevice Device, const uint32_t
 		VkAttachmentReference DepthAttachment
 		{
 			.attachment = 1,
-			.layout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			.layout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
 		};
 
 		VkSubpassDescription SubpassInfo
@@ -234,17 +69,6 @@ ShadowMapGenerationPass::ShadowMapGenerationPass(VkDevice Device, const uint32_t
 			.pPreserveAttachments = nullptr
 		};
 
-		VkSubpassDependency SubpassDependencies
-		{
-			.srcSubpass = VK_SUBPASS_EXTERNAL,
-			.dstSubpass = 0,
-			.srcStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-			.dstStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-			.srcAccessMask = 0,
-			.dstAccessMask = VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-			.dependencyFlags = 0
-		};
-
 		VkRenderPassCreateInfo RenderPassCreationInfo
 		{
 			.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
@@ -254,99 +78,23 @@ ShadowMapGenerationPass::ShadowMapGenerationPass(VkDevice Device, const uint32_t
 			.pAttachments = Attachments.data(),
 			.subpassCount = 1,
 			.pSubpasses = &SubpassInfo,
-			.dependencyCount = 1,
-			.pDependencies = &SubpassDependencies
+			.dependencyCount = 0,
+			.pDependencies = nullptr
 		};
 
 		vkCreateRenderPass(Device, &RenderPassCreationInfo, nullptr, &this->ShadowMapGenerationRenderPass);
 	}
+#endif
 
 	// Setup light space uniform buffer.
 	{
-		struct LightSpaceBufferContent
-		{
-			glm::mat4 ViewMatrix;
-			glm::mat4 ProjectionMatrix;
-			glm::vec4 LightDirection;
-		};
-
-		const size_t RequestedBufferSize = sizeof(LightSpaceBufferContent);
-
-		// Setup buffer.
-		{
-			VkBufferCreateInfo CreationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-				.pNext = nullptr,
-				.flags = 0,
-				.size = RequestedBufferSize,
-				.usage = VkBufferUsageFlagBits::VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
-				.queueFamilyIndexCount = 1,
-				.pQueueFamilyIndices = &GraphicsQueueIndex
-			};
-
-			vkCreateBuffer(Device, &CreationInfo, nullptr, &this->LightSpaceUniformBuffer);
-		}
-
-		// Allocate memory for buffer.
-		{
-			VkMemoryRequirements MemoryRequirements;
-			vkGetBufferMemoryRequirements(Device, this->LightSpaceUniformBuffer, &MemoryRequirements);
-
-			const VkMemoryPropertyFlagBits MemoryFlags = static_cast<VkMemoryPropertyFlagBits>(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_CACHED_BIT | VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-
-			const auto MemorySegments = ComputeMemorySegments(MemoryRequirements);
-
-			VkMemoryAllocateInfo AllocationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-				.pNext = nullptr,
-				.allocationSize =  MemorySegments.SegmentSize * MemorySegments.SegmentsCount,
-				.memoryTypeIndex = QueryMemoryTypeIndex(MemoryFlags, MemoryRequirements.memoryTypeBits, DeviceMemoryProperties),
-			};
-
-			vkAllocateMemory(Device, &AllocationInfo, nullptr, &this->LightSpaceUniformBufferMemory);
-
-			vkBindBufferMemory(Device, this->LightSpaceUniformBuffer, this->LightSpaceUniformBufferMemory, 0);
-		}
-		
-		// Update buffer content.
-		{
-			const glm::vec3 CameraDirection = glm::normalize(glm::vec3(-10, 25, 4));
-			const glm::vec3 EyePosition = CameraDirection * glm::vec3(20) * glm::vec3(1, -1, 1);
-
-			LightSpaceBufferContent Content
-			{
-				.ViewMatrix = glm::mat4(1.0f),
-				.ProjectionMatrix = glm::mat4(1.0f),
-				.LightDirection = glm::vec4(CameraDirection, 1.0f)
-			};
-
-			Content.ViewMatrix = glm::lookAt(EyePosition, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-			Content.ProjectionMatrix = glm::perspective(glm::radians(90.0f), 2048.0f / 2048.0f, 0.1f, 30.0f);
-			//Content.ProjectionMatrix = glm::ortho(-70.0f, 70.0f, -70.0f, 70.0f, 0.1f, 180.0f);
-
-
-			void* MappedBuffer = nullptr;
-			vkMapMemory(Device, this->LightSpaceUniformBufferMemory, 0, VK_WHOLE_SIZE, 0, &MappedBuffer);
-
-			std::memcpy(MappedBuffer, &Content, sizeof(Content));
-
-			VkMappedMemoryRange MappedMemoryRange
-			{
-				.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-				.pNext = nullptr,
-				.memory = this->LightSpaceUniformBufferMemory,
-				.offset = 0,
-				.size = VK_WHOLE_SIZE
-			};
-			vkFlushMappedMemoryRanges(Device, 1, &MappedMemoryRange);
+		this->FrameUniforms = &FrameUniforms;
+		this->LightSpaceUniformBuffer = FrameUniforms.GetBuffer();
 
-			vkUnmapMemory(Device, this->LightSpaceUniformBufferMemory);
+		SetLightDirection(glm::vec3(-10, 25, 4));
 
-			this->SharedResources.LightSpaceUniformBuffer = &this->LightSpaceUniformBuffer;
-		}
+		this->SharedResources.LightSpaceUniformBuffer = &this->LightSpaceUniformBuffer;
+		this->SharedResources.LightSpaceUniformOffset = &this->LightSpaceUniformOffset;
 	}
 
 	// Setup descriptors.
@@ -356,7 +104,7 @@ ShadowMapGenerationPass::ShadowMapGenerationPass(VkDevice Device, const uint32_t
 			VkDescriptorSetLayoutBinding SetLayoutBinding
 			{
 				.binding = 0,
-				.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				.descriptorCount = 1,
 				.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
 				.pImmutableSamplers = nullptr
@@ -378,7 +126,7 @@ ShadowMapGenerationPass::ShadowMapGenerationPass(VkDevice Device, const uint32_t
 		{
 			VkDescriptorPoolSize DescriptorPoolSizeInfo
 			{
-				.type = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+				.type = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 				.descriptorCount = 1
 			};
 
@@ -421,7 +169,7 @@ ShadowMapGenerationPass::ShadowMapGenerationPass(VkDevice Device, const uint32_t
 				{
 					.buffer = this->LightSpaceUniformBuffer,
 					.offset = 0,
-					.range = VK_WHOLE_SIZE
+					.range = sizeof(LightSpaceContent)
 				};
 
 				VkWriteDescriptorSet DescriptorSetsToUpdate
@@ -432,7 +180,7 @@ ShadowMapGenerationPass::ShadowMapGenerationPass(VkDevice Device, const uint32_t
 					.dstBinding = 0,
 					.dstArrayElement = 0,
 					.descriptorCount = 1,
-					.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+					.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 					.pImageInfo = nullptr,
 					.pBufferInfo = &DescriptorBufferInfo,
 					.pTexelBufferView = nullptr
@@ -458,7 +206,164 @@ ShadowMapGenerationPass::ShadowMapGenerationPass(VkDevice Device, const uint32_t
 
 		vkCreatePipelineLayout(Device, &CreationInfo, nullptr, &this->ShadowMapGenerationPipelineLayout);
 	}
+}
+
+void ShadowMapGenerationPass::DeclareRenderTargets(RenderTargetHeap& Heap)
+{
+	// Shadow map is rendered here and sampled by deferred shading.
+	{
+		const auto MipMapLevels = log(this->ShadowMapResolution) + 1;
+
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+		const uint32_t QueueIndices[] = { this->GraphicsQueueIndex, this->FilteringQueueIndex };
+		const bool IsShared = this->FilteringQueueIndex != this->GraphicsQueueIndex;
+#endif
+
+		VkImageCreateInfo CreationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.imageType = VkImageType::VK_IMAGE_TYPE_2D,
+			.format = VarianceShadowMapFormat,
+			.extent =
+			{
+				.width = ShadowMapResolution,
+				.height = ShadowMapResolution,
+				.depth = 1
+			},
+			.mipLevels = static_cast<uint32_t>(MipMapLevels),
+			.arrayLayers = 1,
+			.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
+			.tiling = VkImageTiling::VK_IMAGE_TILING_OPTIMAL,
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+			.usage = VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_SAMPLED_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_STORAGE_BIT,
+			.sharingMode = IsShared ? VkSharingMode::VK_SHARING_MODE_CONCURRENT : VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
+			.queueFamilyIndexCount = IsShared ? 2u : 1u,
+			.pQueueFamilyIndices = QueueIndices,
+#else
+			.usage = VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_SAMPLED_BIT,
+			.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
+			.queueFamilyIndexCount = 1,
+			.pQueueFamilyIndices = &this->GraphicsQueueIndex,
+#endif
+			.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED
+		};
+
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+		this->VarianceShadowMap = Heap.DeclareImage(CreationInfo, "ShadowMapGenerationPass", "Variance shadow map", FrameStage::ShadowMapGenerationStage, FrameStage::SceneRenderingStage,
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+			VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+#else
+		this->VarianceShadowMap = Heap.DeclareImage(CreationInfo, "ShadowMapGenerationPass", "Variance shadow map", FrameStage::ShadowMapGenerationStage, FrameStage::SceneRenderingStage,
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+			VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+#endif
+	}
+
+	// Depth buffer is needed only during this pass.
+	{
+		VkImageCreateInfo CreationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.imageType = VkImageType::VK_IMAGE_TYPE_2D,
+			.format = DepthBufferFormat,
+			.extent =
+			{
+				.width = ShadowMapResolution,
+				.height = ShadowMapResolution,
+				.depth = 1
+			},
+			.mipLevels = 1,
+			.arrayLayers = 1,
+			.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
+			.tiling = VkImageTiling::VK_IMAGE_TILING_OPTIMAL,
+			.usage = VkImageUsageFlagBits::VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+			.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
+			.queueFamilyIndexCount = 1,
+			.pQueueFamilyIndices = &this->GraphicsQueueIndex,
+			.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED
+		};
 
+		this->DepthBuffer = Heap.DeclareImage(CreationInfo, "ShadowMapGenerationPass", "Shadow map depth buffer", FrameStage::ShadowMapGenerationStage, FrameStage::ShadowMapGenerationStage,
+			VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+	}
+}
+
+void ShadowMapGenerationPass::SetupRenderTargets()
+{
+	TUTORIAL_VK_PROFILE_ZONE("ShadowMapGenerationPass::SetupRenderTargets");
+
+	// Setup shadow map view.
+	{
+		VkImageSubresourceRange Range
+		{
+			.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1
+		};
+
+		VkImageViewCreateInfo ViewCreationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.image = this->VarianceShadowMap,
+			.viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D,
+			.format = VarianceShadowMapFormat,
+			.components =
+			{
+				.r = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.g = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.b = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.a = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY
+			},
+			.subresourceRange = Range
+		};
+
+		vkCreateImageView(Device, &ViewCreationInfo, nullptr, &this->VarianceShadowMapView);
+
+		this->SharedResources.VarianceShadowMap = &this->VarianceShadowMapView;
+	}
+
+	// Setup depth buffer view.
+	{
+		VkImageSubresourceRange Range
+		{
+			.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_DEPTH_BIT,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1
+		};
+
+		VkImageViewCreateInfo ViewCreationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.image = this->DepthBuffer,
+			.viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D,
+			.format = DepthBufferFormat,
+			.components =
+			{
+				.r = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.g = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.b = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
+				.a = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY
+			},
+			.subresourceRange = Range
+		};
+
+		vkCreateImageView(Device, &ViewCreationInfo, nullptr, &this->DepthBufferView);
+	}
+
+#ifndef TUTORIAL_VK_DYNAMIC_RENDERING
 	// Setup framebuffer.
 	{
 		VkImageView Attachments[] = { this->VarianceShadowMapView, DepthBufferView };
@@ -478,12 +383,51 @@ ShadowMapGenerationPass::ShadowMapGenerationPass(VkDevice Device, const uint32_t
 
 		vkCreateFramebuffer(Device, &CreationInfo, nullptr, &ShadowMapGenerationFramebuffer);
 	}
+#endif
+}
+
+void ShadowMapGenerationPass::DeclareGraphUsage(RenderGraph& Graph, const uint32_t GraphPass)
+{
+	const RenderGraphUsage ColorAttachmentUsage
+	{
+		.StageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+		.AccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+		.Layout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+	};
+	const RenderGraphUsage DepthAttachmentUsage
+	{
+		.StageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+		.AccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+		.Layout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL
+	};
+
+	// Neither attachment is loaded.
+	Graph.Write(GraphPass, Graph.AddImage("VarianceShadowMap", this->VarianceShadowMap, VK_IMAGE_ASPECT_COLOR_BIT), ColorAttachmentUsage, true);
+	Graph.Write(GraphPass, Graph.AddImage("ShadowMapDepth", this->DepthBuffer, VK_IMAGE_ASPECT_DEPTH_BIT), DepthAttachmentUsage, true);
+}
+
+void ShadowMapGenerationPass::UpdateGraphImages(RenderGraph& Graph)
+{
+	Graph.SetImage(Graph.FindResource("VarianceShadowMap"), this->VarianceShadowMap);
+	Graph.SetImage(Graph.FindResource("ShadowMapDepth"), this->DepthBuffer);
 }
 
-void ShadowMapGenerationPass::SetupShaders()
+void ShadowMapGenerationPass::FreeRenderTargets()
 {
-	this->ShadowMapGenerationVertexShaderModule = CreateShaderModule(Device, "shaders/shadow_map_generation_vert.spv");
-	this->ShadowMapGenerationFragmentShaderModule = CreateShaderModule(Device, "shaders/shadow_map_generation_frag.spv");
+#ifndef TUTORIAL_VK_DYNAMIC_RENDERING
+	vkDestroyFramebuffer(Device, this->ShadowMapGenerationFramebuffer, nullptr);
+#endif
+
+	vkDestroyImageView(Device, this->VarianceShadowMapView, nullptr);
+	vkDestroyImageView(Device, this->DepthBufferView, nullptr);
+}
+
+void ShadowMapGenerationPass::SetupShaders(ShaderArchive& Shaders)
+{
+	TUTORIAL_VK_PROFILE_ZONE("ShadowMapGenerationPass::SetupShaders");
+
+	this->ShadowMapGenerationVertexShaderModule = Shaders.GetModule("shadow_map_generation_vert.spv");
+	this->ShadowMapGenerationFragmentShaderModule = Shaders.GetModule("shadow_map_generation_frag.spv");
 
 	ShaderStages =
 	{
@@ -510,8 +454,10 @@ void ShadowMapGenerationPass::SetupShaders()
 	};
 }
 
-void ShadowMapGenerationPass::SetupPipeline()
+void ShadowMapGenerationPass::SetupPipeline(VkPipelineCache PipelineCache)
 {
+	TUTORIAL_VK_PROFILE_ZONE("ShadowMapGenerationPass::SetupPipeline");
+
 	std::vector<VkVertexInputBindingDescription> VertexInputBindings
 	{
 		VkVertexInputBindingDescription
@@ -553,39 +499,26 @@ void ShadowMapGenerationPass::SetupPipeline()
 		.primitiveRestartEnable = false
 	};
 
-	VkViewport Viewport
-	{
-		.x = 0,
-		.y = 0,
-		.width = ShadowMapResolution,
-		.height = ShadowMapResolution,
-		.minDepth = 0.0f,
-		.maxDepth = 1.0f
-	};
-
-	VkRect2D Scissor
-	{
-		.offset =
-		{
-			.x = 0,
-			.y = 0
-		},
-		.extent =
-		{
-			.width = ShadowMapResolution,
-			.height = ShadowMapResolution
-		}
-	};
-
+	// Shadow map keeps its resolution, but viewport and scissor are dynamic like in every other pass.
 	VkPipelineViewportStateCreateInfo ViewportStateInfo
 	{
 		.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
 		.pNext = nullptr,
 		.flags = 0,
 		.viewportCount = 1,
-		.pViewports = &Viewport,
+		.pViewports = nullptr,
 		.scissorCount = 1,
-		.pScissors = &Scissor
+		.pScissors = nullptr
+	};
+
+	const VkDynamicState DynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo DynamicStateInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = 0,
+		.dynamicStateCount = 2,
+		.pDynamicStates = DynamicStates
 	};
 
 	VkPipelineRasterizationStateCreateInfo RasterizationStateInfo
@@ -662,10 +595,27 @@ void ShadowMapGenerationPass::SetupPipeline()
 		.pAttachments = &AttachmentBlendStateInfo,
 	};
 
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	VkPipelineRenderingCreateInfo RenderingInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+		.pNext = nullptr,
+		.viewMask = 0,
+		.colorAttachmentCount = 1,
+		.pColorAttachmentFormats = &VarianceShadowMapFormat,
+		.depthAttachmentFormat = DepthBufferFormat,
+		.stencilAttachmentFormat = VkFormat::VK_FORMAT_UNDEFINED
+	};
+#endif
+
 	VkGraphicsPipelineCreateInfo PipelineCreationInfo
 	{
 		.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+		.pNext = &RenderingInfo,
+#else
 		.pNext = nullptr,
+#endif
 		.flags = 0,
 		.stageCount = 2,
 		.pStages = this->ShaderStages.data(),
@@ -677,62 +627,130 @@ void ShadowMapGenerationPass::SetupPipeline()
 		.pMultisampleState = &MultiSampleStateInfo,
 		.pDepthStencilState = &DepthStencilStateInfo,
 		.pColorBlendState = &BlendStateInfo,
-		.pDynamicState = nullptr,
+		.pDynamicState = &DynamicStateInfo,
 		.layout = this->ShadowMapGenerationPipelineLayout,
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+		.renderPass = VK_NULL_HANDLE,
+#else
 		.renderPass = this->ShadowMapGenerationRenderPass,
+#endif
 		.subpass = 0,
 		.basePipelineHandle = nullptr,
 		.basePipelineIndex = -1
 	};
 
-	vkCreateGraphicsPipelines(this->Device, nullptr, 1, &PipelineCreationInfo, nullptr, &this->ShadowMapGenerationPipeline);
+	vkCreateGraphicsPipelines(this->Device, PipelineCache, 1, &PipelineCreationInfo, nullptr, &this->ShadowMapGenerationPipeline);
 }
 
 void ShadowMapGenerationPass::FreeGPUResources()
 {
 	auto Device = this->Device;
 
-	vkDestroyImage(Device, this->VarianceShadowMap, nullptr);
-	vkDestroyImageView(Device, this->VarianceShadowMapView, nullptr);
-	vkFreeMemory(Device, this->VarianceShadowMapMemory, nullptr);
-
-	vkDestroyImage(Device, this->DepthBuffer, nullptr);
-	vkDestroyImageView(Device, this->DepthBufferView, nullptr);
-	vkFreeMemory(Device, this->DepthBufferMemory, nullptr);
-
-	vkDestroyShaderModule(Device, this->ShadowMapGenerationVertexShaderModule, nullptr);
-	vkDestroyShaderModule(Device, this->ShadowMapGenerationFragmentShaderModule, nullptr);
+	FreeRenderTargets();
 
+#ifndef TUTORIAL_VK_DYNAMIC_RENDERING
 	vkDestroyRenderPass(Device, this->ShadowMapGenerationRenderPass, nullptr);
+#endif
 
 	vkDestroyPipelineLayout(Device, this->ShadowMapGenerationPipelineLayout, nullptr);
 	vkDestroyPipeline(Device, this->ShadowMapGenerationPipeline, nullptr);
 
-	vkDestroyFramebuffer(Device, this->ShadowMapGenerationFramebuffer, nullptr);
-
-	vkDestroyBuffer(Device, this->LightSpaceUniformBuffer, nullptr);
-	vkFreeMemory(Device, this->LightSpaceUniformBufferMemory, nullptr);
-
 	vkDestroyDescriptorSetLayout(Device, this->LightSpaceDescriptorSetLayout, nullptr);
 	vkDestroyDescriptorPool(Device, this->LightSpaceDescriptorPool, nullptr);
 }
 
-void ShadowMapGenerationPass::RecordCommandBuffer(VkCommandBuffer CommandBuffer, const std::vector<SceneActor>& Actors)
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+void ShadowMapGenerationPass::SetFilteringQueueIndex(const uint32_t FilteringQueueIndex)
 {
+	this->FilteringQueueIndex = FilteringQueueIndex;
+}
+#endif
+
+void ShadowMapGenerationPass::SetLightDirection(const glm::vec3& LightDirection)
+{
+	const glm::vec3 CameraDirection = glm::normalize(LightDirection);
+	const glm::vec3 EyePosition = CameraDirection * glm::vec3(20) * glm::vec3(1, -1, 1);
+
+	this->LightSpace.ViewMatrix = glm::lookAt(EyePosition, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	this->LightSpace.ProjectionMatrix = glm::perspective(glm::radians(90.0f), 2048.0f / 2048.0f, 0.1f, 30.0f);
+	//this->LightSpace.ProjectionMatrix = glm::ortho(-70.0f, 70.0f, -70.0f, 70.0f, 0.1f, 180.0f);
+	this->LightSpace.LightDirection = glm::vec4(CameraDirection, 1.0f);
+
+	this->ContentVersion++;
+}
+
+void ShadowMapGenerationPass::RecordCommandBuffer(VkCommandBuffer CommandBuffer, const GeometryArena& Geometry, const std::vector<SceneActor>& Actors, ParallelCommandRecorder& Recorder)
+{
+	TUTORIAL_VK_PROFILE_ZONE("ShadowMapGenerationPass::RecordCommandBuffer");
+
+	const VkClearValue DepthClearValue
+	{
+		.depthStencil =
+		{
+			.depth = 1.0f,
+			.stencil = UINT32_MAX
+		}
+	};
+	const VkRect2D RenderArea
+	{
+		.offset
+		{
+			.x = 0,
+			.y = 0
+		},
+		.extent
+		{
+			.width = this->ShadowMapResolution,
+			.height = this->ShadowMapResolution
+		}
+	};
+
+	const bool IsRecordedInParallel = Recorder.ShouldRecordInParallel(Actors.size());
+
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	VkRenderingAttachmentInfo ColorAttachmentInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+		.pNext = nullptr,
+		.imageView = this->VarianceShadowMapView,
+		.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+		.resolveMode = VK_RESOLVE_MODE_NONE,
+		.resolveImageView = VK_NULL_HANDLE,
+		.resolveImageLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED,
+		.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_STORE,
+		.clearValue = {}
+	};
+
+	VkRenderingAttachmentInfo DepthAttachmentInfo = ColorAttachmentInfo;
+	DepthAttachmentInfo.imageView = this->DepthBufferView;
+	DepthAttachmentInfo.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+	DepthAttachmentInfo.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR;
+	DepthAttachmentInfo.clearValue = DepthClearValue;
+
+	VkRenderingInfo RenderingInfo
+	{
+		.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+		.pNext = nullptr,
+		.flags = IsRecordedInParallel ? VkRenderingFlags(VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT) : VkRenderingFlags(0),
+		.renderArea = RenderArea,
+		.layerCount = 1,
+		.viewMask = 0,
+		.colorAttachmentCount = 1,
+		.pColorAttachments = &ColorAttachmentInfo,
+		.pDepthAttachment = &DepthAttachmentInfo,
+		.pStencilAttachment = nullptr
+	};
+
+	vkCmdBeginRendering(CommandBuffer, &RenderingInfo);
+#else
 	std::vector<VkClearValue> ClearValues
 	{
 		VkClearValue
 		{
 			.color = { 0.05f, 0.05f, 0.05f, 1.0f }
 		},
-		VkClearValue
-		{
-			.depthStencil =
-			{
-				.depth = 1.0f,
-				.stencil = UINT32_MAX
-			}
-		}
+		DepthClearValue
 	};
 
 	VkRenderPassBeginInfo BeginRenderPassInfo
@@ -741,34 +759,79 @@ void ShadowMapGenerationPass::RecordCommandBuffer(VkCommandBuffer CommandBuffer,
 		.pNext = nullptr,
 		.renderPass = this->ShadowMapGenerationRenderPass,
 		.framebuffer = this->ShadowMapGenerationFramebuffer,
-		.renderArea =
-		{
-			.offset
-			{
-				.x = 0,
-				.y = 0
-			},
-			.extent
-			{
-				.width = this->ShadowMapResolution,
-				.height = this->ShadowMapResolution
-			}
-		},
+		.renderArea = RenderArea,
 		.clearValueCount = static_cast<uint32_t>(ClearValues.size()),
 		.pClearValues = ClearValues.data(),
 	};
 
-	vkCmdBeginRenderPass(CommandBuffer, &BeginRenderPassInfo, VkSubpassContents::VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(CommandBuffer, &BeginRenderPassInfo, IsRecordedInParallel ? VkSubpassContents::VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VkSubpassContents::VK_SUBPASS_CONTENTS_INLINE);
+#endif
+
+	// Uniforms are written once, before any worker starts recording.
+	this->LightSpaceUniformOffset = this->FrameUniforms->Write(this->LightSpace);
+
+	const auto RecordActors = [&](VkCommandBuffer TargetCommandBuffer, const uint32_t FirstActor, const uint32_t ActorsCount)
+	{
+		vkCmdBindPipeline(TargetCommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, this->ShadowMapGenerationPipeline);
+		RecordViewport(TargetCommandBuffer, RenderArea.extent);
+
+		vkCmdBindDescriptorSets(TargetCommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, this->ShadowMapGenerationPipelineLayout, 0, 1, this->LightSpaceDescriptorSets.data(), 1, &this->LightSpaceUniformOffset);
 
-	vkCmdBindPipeline(CommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, this->ShadowMapGenerationPipeline);
+		Geometry.Bind(TargetCommandBuffer, false);
 
-	vkCmdBindDescriptorSets(CommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, this->ShadowMapGenerationPipelineLayout, 0, 1, this->LightSpaceDescriptorSets.data(), 0, nullptr);
+		for (uint32_t i = FirstActor; i < FirstActor + ActorsCount; i++)
+		{
+			vkCmdDraw(TargetCommandBuffer, Actors[i].VerticesCount, 1, Actors[i].FirstVertex, 0);
+		}
+	};
 
-	for (const auto& Actor : Actors)
+	if (IsRecordedInParallel)
+	{
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+		// Secondary command buffers inherit formats of dynamic render pass instead of render pass object.
+		VkCommandBufferInheritanceRenderingInfo InheritanceRenderingInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.viewMask = 0,
+			.colorAttachmentCount = 1,
+			.pColorAttachmentFormats = &VarianceShadowMapFormat,
+			.depthAttachmentFormat = DepthBufferFormat,
+			.stencilAttachmentFormat = VkFormat::VK_FORMAT_UNDEFINED,
+			.rasterizationSamples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT
+		};
+#endif
+
+		VkCommandBufferInheritanceInfo InheritanceInfo
+		{
+			.sType = VkStructureType::VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+			.pNext = &InheritanceRenderingInfo,
+			.renderPass = VK_NULL_HANDLE,
+			.subpass = 0,
+			.framebuffer = VK_NULL_HANDLE,
+#else
+			.pNext = nullptr,
+			.renderPass = this->ShadowMapGenerationRenderPass,
+			.subpass = 0,
+			.framebuffer = this->ShadowMapGenerationFramebuffer,
+#endif
+			.occlusionQueryEnable = VK_FALSE,
+			.queryFlags = 0,
+			.pipelineStatistics = 0
+		};
+
+		Recorder.RecordSlices(CommandBuffer, this, InheritanceInfo, static_cast<uint32_t>(Actors.size()), RecordActors);
+	}
+	else
 	{
-		vkCmdBindVertexBuffers(CommandBuffer, 0, 1, Actor.VertexBuffers.data(), Actor.Offsets.data());
-		vkCmdDraw(CommandBuffer, Actor.VerticesCount, 1, 0, 0);
+		RecordActors(CommandBuffer, 0, static_cast<uint32_t>(Actors.size()));
 	}
 
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	vkCmdEndRendering(CommandBuffer);
+#else
 	vkCmdEndRenderPass(CommandBuffer);
+#endif
 }
\ No newline at end of file
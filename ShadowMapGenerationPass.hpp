@@ -3,17 +3,20 @@
 #include "RenderPass.hpp"
 #include <vector>
 #include "Actor.hpp"
+#include "GeometryArena.hpp"
+#include "ParallelCommandRecorder.hpp"
+#include "UniformRingBuffer.hpp"
+
+#include <glm/glm.hpp>
 
 class ShadowMapGenerationPass : public RenderPass
 {
 private:
 	VkImage VarianceShadowMap;
 	VkImageView VarianceShadowMapView;
-	VkDeviceMemory VarianceShadowMapMemory;
 
 	VkImage DepthBuffer;
 	VkImageView DepthBufferView;
-	VkDeviceMemory DepthBufferMemory;
 
 	VkShaderModule ShadowMapGenerationVertexShaderModule;
 	VkShaderModule ShadowMapGenerationFragmentShaderModule;
@@ -23,33 +26,73 @@ private:
 	VkPipeline ShadowMapGenerationPipeline{};
 	VkRenderPass ShadowMapGenerationRenderPass;
 
-	static constexpr uint32_t ShadowMapResolution = 2048;
+	static constexpr VkFormat DepthBufferFormat = VkFormat::VK_FORMAT_D32_SFLOAT;
+
+	uint32_t GraphicsQueueIndex = 0;
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+	uint32_t FilteringQueueIndex = 0;
+#endif
 
 	VkFramebuffer ShadowMapGenerationFramebuffer{};
 
+	UniformRingBuffer* FrameUniforms = nullptr;
 	VkBuffer LightSpaceUniformBuffer;
-	VkDeviceMemory LightSpaceUniformBufferMemory;
+	uint32_t LightSpaceUniformOffset = 0;
 
 	VkDescriptorSetLayout LightSpaceDescriptorSetLayout;
 	VkDescriptorPool LightSpaceDescriptorPool;
 	std::vector<VkDescriptorSet> LightSpaceDescriptorSets;
 
 public:
-	ShadowMapGenerationPass(VkDevice Device, const uint32_t GraphicsQueueIndex, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties);
+	static constexpr uint32_t ShadowMapResolution = 2048;
+	static constexpr VkFormat VarianceShadowMapFormat = VkFormat::VK_FORMAT_R32G32_SFLOAT;
+
+	struct LightSpaceContent
+	{
+		glm::mat4 ViewMatrix;
+		glm::mat4 ProjectionMatrix;
+		glm::vec4 LightDirection;
+	};
+
+private:
+	LightSpaceContent LightSpace{};
+
+public:
+	ShadowMapGenerationPass(VkDevice Device, const uint32_t GraphicsQueueIndex, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties, UniformRingBuffer& FrameUniforms);
 
 	virtual void FreeGPUResources() override;
 
-	virtual void SetupShaders() override;
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+	// Shadow map is filtered in place by compute pass, possibly on queue of other family. Must be set before render targets are declared.
+	void SetFilteringQueueIndex(const uint32_t FilteringQueueIndex);
+#endif
+
+	virtual void DeclareRenderTargets(RenderTargetHeap& Heap) override;
+
+	virtual void SetupRenderTargets() override;
+
+	virtual void FreeRenderTargets() override;
+
+	virtual void DeclareGraphUsage(RenderGraph& Graph, const uint32_t GraphPass) override;
+
+	virtual void UpdateGraphImages(RenderGraph& Graph) override;
+
+	virtual void SetupShaders(ShaderArchive& Shaders) override;
+
+	virtual void SetupPipeline(VkPipelineCache PipelineCache) override;
 
-	virtual void SetupPipeline() override;
+	// Light space data is written into frame uniforms during every recording.
+	void SetLightDirection(const glm::vec3& LightDirection);
 
-	void RecordCommandBuffer(VkCommandBuffer CommandBuffer, const std::vector<SceneActor>& Actors);
+	// Large scenes are recorded in parallel into secondary command buffers.
+	void RecordCommandBuffer(VkCommandBuffer CommandBuffer, const GeometryArena& Geometry, const std::vector<SceneActor>& Actors, ParallelCommandRecorder& Recorder);
 
 	virtual ~ShadowMapGenerationPass() = default;
 
 	struct
 	{
 		VkBuffer* LightSpaceUniformBuffer;
+		uint32_t* LightSpaceUniformOffset; // Valid after recording of current frame.
 		VkImageView* VarianceShadowMap;
 	} SharedResources;
 };
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "StartupTaskGraph.hpp"
+#include "CPUProfiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+uint32_t StartupTaskGraph::AddTask(const char* Name, const std::function<void()>& Run, const std::vector<uint32_t>& Dependencies)
+{
+	const uint32_t TaskIndex = static_cast<uint32_t>(this->Tasks.size());
+
+	for (const uint32_t Dependency : Dependencies)
+	{
+		if (Dependency >= TaskIndex)
+		{
+			std::cerr << "Startup task " << Name << " depends on task which isn't added yet." << std::endl;
+			exit(0);
+		}
+		this->Tasks[Dependency].Dependents.push_back(TaskIndex);
+	}
+
+	this->Tasks.push_back(Task
+	{
+		.Name = Name,
+		.Run = Run,
+		.Dependents = {},
+		.DependenciesCount = static_cast<uint32_t>(Dependencies.size()),
+		.PendingDependenciesCount = 0,
+		.DurationInMs = 0.0
+	});
+
+	return TaskIndex;
+}
+
+void StartupTaskGraph::Execute(const uint32_t WorkersCount)
+{
+	TUTORIAL_VK_PROFILE_ZONE("StartupTaskGraph::Execute");
+
+	const auto StartTime = std::chrono::steady_clock::now();
+
+	this->ReadyTasks.clear();
+	this->FinishedTasksCount = 0;
+	for (uint32_t i = 0; i < this->Tasks.size(); i++)
+	{
+		this->Tasks[i].PendingDependenciesCount = this->Tasks[i].DependenciesCount;
+		if (this->Tasks[i].DependenciesCount == 0)
+		{
+			this->ReadyTasks.push_back(i);
+		}
+	}
+
+	// More workers than tasks would only wait.
+	this->WorkersCount = std::clamp<uint32_t>(WorkersCount, 1, static_cast<uint32_t>((std::max)(this->Tasks.size(), size_t(1))));
+
+	std::vector<std::thread> Workers;
+	for (uint32_t i = 0; i < this->WorkersCount; i++)
+	{
+		Workers.emplace_back(&StartupTaskGraph::RunWorker, this, i);
+	}
+	for (auto& Worker : Workers)
+	{
+		Worker.join();
+	}
+
+	this->WallTimeInMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+void StartupTaskGraph::RunWorker(const uint32_t WorkerIndex)
+{
+	TUTORIAL_VK_PROFILE_THREAD("Startup worker " + std::to_string(WorkerIndex));
+
+	while (true)
+	{
+		uint32_t TaskIndex = 0;
+		{
+			std::unique_lock<std::mutex> Lock(this->ReadyTasksMutex);
+			this->TaskFinished.wait(Lock, [&] { return !this->ReadyTasks.empty() || this->FinishedTasksCount == this->Tasks.size(); });
+
+			// Every task has finished, otherwise some task would be ready or running.
+			if (this->ReadyTasks.empty())
+				return;
+
+			TaskIndex = this->ReadyTasks.back();
+			this->ReadyTasks.pop_back();
+		}
+
+		// Task is touched only by its worker until it is reported finished.
+		auto& RunningTask = this->Tasks[TaskIndex];
+		const auto StartTime = std::chrono::steady_clock::now();
+		{
+			TUTORIAL_VK_PROFILE_ZONE(RunningTask.Name);
+			RunningTask.Run();
+		}
+		RunningTask.DurationInMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+
+		{
+			std::lock_guard<std::mutex> Lock(this->ReadyTasksMutex);
+
+			this->FinishedTasksCount++;
+			for (const uint32_t Dependent : RunningTask.Dependents)
+			{
+				if (--this->Tasks[Dependent].PendingDependenciesCount == 0)
+				{
+					this->ReadyTasks.push_back(Dependent);
+				}
+			}
+		}
+		this->TaskFinished.notify_all();
+	}
+}
+
+void StartupTaskGraph::ReportTimings() const
+{
+	double SummedTime = 0.0;
+	for (const auto& FinishedTask : this->Tasks)
+	{
+		SummedTime += FinishedTask.DurationInMs;
+	}
+
+	std::cout << "Startup tasks finished in " << this->WallTimeInMs << "ms on " << this->WorkersCount << " workers, " << SummedTime << "ms when run one after another:" << std::endl;
+	for (const auto& FinishedTask : this->Tasks)
+	{
+		std::cout << "\t" << FinishedTask.Name << ": " << FinishedTask.DurationInMs << "ms" << std::endl;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Startup work split into tasks run by temporary worker threads. Task starts once every task it depends on has finished,
+// so startup takes as long as its slowest chain of dependent tasks instead of sum of all tasks.
+class StartupTaskGraph
+{
+private:
+	struct Task
+	{
+		const char* Name; // Names profiler zone too, so it has to be string literal.
+		std::function<void()> Run;
+		std::vector<uint32_t> Dependents;
+		uint32_t DependenciesCount;
+		uint32_t PendingDependenciesCount;
+		double DurationInMs;
+	};
+	std::vector<Task> Tasks;
+
+	std::mutex ReadyTasksMutex;
+	std::condition_variable TaskFinished;
+	std::vector<uint32_t> ReadyTasks;
+	uint32_t FinishedTasksCount = 0;
+
+	uint32_t WorkersCount = 0;
+	double WallTimeInMs = 0.0;
+
+	void RunWorker(const uint32_t WorkerIndex);
+
+public:
+	StartupTaskGraph() = default;
+
+	// Dependencies have to be added before task, which keeps graph acyclic.
+	uint32_t AddTask(const char* Name, const std::function<void()>& Run, const std::vector<uint32_t>& Dependencies = {});
+
+	// Blocks until every task has finished.
+	void Execute(const uint32_t WorkersCount);
+
+	// Prints time of every task and compares startup time with their sum.
+	void ReportTimings() const;
+
+	~StartupTaskGraph() = default;
+};
\ No newline at end of file
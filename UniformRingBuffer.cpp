@@ -0,0 +1,119 @@
+#include "UniformRingBuffer.hpp"
+#include "Helpers.hpp"
+#include "GPUMemoryTracker.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+UniformRingBuffer::UniformRingBuffer(VkDevice Device, const uint32_t GraphicsQueueIndex, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties, const VkPhysicalDeviceLimits& DeviceLimits, const VkDeviceSize RequestedPartitionSize, const uint32_t PartitionsCount)
+{
+	this->Device = Device;
+	this->PartitionsCount = PartitionsCount;
+
+	// Both limits are powers of two, so bigger one satisfies both of them.
+	this->Alignment = std::max(DeviceLimits.minUniformBufferOffsetAlignment, DeviceLimits.nonCoherentAtomSize);
+	this->PartitionSize = AlignUp(RequestedPartitionSize, this->Alignment);
+
+	// Setup buffer.
+	{
+		VkBufferCreateInfo CreationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.size = this->PartitionSize * this->PartitionsCount,
+			.usage = VkBufferUsageFlagBits::VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
+			.queueFamilyIndexCount = 1,
+			.pQueueFamilyIndices = &GraphicsQueueIndex
+		};
+
+		GPUMemory.CreateBuffer(Device, CreationInfo, this->Buffer, "UniformRingBuffer", "Per-frame uniforms");
+	}
+
+	// Allocate memory for buffer.
+	{
+		VkMemoryRequirements MemoryRequirements;
+		vkGetBufferMemoryRequirements(Device, this->Buffer, &MemoryRequirements);
+
+		const VkMemoryPropertyFlagBits MemoryFlags = static_cast<VkMemoryPropertyFlagBits>(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+		const uint32_t MemoryTypeIndex = QueryMemoryTypeIndex(MemoryFlags, MemoryRequirements.memoryTypeBits, DeviceMemoryProperties);
+
+		this->IsMemoryCoherent = DeviceMemoryProperties.memoryProperties.memoryTypes[MemoryTypeIndex].propertyFlags & VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		VkMemoryAllocateInfo AllocationInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+			.pNext = nullptr,
+			.allocationSize = MemoryRequirements.size,
+			.memoryTypeIndex = MemoryTypeIndex
+		};
+
+		GPUMemory.AllocateMemory(Device, AllocationInfo, this->BufferMemory, "UniformRingBuffer", "Per-frame uniforms");
+
+		GPUMemory.BindBufferMemory(Device, this->Buffer, this->BufferMemory, 0);
+	}
+
+	// Map buffer for whole its lifetime.
+	{
+		void* MappedBuffer = nullptr;
+		vkMapMemory(Device, this->BufferMemory, 0, VK_WHOLE_SIZE, 0, &MappedBuffer);
+
+		this->MappedAddress = reinterpret_cast<char*>(MappedBuffer);
+	}
+}
+
+void UniformRingBuffer::FreeGPUResources()
+{
+	vkUnmapMemory(Device, this->BufferMemory);
+
+	GPUMemory.DestroyBuffer(Device, this->Buffer);
+	GPUMemory.FreeMemory(Device, this->BufferMemory);
+}
+
+void UniformRingBuffer::BeginFrame(const uint32_t FrameIndex)
+{
+	this->CurrentPartition = FrameIndex % this->PartitionsCount;
+	this->PartitionCursor = 0;
+}
+
+void UniformRingBuffer::FlushFrame()
+{
+	if (this->IsMemoryCoherent || this->PartitionCursor == 0)
+		return;
+
+	VkMappedMemoryRange MappedMemoryRange
+	{
+		.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+		.pNext = nullptr,
+		.memory = this->BufferMemory,
+		.offset = this->CurrentPartition * this->PartitionSize,
+		.size = this->PartitionCursor
+	};
+
+	vkFlushMappedMemoryRanges(Device, 1, &MappedMemoryRange);
+}
+
+uint32_t UniformRingBuffer::Write(const void* Data, const VkDeviceSize Size)
+{
+	const VkDeviceSize AlignedSize = AlignUp(Size, this->Alignment);
+
+	if (this->PartitionCursor + AlignedSize > this->PartitionSize)
+	{
+		std::cerr << "Uniform ring buffer partition overflow." << std::endl;
+		exit(0);
+	}
+
+	const VkDeviceSize Offset = this->CurrentPartition * this->PartitionSize + this->PartitionCursor;
+
+	std::memcpy(this->MappedAddress + Offset, Data, Size);
+
+	this->PartitionCursor += AlignedSize;
+
+	return static_cast<uint32_t>(Offset);
+}
+
+VkBuffer UniformRingBuffer::GetBuffer() const
+{
+	return this->Buffer;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vulkan/vulkan.h>
+
+// Persistently mapped uniform buffer divided into one partition per frame.
+// Per-frame constants are suballocated linearly from the current partition and bound through dynamic offsets,
+// so updating them never maps, unmaps or reallocates anything.
+class UniformRingBuffer
+{
+private:
+	VkDevice Device{};
+
+	VkBuffer Buffer{};
+	VkDeviceMemory BufferMemory{};
+	char* MappedAddress = nullptr;
+	bool IsMemoryCoherent = false;
+
+	VkDeviceSize Alignment = 0;
+	VkDeviceSize PartitionSize = 0;
+	uint32_t PartitionsCount = 0;
+
+	uint32_t CurrentPartition = 0;
+	VkDeviceSize PartitionCursor = 0;
+
+public:
+	UniformRingBuffer(VkDevice Device, const uint32_t GraphicsQueueIndex, const VkPhysicalDeviceMemoryProperties2& DeviceMemoryProperties, const VkPhysicalDeviceLimits& DeviceLimits, const VkDeviceSize RequestedPartitionSize, const uint32_t PartitionsCount);
+
+	void FreeGPUResources();
+
+	// Starts writing into partition assigned to given frame. Partition must not be in use by GPU anymore.
+	void BeginFrame(const uint32_t FrameIndex);
+
+	// Makes everything written since BeginFrame visible for device. Must be called before submit.
+	void FlushFrame();
+
+	// Returns dynamic offset of written data.
+	uint32_t Write(const void* Data, const VkDeviceSize Size);
+
+	template<typename T>
+	uint32_t Write(const T& Content)
+	{
+		return Write(&Content, sizeof(T));
+	}
+
+	VkBuffer GetBuffer() const;
+
+	~UniformRingBuffer() = default;
+};
\ No newline at end of file
@@ -5,4 +5,46 @@ glslangValidator --target-env vulkan1.3 -e main -o shadow_map_generation_vert.sp
 glslangValidator --target-env vulkan1.3 -e main -o shadow_map_generation_frag.spv sources/shadow_map_generation.frag
 glslangValidator -R --target-env vulkan1.3 -e main -o deferred_shading_pass_vert.spv sources/deferred_shading_pass.vert
 glslangValidator --target-env vulkan1.3 -e main -o deferred_shading_pass_frag.spv sources/deferred_shading_pass.frag
+glslangValidator --target-env vulkan1.3 -e main -o shadow_map_filtering_comp.spv sources/shadow_map_filtering.comp
+# Pack all modules into one archive mapped by application. Layout has to match ShaderArchive.hpp.
+$Modules = Get-ChildItem -Filter *.spv | Sort-Object Name
+$ModuleAlignment = 16
+$EntrySize = 88
+$Offset = 16 + $EntrySize * $Modules.Count
+$Hasher = [System.Security.Cryptography.SHA256]::Create()
+
+$Stream = New-Object System.IO.MemoryStream
+$Writer = New-Object System.IO.BinaryWriter($Stream)
+$Writer.Write([uint32]0x41565053)
+$Writer.Write([uint32]1)
+$Writer.Write([uint32]$Modules.Count)
+$Writer.Write([uint32]0)
+
+$Contents = @()
+foreach ($Module in $Modules)
+{
+	$Code = [System.IO.File]::ReadAllBytes($Module.FullName)
+	$Offset = [math]::Ceiling($Offset / $ModuleAlignment) * $ModuleAlignment
+
+	$Name = New-Object byte[] 64
+	$NameBytes = [System.Text.Encoding]::ASCII.GetBytes($Module.Name)
+	[System.Array]::Copy($NameBytes, $Name, $NameBytes.Length)
+
+	$Writer.Write($Name)
+	$Writer.Write([System.BitConverter]::ToUInt64($Hasher.ComputeHash($Code), 0))
+	$Writer.Write([uint64]$Offset)
+	$Writer.Write([uint64]$Code.Length)
+
+	$Contents += ,@($Offset, $Code)
+	$Offset += $Code.Length
+}
+foreach ($Content in $Contents)
+{
+	while ($Stream.Position -lt $Content[0])
+	{
+		$Writer.Write([byte]0)
+	}
+	$Writer.Write($Content[1])
+}
+[System.IO.File]::WriteAllBytes((Join-Path (Get-Location) "shaders.spvpack"), $Stream.ToArray())
 cd ..
\ No newline at end of file
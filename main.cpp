@@ -1,14 +1,16 @@
-#define VK_USE_PLATFORM_WIN32_KHR
 #include <vulkan/vulkan.h>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <memory>
 #include <chrono>
+#include <optional>
+#include <algorithm>
+#include <thread>
+#include <stdexcept>
+#include <cstdlib>
 
-#define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3.h>
-#include <GLFW/glfw3native.h>
 
 #include "wavefront_loader.hpp"
 #include "Helpers.hpp"
@@ -16,7 +18,22 @@
 
 #include "GBufferGenerationPass.hpp"
 #include "ShadowMapGenerationPass.hpp"
+#include "ShadowMapFilteringPass.hpp"
 #include "DeferredPass.hpp"
+#include "UniformRingBuffer.hpp"
+#include "RenderTargetHeap.hpp"
+#include "GPUMemoryTracker.hpp"
+#include "GeometryArena.hpp"
+#include "ParallelCommandRecorder.hpp"
+#include "QueueTimeline.hpp"
+#include "FrameBenchmark.hpp"
+#include "GPUTimestampProfiler.hpp"
+#include "PipelineStatisticsProfiler.hpp"
+#include "CPUProfiler.hpp"
+#include "RenderGraph.hpp"
+#include "PersistentPipelineCache.hpp"
+#include "StartupTaskGraph.hpp"
+#include "ShaderArchive.hpp"
 
 #define TUTORIAL_VK_DEVICE_VENDOR_NONE 0
 #define TUTORIAL_VK_DEVICE_VENDOR_AMD 1
@@ -31,12 +48,107 @@
 
 //#define TUTORIAL_VK_FORCE_DEVICE_VENDOR TUTORIAL_VK_DEVICE_VENDOR_NVIDIA // Force device vendor while querying Vulkan device. Typically used for debugging purpose.
 
+#define TUTORIAL_VK_FRAMES_IN_FLIGHT 2 // Count of frames which CPU may record while GPU still renders previous ones.
+
 //#define TUTORIAL_VK_DEBUG_COMMAND_BUFFER_SUBMIT // Uncommented causes that main app loop will end after 1 frame rendering. For debug command buffer recording purpose.
 
 #if TUTORIAL_VK_FORCE_DEVICE_VENDOR == TUTORIAL_VK_DEVICE_VENDOR_INTEL
 	#error "Currently implementation for Intel GPUs is not present."
 #endif
 
+struct LaunchOptions
+{
+	bool IsHeadless = false; // Renders into offscreen images without window and surface, for machines without display.
+	bool IsBenchmark = false; // Plays back scripted camera and light path and reports frame statistics.
+	uint32_t FramesCount = 1000; // Frames rendered headless, or measured by benchmark.
+	uint32_t WarmupFramesCount = 100;
+	VkExtent2D Resolution{ .width = 1600, .height = 900 }; // Initial size of window, or size of offscreen images when rendering headless.
+	std::string SceneName = "vulkan_scene"; // Scene is loaded from .obj and .mtl files of this name.
+	std::string BenchmarkOutputPath = "benchmark"; // Results are written into .json and .csv files of this name.
+	std::string TracePath; // CPU zones are recorded and written as Chrome trace into this file when not empty.
+};
+
+// Parses whole text as unsigned number. std::stoul throws on text which isn't a number and ignores trailing characters, both are rejected here.
+bool ParseUnsigned(const std::string& Text, uint32_t& Value)
+{
+	try
+	{
+		size_t ParsedCharactersCount = 0;
+		const unsigned long ParsedValue = std::stoul(Text, &ParsedCharactersCount);
+		if (ParsedCharactersCount != Text.size() || Text.find('-') != std::string::npos || ParsedValue > UINT32_MAX)
+			return false;
+
+		Value = static_cast<uint32_t>(ParsedValue);
+		return true;
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+}
+
+LaunchOptions ParseLaunchOptions(int ArgumentsCount, char** Arguments)
+{
+	LaunchOptions Options;
+
+	for (int i = 1; i < ArgumentsCount; i++)
+	{
+		const std::string Argument = Arguments[i];
+
+		if (Argument == "--headless")
+		{
+			Options.IsHeadless = true;
+		}
+		else if (Argument == "--benchmark")
+		{
+			Options.IsBenchmark = true;
+		}
+		else if ((Argument == "--frames" || Argument == "--warmup") && i + 1 < ArgumentsCount)
+		{
+			const std::string Count = Arguments[++i];
+			if (!ParseUnsigned(Count, Argument == "--frames" ? Options.FramesCount : Options.WarmupFramesCount))
+			{
+				std::cerr << "Invalid frames count: " << Count << ". Expected non-negative number." << std::endl;
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if (Argument == "--resolution" && i + 1 < ArgumentsCount)
+		{
+			// Given as WIDTHxHEIGHT.
+			const std::string Resolution = Arguments[++i];
+			const size_t Separator = Resolution.find('x');
+			const bool IsParsed = Separator != std::string::npos
+				&& ParseUnsigned(Resolution.substr(0, Separator), Options.Resolution.width)
+				&& ParseUnsigned(Resolution.substr(Separator + 1), Options.Resolution.height);
+
+			if (!IsParsed || !Options.Resolution.width || !Options.Resolution.height)
+			{
+				std::cerr << "Invalid resolution: " << Resolution << ". Expected WIDTHxHEIGHT." << std::endl;
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if (Argument == "--scene" && i + 1 < ArgumentsCount)
+		{
+			Options.SceneName = Arguments[++i];
+		}
+		else if (Argument == "--benchmark-output" && i + 1 < ArgumentsCount)
+		{
+			Options.BenchmarkOutputPath = Arguments[++i];
+		}
+		else if (Argument == "--trace" && i + 1 < ArgumentsCount)
+		{
+			Options.TracePath = Arguments[++i];
+		}
+		else
+		{
+			std::cerr << "Unknown argument: " << Argument << ". Usage: VulkanTutorial [--headless] [--benchmark] [--frames N] [--warmup N] [--resolution WIDTHxHEIGHT] [--scene NAME] [--benchmark-output PATH] [--trace PATH]" << std::endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	return Options;
+}
+
 VkApplicationInfo AppInfo
 {
 	.sType = VkStructureType::VK_STRUCTURE_TYPE_APPLICATION_INFO,
@@ -54,12 +166,18 @@ struct DeviceInfo
 	std::string DriverVersion;
 	size_t TotalMemoryInMB;
 	size_t FreeMemoryInMB;
+	VkPhysicalDeviceLimits Limits;
+	VkPhysicalDeviceProperties Properties; // Identifies device and driver in pipeline cache header.
+	uint32_t TimestampValidBits; // Of graphics queue family.
+	uint32_t AsyncComputeTimestampValidBits;
+	bool IsPipelineStatisticsSupported; // Together with queries inherited by secondary command buffers.
 
 } DeviceInfos;
 
 enum QueueFamilyIndex
 {
-	Graphics
+	Graphics,
+	AsyncCompute // Equal to graphics family when device has no family dedicated to compute.
 };
 
 enum DeviceMemoryTypeIndex
@@ -87,6 +205,7 @@ VkPhysicalDeviceMemoryProperties2 DeviceMemoryInfo
 
 struct SwapchainCreationInfo
 {
+	VkPhysicalDevice PhysicalDevice; // Queried for surface capabilities whenever swapchain is created.
 	VkPresentModeKHR ExposedPresentMode;
 	VkSurfaceFormatKHR ExposedSurfaceFormat;
 };
@@ -95,6 +214,8 @@ std::vector<uint32_t> DeviceMemoryTypeIndices(3, 0);
 
 VkDevice CreateDevice(VkInstance Instance, DeviceInfo& Infos, VkSurfaceKHR SwapchainSurface, std::vector<uint32_t>& QueueFamilyIndices, SwapchainCreationInfo& SwapchainInfo)
 {
+	TUTORIAL_VK_PROFILE_ZONE("CreateDevice");
+
 	const std::vector<VkQueueFlagBits> RequiredQueueBits
 	{
 		VK_QUEUE_GRAPHICS_BIT,
@@ -107,10 +228,16 @@ VkDevice CreateDevice(VkInstance Instance, DeviceInfo& Infos, VkSurfaceKHR Swapc
 	{
 		1.0f
 	};
-	const std::vector<const char*> RequiredDeviceExtensions
+	// Headless rendering has no surface, so it doesn't present anything.
+	const bool IsHeadless = SwapchainSurface == VK_NULL_HANDLE;
+	std::vector<const char*> RequiredDeviceExtensions;
+	if (!IsHeadless)
 	{
-		"VK_KHR_swapchain"
-	};
+		RequiredDeviceExtensions.push_back("VK_KHR_swapchain");
+	}
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+	RequiredDeviceExtensions.push_back("VK_KHR_dynamic_rendering_local_read");
+#endif
 
 	VkDevice DeviceCache = 0;
 
@@ -123,6 +250,16 @@ VkDevice CreateDevice(VkInstance Instance, DeviceInfo& Infos, VkSurfaceKHR Swapc
 	{
 		std::cerr << "No available Vulkan device detected." << std::endl;
 	}
+
+	// CPU devices are considered last, so headless rendering still prefers GPU when there is any.
+	std::stable_sort(Devices.begin(), Devices.end(), [](VkPhysicalDevice First, VkPhysicalDevice Second)
+	{
+		VkPhysicalDeviceProperties FirstProperties, SecondProperties;
+		vkGetPhysicalDeviceProperties(First, &FirstProperties);
+		vkGetPhysicalDeviceProperties(Second, &SecondProperties);
+
+		return FirstProperties.deviceType != VK_PHYSICAL_DEVICE_TYPE_CPU && SecondProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+	});
 	
 	VkPhysicalDeviceCoherentMemoryFeaturesAMD CoherentMemoryFeatureAMD
 	{
@@ -156,8 +293,8 @@ VkDevice CreateDevice(VkInstance Instance, DeviceInfo& Infos, VkSurfaceKHR Swapc
 			}
 		}
 
-		// Prevent to use lava pipe.
-		if (DeviceProperties.properties.deviceType == VkPhysicalDeviceType::VK_PHYSICAL_DEVICE_TYPE_CPU)
+		// Prevent to use lava pipe, unless rendering headless on machines which often have no GPU at all.
+		if (DeviceProperties.properties.deviceType == VkPhysicalDeviceType::VK_PHYSICAL_DEVICE_TYPE_CPU && !IsHeadless)
 			continue;
 
 		// Check that device supports required queues.
@@ -179,16 +316,53 @@ VkDevice CreateDevice(VkInstance Instance, DeviceInfo& Infos, VkSurfaceKHR Swapc
 			}
 		}
 
+		// Queue of family without graphics runs alongside graphics queue, otherwise compute work stays on graphics queue.
+		QueueFamilyIndices.push_back(QueueFamilyIndices[QueueFamilyIndex::Graphics]);
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+		for (size_t QueueFamilyID = 0; QueueFamilyID < QueueFamilies.size(); QueueFamilyID++)
+		{
+			if ((QueueFamilies[QueueFamilyID].queueFlags & VK_QUEUE_COMPUTE_BIT) && !(QueueFamilies[QueueFamilyID].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+			{
+				QueueFamilyIndices[QueueFamilyIndex::AsyncCompute] = QueueFamilyID;
+				break;
+			}
+		}
+#endif
+
 		// Check that GPU supports AMD specific extensions
+		VkPhysicalDeviceFeatures SupportedFeatures{};
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+		VkPhysicalDeviceDynamicRenderingLocalReadFeaturesKHR DynamicRenderingLocalReadFeature
+		{
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_LOCAL_READ_FEATURES_KHR,
+			.pNext = &CoherentMemoryFeatureAMD
+		};
+#endif
 		{
 			VkPhysicalDeviceFeatures2 Features
 			{
 				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+				.pNext = &DynamicRenderingLocalReadFeature,
+#else
 				.pNext = &CoherentMemoryFeatureAMD,
+#endif
 			};
 
 			vkGetPhysicalDeviceFeatures2(PhysicalDevice, &Features);
+			SupportedFeatures = Features.features;
 		}
+
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+		// Deferred shading reads G-buffer within dynamic render pass.
+		if (!DynamicRenderingLocalReadFeature.dynamicRenderingLocalRead)
+			continue;
+#endif
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+		// Shadow map filtering reads and writes two-component storage images.
+		if (!SupportedFeatures.shaderStorageImageExtendedFormats)
+			continue;
+#endif
 		
 		// If not support - queue next device.
 		bool QueueBitsSupported = true;
@@ -206,41 +380,66 @@ VkDevice CreateDevice(VkInstance Instance, DeviceInfo& Infos, VkSurfaceKHR Swapc
 			continue;
 		}
 
-		// Check for hardware color space and color format support.
-		uint32_t SupportedFormatsCount = 0;
-		vkGetPhysicalDeviceSurfaceFormatsKHR(PhysicalDevice, SwapchainSurface, &SupportedFormatsCount, nullptr);
-		std::vector<VkSurfaceFormatKHR> SupportedFormats(SupportedFormatsCount);
-		vkGetPhysicalDeviceSurfaceFormatsKHR(PhysicalDevice, SwapchainSurface, &SupportedFormatsCount, SupportedFormats.data());
+		if (IsHeadless)
+		{
+			// Offscreen images use common swapchain format, which every device supports as color attachment.
+			SwapchainInfo.ExposedSurfaceFormat =
+			{
+				.format = VkFormat::VK_FORMAT_B8G8R8A8_UNORM,
+				.colorSpace = VkColorSpaceKHR::VK_COLOR_SPACE_SRGB_NONLINEAR_KHR
+			};
+		}
+		else
+		{
+			// Check for hardware color space and color format support.
+			uint32_t SupportedFormatsCount = 0;
+			vkGetPhysicalDeviceSurfaceFormatsKHR(PhysicalDevice, SwapchainSurface, &SupportedFormatsCount, nullptr);
+			std::vector<VkSurfaceFormatKHR> SupportedFormats(SupportedFormatsCount);
+			vkGetPhysicalDeviceSurfaceFormatsKHR(PhysicalDevice, SwapchainSurface, &SupportedFormatsCount, SupportedFormats.data());
 
-		if (!SupportedFormats.size())
-			continue;
+			if (!SupportedFormats.size())
+				continue;
 
-		SwapchainInfo.ExposedSurfaceFormat = SupportedFormats[0];
+			SwapchainInfo.ExposedSurfaceFormat = SupportedFormats[0];
 
-		// Check for present mode support.
-		uint32_t SupportedSurfacePresentModesCount = 0;
-		vkGetPhysicalDeviceSurfacePresentModesKHR(PhysicalDevice, SwapchainSurface, &SupportedSurfacePresentModesCount, nullptr);
-		std::vector<VkPresentModeKHR> PresentModes(SupportedSurfacePresentModesCount);
-		vkGetPhysicalDeviceSurfacePresentModesKHR(PhysicalDevice, SwapchainSurface, &SupportedSurfacePresentModesCount, PresentModes.data());
-		bool PresentModeSupported = false;
+			// Check for present mode support.
+			uint32_t SupportedSurfacePresentModesCount = 0;
+			vkGetPhysicalDeviceSurfacePresentModesKHR(PhysicalDevice, SwapchainSurface, &SupportedSurfacePresentModesCount, nullptr);
+			std::vector<VkPresentModeKHR> PresentModes(SupportedSurfacePresentModesCount);
+			vkGetPhysicalDeviceSurfacePresentModesKHR(PhysicalDevice, SwapchainSurface, &SupportedSurfacePresentModesCount, PresentModes.data());
+			bool PresentModeSupported = false;
 
-		if (!PresentModes.size())
-			continue;
+			if (!PresentModes.size())
+				continue;
 
-		 SwapchainInfo.ExposedPresentMode = PresentModes[0];
+			SwapchainInfo.ExposedPresentMode = PresentModes[0];
+			SwapchainInfo.PhysicalDevice = PhysicalDevice;
+		}
 
 		// Describe needed features.
 		VkPhysicalDeviceVulkan13Features Vulkan13Features
 		{
 			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
 			.pNext = nullptr,
-			.synchronization2 = true
+			.synchronization2 = true,
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+			.dynamicRendering = true
+#endif
 		};
 		VkPhysicalDeviceVulkan12Features Vulkan12Features
 		{
 			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
 			.pNext = &Vulkan13Features,
-			.separateDepthStencilLayouts = true
+			.separateDepthStencilLayouts = true,
+			.timelineSemaphore = true
+		};
+		VkPhysicalDeviceFeatures EnabledFeatures
+		{
+			.pipelineStatisticsQuery = SupportedFeatures.pipelineStatisticsQuery && SupportedFeatures.inheritedQueries,
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+			.shaderStorageImageExtendedFormats = true,
+#endif
+			.inheritedQueries = SupportedFeatures.pipelineStatisticsQuery && SupportedFeatures.inheritedQueries
 		};
 		
 		
@@ -255,32 +454,49 @@ VkDevice CreateDevice(VkInstance Instance, DeviceInfo& Infos, VkSurfaceKHR Swapc
 
 		//std::cout <<  << std::endl;
 
+#ifdef TUTORIAL_VK_DYNAMIC_RENDERING
+		DynamicRenderingLocalReadFeature.pNext = CoherentMemoryFeatureAMD.deviceCoherentMemory ? &CoherentMemoryFeatureAMD : nullptr;
+		Vulkan13Features.pNext = &DynamicRenderingLocalReadFeature;
+#else
 		if (CoherentMemoryFeatureAMD.deviceCoherentMemory)
 		{
 			Vulkan13Features.pNext = &CoherentMemoryFeatureAMD;
 		}
+#endif
 
 		// Create device and queues.
-		VkDeviceQueueCreateInfo DeviceQueueCreationInfo{};
-		DeviceQueueCreationInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-		DeviceQueueCreationInfo.queueCount = 1;
-		DeviceQueueCreationInfo.queueFamilyIndex = QueueFamilyIndices[0];
-		DeviceQueueCreationInfo.pQueuePriorities = RequiredQueuePriorities.data();
+		std::vector<VkDeviceQueueCreateInfo> DeviceQueueCreationInfos(1);
+		DeviceQueueCreationInfos[0].sType = VkStructureType::VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		DeviceQueueCreationInfos[0].queueCount = 1;
+		DeviceQueueCreationInfos[0].queueFamilyIndex = QueueFamilyIndices[QueueFamilyIndex::Graphics];
+		DeviceQueueCreationInfos[0].pQueuePriorities = RequiredQueuePriorities.data();
+		if (QueueFamilyIndices[QueueFamilyIndex::AsyncCompute] != QueueFamilyIndices[QueueFamilyIndex::Graphics])
+		{
+			DeviceQueueCreationInfos.push_back(DeviceQueueCreationInfos[0]);
+			DeviceQueueCreationInfos[1].queueFamilyIndex = QueueFamilyIndices[QueueFamilyIndex::AsyncCompute];
+		}
 
 		VkDeviceCreateInfo DeviceCreationInfo{};
 		DeviceCreationInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-		DeviceCreationInfo.pQueueCreateInfos = &DeviceQueueCreationInfo;
-		DeviceCreationInfo.queueCreateInfoCount = 1;
+		DeviceCreationInfo.pQueueCreateInfos = DeviceQueueCreationInfos.data();
+		DeviceCreationInfo.queueCreateInfoCount = static_cast<uint32_t>(DeviceQueueCreationInfos.size());
 		DeviceCreationInfo.enabledExtensionCount = RequiredDeviceExtensions.size();
 		DeviceCreationInfo.ppEnabledExtensionNames = RequiredDeviceExtensions.data();
+		DeviceCreationInfo.pEnabledFeatures = &EnabledFeatures;
 		DeviceCreationInfo.pNext = &Vulkan12Features;		
 
 		vkCreateDevice(PhysicalDevice, &DeviceCreationInfo, nullptr, &DeviceCache);
 
 		vkGetPhysicalDeviceMemoryProperties2(PhysicalDevice, &DeviceMemoryInfo);
+		GPUMemory.SetDeviceMemoryProperties(DeviceMemoryInfo);
 		
 		Infos.HardwareName = std::string(DeviceProperties.properties.deviceName);
 		Infos.DriverVersion = std::string(DeviceDriverProperties.driverInfo);
+		Infos.Limits = DeviceProperties.properties.limits;
+		Infos.Properties = DeviceProperties.properties;
+		Infos.TimestampValidBits = QueueFamilies[QueueFamilyIndices[QueueFamilyIndex::Graphics]].timestampValidBits;
+		Infos.AsyncComputeTimestampValidBits = QueueFamilies[QueueFamilyIndices[QueueFamilyIndex::AsyncCompute]].timestampValidBits;
+		Infos.IsPipelineStatisticsSupported = EnabledFeatures.pipelineStatisticsQuery;
 		for (int i = 0; i < DeviceMemoryInfo.memoryProperties.memoryHeapCount; i++)
 		{
 			if (DeviceMemoryInfo.memoryProperties.memoryHeaps[i].flags & VkMemoryHeapFlagBits::VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
@@ -309,122 +525,60 @@ VkDevice CreateDevice(VkInstance Instance, DeviceInfo& Infos, VkSurfaceKHR Swapc
 	return DeviceCache;
 }
 
-void SetupActor(VkDevice Device, SceneActor& Actor, const tnr::m3d::wavefront::tnrObject& LoadedObjectData)
-{
-	std::vector<RequiredMemory> BufferMemorySegments(2);
-
-	VkMemoryRequirements MemRequirementsCache{};
+uint64_t ActorsVersion = 0; // Incremented whenever actor is added or removed.
 
-	// Create GPU buffers.
-	{
-		// Create vertex position buffer.
-		{
-			VkBufferCreateInfo CreationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-				.pNext = nullptr,
-				.flags = 0,
-				.size = sizeof(LoadedObjectData.Positions[0]) * LoadedObjectData.Positions.size(),
-				.usage = VkBufferUsageFlagBits::VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-				.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
-				.queueFamilyIndexCount = 0,
-				.pQueueFamilyIndices = nullptr
-			};
-
-			vkCreateBuffer(Device, &CreationInfo, nullptr, &Actor.VertexBuffers[SceneActor::BufferType::Position]);
-
-			vkGetBufferMemoryRequirements(Device, Actor.VertexBuffers[SceneActor::BufferType::Position], &MemRequirementsCache);
-			BufferMemorySegments[SceneActor::BufferType::Position] = ComputeMemorySegments(MemRequirementsCache);
-		}
-
-		// Create vertex normal buffer.
-		{
-			VkBufferCreateInfo CreationInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-				.pNext = nullptr,
-				.flags = 0,
-				.size = sizeof(LoadedObjectData.Normals[0]) * LoadedObjectData.Normals.size(),
-				.usage = VkBufferUsageFlagBits::VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-				.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
-				.queueFamilyIndexCount = 0,
-				.pQueueFamilyIndices = nullptr
-			};
-
-			vkCreateBuffer(Device, &CreationInfo, nullptr, &Actor.VertexBuffers[SceneActor::BufferType::Normal]);
-
-			VkMemoryRequirements MemRequirementsCache{};
-			vkGetBufferMemoryRequirements(Device, Actor.VertexBuffers[SceneActor::BufferType::Normal], &MemRequirementsCache);
-			BufferMemorySegments[SceneActor::BufferType::Normal] = ComputeMemorySegments(MemRequirementsCache);
-		}
-	}
-	
-	// Allocate memory for buffers.
-	{
-		size_t SummedSize = 0;
-		for (const auto Offset : BufferMemorySegments)
-		{
-			SummedSize += Offset.SegmentsCount * Offset.SegmentSize;
-		}
-
-		VkMemoryAllocateInfo SceneBufferAllocationInfo
-		{
-			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-			.pNext = nullptr,
-			.allocationSize = SummedSize,
-			.memoryTypeIndex = QueryMemoryTypeIndex(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, MemRequirementsCache.memoryTypeBits, DeviceMemoryInfo)
-		};
+void SetupActor(GeometryArena& Geometry, SceneActor& Actor, const tnr::m3d::wavefront::tnrObject& LoadedObjectData)
+{
+	TUTORIAL_VK_PROFILE_ZONE("SetupActor");
 
-		vkAllocateMemory(Device, &SceneBufferAllocationInfo, nullptr, &Actor.ActorBuffersGPUMemory);
-	}
+	Actor.VerticesCount = static_cast<uint32_t>(LoadedObjectData.Positions.size());
 
-	// Associate memory with buffers.
+	if (!Geometry.Allocate(Actor.VerticesCount, Actor.FirstVertex))
 	{
-		size_t SummedSize = 0;
-		for (size_t i = 0; i < BufferMemorySegments.size(); i++)
-		{
-			vkBindBufferMemory(Device, Actor.VertexBuffers[i], Actor.ActorBuffersGPUMemory, SummedSize);
-			SummedSize += BufferMemorySegments[i].SegmentsCount * BufferMemorySegments[i].SegmentSize;
-		}
+		exit(0);
 	}
 
-	// Upload data into buffers.
-	{
-		VkMappedMemoryRange RangeInfo
-		{
-			.sType = VkStructureType::VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-			.pNext = nullptr,
-			.memory = Actor.ActorBuffersGPUMemory,
-			.offset = 0,
-			.size = VK_WHOLE_SIZE
-		};
-
-		void* MapAddress = nullptr;
-		auto result = vkMapMemory(Device, Actor.ActorBuffersGPUMemory, 0, VK_WHOLE_SIZE, 0, &MapAddress);
-		char* ArithmethicableAddress = reinterpret_cast<char*>(MapAddress);
-		std::memcpy(ArithmethicableAddress, LoadedObjectData.Positions.data(), LoadedObjectData.Positions.size() * sizeof(LoadedObjectData.Positions[0]));
-		ArithmethicableAddress += BufferMemorySegments[SceneActor::BufferType::Position].SegmentsCount * BufferMemorySegments[SceneActor::BufferType::Position].SegmentSize;
-		std::memcpy(ArithmethicableAddress, LoadedObjectData.Normals.data(), LoadedObjectData.Normals.size() * sizeof(LoadedObjectData.Normals[0]));
+	Geometry.Upload(Actor.FirstVertex, Actor.VerticesCount, LoadedObjectData.Positions.data(), LoadedObjectData.Normals.data());
 
-		vkFlushMappedMemoryRanges(Device, 1, &RangeInfo);
+	ActorsVersion++;
+}
 
-		vkUnmapMemory(Device, Actor.ActorBuffersGPUMemory);
-	}
+// Geometry of actor is released once GPU finishes every frame submitted so far. Cached command buffers drawing it
+// are re-recorded before their next submission, because actors version changes.
+void RemoveActor(GeometryArena& Geometry, std::vector<SceneActor>& Actors, size_t ActorIndex, const QueueTimeline& GraphicsTimeline)
+{
+	Geometry.Free(Actors[ActorIndex].FirstVertex, Actors[ActorIndex].VerticesCount, GraphicsTimeline.GetLastSubmittedValue());
+	Actors.erase(Actors.begin() + ActorIndex);
 
-	Actor.VerticesCount = LoadedObjectData.Positions.size();
+	ActorsVersion++;
 }
 
 std::vector<SceneActor> Actors;
+std::unique_ptr<GeometryArena> SceneGeometry;
+constexpr uint32_t EmptySceneVerticesCapacity = 1024; // Least capacity of scene geometry, used also when scene has no vertices.
 
-void LoadScene(VkDevice Device)
+// Content which recorded command buffers depend on. Command buffer is re-recorded only when it changes.
+struct SceneVersion
 {
+	uint64_t GBufferGeneration;
+	uint64_t ShadowMapGeneration;
+	uint64_t DeferredShading;
+	uint64_t Actors;
+
+	bool operator==(const SceneVersion& Other) const = default;
+};
+
+void LoadScene(VkDevice Device, const std::string& SceneName)
+{
+	TUTORIAL_VK_PROFILE_ZONE("LoadScene");
+
 	if (TUTORIAL_VK_DEBUG_DEALLOCATIONS)
 	{
 		std::cout << "Loading scene from disk..." << std::endl;
 
 		const auto StartTime = std::chrono::system_clock::now();
 
-		tnr::m3d::wavefront::tnrWavefrontLoader Loader(tnr::m3d::wavefront::tnrWavefrontOpenFlag::FLIP_POSITION_Y_AXIS, "vulkan_scene.obj", "vulkan_scene.mtl");
+		tnr::m3d::wavefront::tnrWavefrontLoader Loader(tnr::m3d::wavefront::tnrWavefrontOpenFlag::FLIP_POSITION_Y_AXIS, SceneName + ".obj", SceneName + ".mtl");
 
 		const auto FinishTime = std::chrono::system_clock::now();
 
@@ -441,10 +595,18 @@ void LoadScene(VkDevice Device)
 	
 		std::cout << "Uploading scene into GPU memory...";
 
+		// Leave some space for actors added at runtime.
+		size_t SceneVerticesCount = 0;
+		for (const auto& Obj : Geometry)
+		{
+			SceneVerticesCount += Obj.Positions.size();
+		}
+		SceneGeometry = std::make_unique<GeometryArena>(Device, DeviceMemoryInfo, (std::max)(static_cast<uint32_t>(SceneVerticesCount + SceneVerticesCount / 4), EmptySceneVerticesCapacity));
+
 		for (const auto& Obj : Geometry)
 		{
 			SceneActor UnitializedActor{};
-			SetupActor(Device, UnitializedActor, Obj);
+			SetupActor(*SceneGeometry, UnitializedActor, Obj);
 
 			Actors.push_back(UnitializedActor);
 		}
@@ -455,70 +617,79 @@ void LoadScene(VkDevice Device)
 	if (!TUTORIAL_VK_DEBUG_DEALLOCATIONS)
 	{
 		std::cout << "Loading scene actors cancelled due debugging purposes." << std::endl;
+
+		SceneGeometry = std::make_unique<GeometryArena>(Device, DeviceMemoryInfo, EmptySceneVerticesCapacity);
 	}
 }
 
-void MakeImageTransition(VkCommandBuffer CommandBuffer, VkImage TransitionedImage, VkImageLayout LayoutBeforeTransition, VkImageLayout LayoutAfterTransition, uint32_t GraphicsQueueIndex)
+// CPU time of frame loop iteration, which equals GPU frame time once frames in flight are saturated.
+void ReportFrameTimings(const std::vector<double>& FrameTimesInMs, const double TotalTimeInMs)
 {
-	VkImageSubresourceRange SubresourceInfo
-	{
-		.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT,
-		.baseMipLevel = 0,
-		.levelCount = 1,
-		.baseArrayLayer = 0,
-		.layerCount = 1
-	};
-
-	VkImageMemoryBarrier2 MemoryBarrierInfo
-	{
-		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-		.pNext = nullptr,
-		.srcStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
-		.srcAccessMask = VkAccessFlagBits::VK_ACCESS_MEMORY_WRITE_BIT,
-		.dstStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
-		.dstAccessMask = VkAccessFlagBits::VK_ACCESS_MEMORY_WRITE_BIT,
-		.oldLayout = LayoutBeforeTransition,
-		.newLayout = LayoutAfterTransition,
-		.srcQueueFamilyIndex = GraphicsQueueIndex,
-		.dstQueueFamilyIndex = GraphicsQueueIndex,
-		.image = TransitionedImage,
-		.subresourceRange = SubresourceInfo
-	};
+	if (FrameTimesInMs.empty())
+		return;
 
-	VkDependencyInfo DependencyInfo
+	double SummedTime = 0.0;
+	for (const double FrameTime : FrameTimesInMs)
 	{
-		.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-		.pNext = nullptr,
-		.dependencyFlags = 0,
-		.memoryBarrierCount = 0,
-		.pMemoryBarriers = nullptr,
-		.bufferMemoryBarrierCount = 0,
-		.pBufferMemoryBarriers = nullptr,
-		.imageMemoryBarrierCount = 1,
-		.pImageMemoryBarriers = &MemoryBarrierInfo
-	};
+		SummedTime += FrameTime;
+	}
+	const double AverageTime = SummedTime / FrameTimesInMs.size();
+	const auto [MinTime, MaxTime] = std::minmax_element(FrameTimesInMs.begin(), FrameTimesInMs.end());
 
-	vkCmdPipelineBarrier2(CommandBuffer, &DependencyInfo);
+	std::cout << "Rendered " << FrameTimesInMs.size() << " frames in " << TotalTimeInMs / 1000.0 << "s." << std::endl;
+	std::cout << "\tFrame time: average " << AverageTime << "ms, min " << *MinTime << "ms, max " << *MaxTime << "ms" << std::endl;
+	std::cout << "\tFrames per second: " << FrameTimesInMs.size() * 1000.0 / TotalTimeInMs << std::endl;
 }
 
-int main()
+int main(int ArgumentsCount, char** Arguments)
 {
+	const LaunchOptions Options = ParseLaunchOptions(ArgumentsCount, Arguments);
+	if (!Options.TracePath.empty())
+	{
+		CPUTrace.Enable();
+		CPUTrace.WriteTraceOnExit(Options.TracePath);
+	}
+
+	// Window system is needed only for presentation.
+	if (!Options.IsHeadless)
+	{
+		glfwInit();
+	}
+
 	// Instance initialization.
 	VkInstance Instance;
 	{
-		std::vector<const char*> InstanceExtensions
+		TUTORIAL_VK_PROFILE_ZONE("Create instance");
+
+		// Surface extensions of current platform are reported by GLFW.
+		std::vector<const char*> InstanceExtensions;
+		if (!Options.IsHeadless)
 		{
-			"VK_KHR_surface",
-			"VK_KHR_win32_surface"
-		};
-		std::vector<const char*> ValidationLayer
+			uint32_t SurfaceExtensionsCount = 0;
+			const char** SurfaceExtensions = glfwGetRequiredInstanceExtensions(&SurfaceExtensionsCount);
+			InstanceExtensions.assign(SurfaceExtensions, SurfaceExtensions + SurfaceExtensionsCount);
+		}
+
+		// Render farm and CI machines usually don't have validation layer installed.
+		std::vector<const char*> ValidationLayer;
 		{
-			"VK_LAYER_KHRONOS_validation"
-		};
+			uint32_t LayersCount = 0;
+			vkEnumerateInstanceLayerProperties(&LayersCount, nullptr);
+			std::vector<VkLayerProperties> Layers(LayersCount);
+			vkEnumerateInstanceLayerProperties(&LayersCount, Layers.data());
+
+			for (const auto& Layer : Layers)
+			{
+				if (std::string(Layer.layerName) == "VK_LAYER_KHRONOS_validation")
+				{
+					ValidationLayer.push_back("VK_LAYER_KHRONOS_validation");
+				}
+			}
+		}
 		VkInstanceCreateInfo CreationInfo{};
-		CreationInfo.enabledExtensionCount = 2;
+		CreationInfo.enabledExtensionCount = static_cast<uint32_t>(InstanceExtensions.size());
 		CreationInfo.ppEnabledExtensionNames = InstanceExtensions.data();
-		CreationInfo.enabledLayerCount = 1;
+		CreationInfo.enabledLayerCount = static_cast<uint32_t>(ValidationLayer.size());
 		CreationInfo.ppEnabledLayerNames = ValidationLayer.data();
 		CreationInfo.pApplicationInfo = &AppInfo;
 		CreationInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -530,26 +701,26 @@ int main()
 	}
 
 	// Presentation window creation.
-	glfwInit();
-	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-	glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-	GLFWwindow* PresentationWindow = glfwCreateWindow(1600, 900, "Vulkan Tutorial", nullptr, nullptr);
-	if (!PresentationWindow)
+	GLFWwindow* PresentationWindow = nullptr;
+	if (!Options.IsHeadless)
 	{
-		std::cerr << "Failed to create window." << std::endl;
-		exit(0);
+		TUTORIAL_VK_PROFILE_ZONE("Create window");
+
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		// Window is resizable, swapchain and render targets follow its size.
+		PresentationWindow = glfwCreateWindow(static_cast<int>(Options.Resolution.width), static_cast<int>(Options.Resolution.height), "Vulkan Tutorial", nullptr, nullptr);
+		if (!PresentationWindow)
+		{
+			std::cerr << "Failed to create window." << std::endl;
+			exit(0);
+		}
 	}
-	
 
 	// Window surface creation.
 	VkSurfaceKHR Surface{};
+	if (!Options.IsHeadless)
 	{
-		VkWin32SurfaceCreateInfoKHR CreationInfo{};
-		CreationInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
-		CreationInfo.hwnd = glfwGetWin32Window(PresentationWindow);
-		CreationInfo.hinstance = GetModuleHandleA(nullptr);
-
-		if (vkCreateWin32SurfaceKHR(Instance, &CreationInfo, nullptr, &Surface) != VK_SUCCESS)
+		if (glfwCreateWindowSurface(Instance, PresentationWindow, nullptr, &Surface) != VK_SUCCESS)
 		{
 			std::cerr << "Failed to associate window with Vulkan surface." << std::endl;
 			exit(0);
@@ -559,6 +730,7 @@ int main()
 	// Device selection.
 	std::vector<uint32_t> QueueFamiliesIndices;
 	VkQueue GraphicsQueue{};
+	VkQueue AsyncComputeQueue{};
 	SwapchainCreationInfo SupportedSwapchainCapabilities;
 	VkDevice Device = CreateDevice(Instance, DeviceInfos, Surface, QueueFamiliesIndices, SupportedSwapchainCapabilities);
 	if (Device)
@@ -575,45 +747,126 @@ int main()
 		exit(0);
 	}
 	vkGetDeviceQueue(Device, QueueFamiliesIndices[QueueFamilyIndex::Graphics], 0, &GraphicsQueue);
+	vkGetDeviceQueue(Device, QueueFamiliesIndices[QueueFamilyIndex::AsyncCompute], 0, &AsyncComputeQueue);
 
-	// Swapchain creation.
+	// Swapchain creation. Headless mode renders into offscreen images standing in for swapchain images, one per frame in flight.
+	// Both are created again, together with their views, whenever resolution changes.
 	VkSwapchainKHR Swapchain{};
-	{
-		VkSwapchainCreateInfoKHR CreationInfo{};
-		CreationInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-		CreationInfo.surface = Surface;
-		CreationInfo.minImageCount = 2;
-		CreationInfo.imageFormat = SupportedSwapchainCapabilities.ExposedSurfaceFormat.format;
-		CreationInfo.imageColorSpace = SupportedSwapchainCapabilities.ExposedSurfaceFormat.colorSpace;
-		CreationInfo.imageExtent.width = 1600;
-		CreationInfo.imageExtent.height = 900;
-		CreationInfo.imageArrayLayers = 1;
-		CreationInfo.imageUsage = VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-		CreationInfo.imageSharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE;
-		CreationInfo.pQueueFamilyIndices = reinterpret_cast<const uint32_t*>(QueueFamiliesIndices.data());
-		CreationInfo.preTransform = VkSurfaceTransformFlagBitsKHR::VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
-		CreationInfo.compositeAlpha = VkCompositeAlphaFlagBitsKHR::VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-		CreationInfo.presentMode = SupportedSwapchainCapabilities.ExposedPresentMode;
-		CreationInfo.clipped = VK_TRUE;
-
-		if (vkCreateSwapchainKHR(Device, &CreationInfo, nullptr, &Swapchain) != VK_SUCCESS)
-		{
-			std::cerr << "Failed to create swapchain." << std::endl;
-			exit(0);
-		}
-	}
-	// Retrieve swapchain buffers.
 	std::vector<VkImage> SwapchainBuffers;
+	std::vector<VkDeviceMemory> OffscreenBuffersMemory;
+	std::vector<VkImageView> SwapchainBuffersViews;
+	VkExtent2D FrameExtent = Options.Resolution;
+
+	// Size of window surface, which may differ from requested window size. Zero while window is minimized.
+	const auto QuerySurfaceExtent = [&]()
 	{
-		uint32_t ImagesCount = 0;
-		vkGetSwapchainImagesKHR(Device, Swapchain, &ImagesCount, nullptr);
-		SwapchainBuffers.resize(ImagesCount);
-		vkGetSwapchainImagesKHR(Device, Swapchain, &ImagesCount, SwapchainBuffers.data());
-	}
+		VkSurfaceCapabilitiesKHR Capabilities{};
+		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(SupportedSwapchainCapabilities.PhysicalDevice, Surface, &Capabilities);
+		if (Capabilities.currentExtent.width != UINT32_MAX)
+			return Capabilities.currentExtent;
 
-	// Create swapchain buffer view.
-	std::vector<VkImageView> SwapchainBuffersViews;
+		// Surface takes size of swapchain, which follows framebuffer of window.
+		int Width = 0;
+		int Height = 0;
+		glfwGetFramebufferSize(PresentationWindow, &Width, &Height);
+
+		return VkExtent2D
+		{
+			.width = std::clamp(static_cast<uint32_t>(Width), Capabilities.minImageExtent.width, Capabilities.maxImageExtent.width),
+			.height = std::clamp(static_cast<uint32_t>(Height), Capabilities.minImageExtent.height, Capabilities.maxImageExtent.height)
+		};
+	};
+
+	const auto CreateFrameImages = [&]()
 	{
+		if (!Options.IsHeadless)
+		{
+			TUTORIAL_VK_PROFILE_ZONE("Create swapchain");
+
+			// Previous swapchain is retired by new one. Device is idle whenever swapchain is recreated, so it's destroyed right away.
+			const VkSwapchainKHR OldSwapchain = Swapchain;
+
+			VkSwapchainCreateInfoKHR CreationInfo{};
+			CreationInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+			CreationInfo.surface = Surface;
+			CreationInfo.minImageCount = 2;
+			CreationInfo.imageFormat = SupportedSwapchainCapabilities.ExposedSurfaceFormat.format;
+			CreationInfo.imageColorSpace = SupportedSwapchainCapabilities.ExposedSurfaceFormat.colorSpace;
+			CreationInfo.imageExtent = FrameExtent;
+			CreationInfo.imageArrayLayers = 1;
+			CreationInfo.imageUsage = VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			CreationInfo.imageSharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE;
+			CreationInfo.pQueueFamilyIndices = reinterpret_cast<const uint32_t*>(QueueFamiliesIndices.data());
+			CreationInfo.preTransform = VkSurfaceTransformFlagBitsKHR::VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+			CreationInfo.compositeAlpha = VkCompositeAlphaFlagBitsKHR::VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+			CreationInfo.presentMode = SupportedSwapchainCapabilities.ExposedPresentMode;
+			CreationInfo.clipped = VK_TRUE;
+			CreationInfo.oldSwapchain = OldSwapchain;
+
+			if (vkCreateSwapchainKHR(Device, &CreationInfo, nullptr, &Swapchain) != VK_SUCCESS)
+			{
+				std::cerr << "Failed to create swapchain." << std::endl;
+				exit(0);
+			}
+			vkDestroySwapchainKHR(Device, OldSwapchain, nullptr);
+
+			// Retrieve swapchain buffers.
+			uint32_t ImagesCount = 0;
+			vkGetSwapchainImagesKHR(Device, Swapchain, &ImagesCount, nullptr);
+			SwapchainBuffers.resize(ImagesCount);
+			vkGetSwapchainImagesKHR(Device, Swapchain, &ImagesCount, SwapchainBuffers.data());
+		}
+		else
+		{
+			TUTORIAL_VK_PROFILE_ZONE("Create offscreen images");
+
+			VkImageCreateInfo CreationInfo
+			{
+				.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.imageType = VK_IMAGE_TYPE_2D,
+				.format = SupportedSwapchainCapabilities.ExposedSurfaceFormat.format,
+				.extent =
+				{
+					.width = FrameExtent.width,
+					.height = FrameExtent.height,
+					.depth = 1
+				},
+				.mipLevels = 1,
+				.arrayLayers = 1,
+				.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
+				.tiling = VkImageTiling::VK_IMAGE_TILING_OPTIMAL,
+				.usage = VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_DST_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+				.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
+				.queueFamilyIndexCount = 1,
+				.pQueueFamilyIndices = &QueueFamiliesIndices[QueueFamilyIndex::Graphics],
+				.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+			};
+
+			SwapchainBuffers.resize(TUTORIAL_VK_FRAMES_IN_FLIGHT);
+			OffscreenBuffersMemory.resize(TUTORIAL_VK_FRAMES_IN_FLIGHT);
+			for (uint32_t i = 0; i < TUTORIAL_VK_FRAMES_IN_FLIGHT; i++)
+			{
+				GPUMemory.CreateImage(Device, CreationInfo, SwapchainBuffers[i], "Headless", "Offscreen image");
+
+				VkMemoryRequirements MemoryRequirements;
+				vkGetImageMemoryRequirements(Device, SwapchainBuffers[i], &MemoryRequirements);
+
+				VkMemoryAllocateInfo AllocationInfo
+				{
+					.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+					.pNext = nullptr,
+					.allocationSize = MemoryRequirements.size,
+					.memoryTypeIndex = QueryMemoryTypeIndex(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryRequirements.memoryTypeBits, DeviceMemoryInfo)
+				};
+
+				GPUMemory.AllocateMemory(Device, AllocationInfo, OffscreenBuffersMemory[i], "Headless", "Offscreen image");
+				GPUMemory.BindImageMemory(Device, SwapchainBuffers[i], OffscreenBuffersMemory[i], 0);
+			}
+		}
+
+		// Create swapchain buffer view.
 		for (const auto& SwapchainBuffer : SwapchainBuffers)
 		{
 			VkImageViewCreateInfo CreationInfo{};
@@ -636,92 +889,41 @@ int main()
 
 			SwapchainBuffersViews.push_back(BufferView);
 		}
-	}
-
-	LoadScene(Device);
+	};
 
-	// Setup depth buffer.
-	VkImage DepthBuffer{};
-	VkImageView DepthBufferView{};
-	VkDeviceMemory DepthBufferMemory;
+	// Swapchain itself is kept, so it can be retired by its successor.
+	const auto FreeFrameImages = [&]()
 	{
-		const uint32_t QueueIndex = static_cast<uint32_t>(QueueFamiliesIndices[QueueFamilyIndex::Graphics]);
-
-		VkImageCreateInfo ImageCreationInfo
-		{
-			.sType = VkStructureType::VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-			.pNext = nullptr,
-			.flags = 0,
-			.imageType = VkImageType::VK_IMAGE_TYPE_2D,
-			.format = VkFormat::VK_FORMAT_D32_SFLOAT,
-			.extent =
-			VkExtent3D
-			{
-				.width = 1600,
-				.height = 900,
-				.depth = 1
-			},
-			.mipLevels = 1,
-			.arrayLayers = 1,
-			.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT,
-			.tiling = VkImageTiling::VK_IMAGE_TILING_OPTIMAL,
-			.usage = VkImageUsageFlagBits::VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-			.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
-			.queueFamilyIndexCount = 1,
-			.pQueueFamilyIndices = &QueueIndex,
-			.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED
-		};
-
-		vkCreateImage(Device, &ImageCreationInfo, nullptr, &DepthBuffer);
-
-		VkMemoryRequirements MemoryRequirements{};
-		vkGetImageMemoryRequirements(Device, DepthBuffer, &MemoryRequirements);
-
-		VkMemoryAllocateInfo AllocationInfo
-		{
-			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-			.pNext = nullptr,
-			.allocationSize = MemoryRequirements.size,
-			.memoryTypeIndex = QueryMemoryTypeIndex(VkMemoryPropertyFlagBits::VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryRequirements.memoryTypeBits, DeviceMemoryInfo)
-		};
-
-		vkAllocateMemory(Device, &AllocationInfo, nullptr, &DepthBufferMemory);
-
-		vkBindImageMemory(Device, DepthBuffer, DepthBufferMemory, 0);
-
-		VkImageSubresourceRange SubresourceRangeInfo
+		for (const auto& SwapchainBufferView : SwapchainBuffersViews)
 		{
-			.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_DEPTH_BIT,
-			.baseMipLevel = 0,
-			.levelCount = 1,
-			.baseArrayLayer = 0,
-			.layerCount = 1
-		};
+			vkDestroyImageView(Device, SwapchainBufferView, nullptr);
+		}
+		SwapchainBuffersViews.clear();
 
-		VkImageViewCreateInfo ImageViewCreationInfo
+		if (Options.IsHeadless)
 		{
-			.sType = VkStructureType::VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-			.pNext = nullptr,
-			.flags = 0,
-			.image = DepthBuffer,
-			.viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D,
-			.format = VkFormat::VK_FORMAT_D32_SFLOAT,
-			.components = VkComponentMapping
-			{
-				.r = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-				.g = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-				.b = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY,
-				.a = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY
-			},
-			.subresourceRange = SubresourceRangeInfo
-		};
+			for (size_t i = 0; i < SwapchainBuffers.size(); i++)
+			{
+				GPUMemory.DestroyImage(Device, SwapchainBuffers[i]);
+				GPUMemory.FreeMemory(Device, OffscreenBuffersMemory[i]);
+			}
+			OffscreenBuffersMemory.clear();
+		}
+		SwapchainBuffers.clear();
+	};
 
-		vkCreateImageView(Device, &ImageViewCreationInfo, nullptr, &DepthBufferView);
+	if (!Options.IsHeadless)
+	{
+		FrameExtent = QuerySurfaceExtent();
 	}
+	CreateFrameImages();
 
-	// Create command buffers.
+	// Layout in which frame is handed over to presentation engine, or kept for readback when rendering headless.
+	const VkImageLayout PresentationLayout = Options.IsHeadless ? VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VkImageLayout::VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+	// Create command pools. Command buffers are allocated once frame graph is split into submit batches.
 	VkCommandPool CommandPool{};
-	VkCommandBuffer CommandBuffer{};
+	VkCommandPool AsyncComputeCommandPool{};
 	{
 		VkCommandPoolCreateInfo CreationInfo{};
 		CreationInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -730,50 +932,121 @@ int main()
 
 		vkCreateCommandPool(Device, &CreationInfo, nullptr, &CommandPool);
 
-		{
-			VkCommandBufferAllocateInfo AllocationInfo
-			{
-				.sType = VkStructureType::VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-				.pNext = nullptr,
-				.commandPool = CommandPool,
-				.level = VkCommandBufferLevel::VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-				.commandBufferCount = 1
-			};
-
-			vkAllocateCommandBuffers(Device, &AllocationInfo, &CommandBuffer);
-		}
+		CreationInfo.queueFamilyIndex = QueueFamiliesIndices[QueueFamilyIndex::AsyncCompute];
+		vkCreateCommandPool(Device, &CreationInfo, nullptr, &AsyncComputeCommandPool);
 	}
 
-	std::unique_ptr<GBufferGenerationPass> GBufferGeneration = std::make_unique<GBufferGenerationPass>(Device, QueueFamiliesIndices[QueueFamilyIndex::Graphics], DeviceMemoryInfo, DepthBufferView);
-	GBufferGeneration->SetupShaders();
-	GBufferGeneration->SetupPipeline();
+	// Workers recording large scenes into secondary command buffers. Main thread only waits for them, so one core is left for it.
+	const uint32_t RecordingWorkersCount = (std::max)(std::thread::hardware_concurrency(), 2u) - 1;
+	std::unique_ptr<ParallelCommandRecorder> Recorder = std::make_unique<ParallelCommandRecorder>(Device, QueueFamiliesIndices[QueueFamilyIndex::Graphics], RecordingWorkersCount);
 
-	std::unique_ptr<ShadowMapGenerationPass> ShadowMapGeneration = std::make_unique<ShadowMapGenerationPass>(Device, QueueFamiliesIndices[QueueFamilyIndex::Graphics], DeviceMemoryInfo);
-	ShadowMapGeneration->SetupShaders();
-	ShadowMapGeneration->SetupPipeline();
+	// Per-frame uniform data. Each partition holds constants of one frame.
+	constexpr uint32_t UniformRingBufferPartitions = TUTORIAL_VK_FRAMES_IN_FLIGHT;
+	constexpr VkDeviceSize UniformRingBufferPartitionSize = 64 * 1024;
+	std::unique_ptr<UniformRingBuffer> FrameUniforms = std::make_unique<UniformRingBuffer>(Device, QueueFamiliesIndices[QueueFamilyIndex::Graphics], DeviceMemoryInfo, DeviceInfos.Limits, UniformRingBufferPartitionSize, UniformRingBufferPartitions);
 
-	DeferredAdditionalRequiredInfo AdditionalInfo
+	// Render targets of all passes share memory whenever their lifetimes within frame don't overlap.
+	std::unique_ptr<RenderTargetHeap> RenderTargets = std::make_unique<RenderTargetHeap>(Device, DeviceMemoryInfo);
+
+	// Passes are created and their render targets declared on one worker, because heap can't be used concurrently.
+	// Scene is loaded meanwhile, and pipelines of all passes are compiled concurrently once passes exist.
+	std::unique_ptr<GBufferGenerationPass> GBufferGeneration;
+	std::unique_ptr<ShadowMapGenerationPass> ShadowMapGeneration;
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+	std::unique_ptr<ShadowMapFilteringPass> ShadowMapFiltering;
+#endif
+	std::unique_ptr<DeferredPass> DeferredShading;
+	std::unique_ptr<PersistentPipelineCache> PipelineCache;
+
+	// All shader modules come from one archive mapped into memory, which outlives pipelines created from them.
+	std::unique_ptr<ShaderArchive> Shaders = std::make_unique<ShaderArchive>(Device, "shaders/shaders.spvpack");
+
+	StartupTaskGraph StartupTasks;
+	StartupTasks.AddTask("Load scene", [&]
 	{
-		.GBufferPositionView = GBufferGeneration->SharedResources.GBufferPositionImageViewLink,
-		.GBufferNormalView = GBufferGeneration->SharedResources.GBufferNormalImageViewLink,
-		.LightSpaceUniformBuffer = ShadowMapGeneration->SharedResources.LightSpaceUniformBuffer,
-		.VarianceShadowMapView = ShadowMapGeneration->SharedResources.VarianceShadowMap
-	};
+		LoadScene(Device, Options.SceneName);
+	});
 
-	std::unique_ptr<DeferredPass> DeferredShading = std::make_unique<DeferredPass>(Device, QueueFamiliesIndices[QueueFamilyIndex::Graphics], DeviceMemoryInfo, AdditionalInfo);
-	DeferredShading->SetupShaders();
-	DeferredShading->SetupPipeline();
+	// Pipelines are compiled from SPIR-V only when cache of previous launch is missing or made by other device or driver.
+	const uint32_t PipelineCacheTask = StartupTasks.AddTask("Load pipeline cache", [&]
+	{
+		PipelineCache = std::make_unique<PersistentPipelineCache>(Device, DeviceInfos.Properties, "pipeline_cache.bin");
+	});
 
-	VkFence PresentationFence{};
+	const uint32_t PassesTask = StartupTasks.AddTask("Create passes", [&]
 	{
-		VkFenceCreateInfo CreationInfo{};
-		CreationInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		CreationInfo.flags = VkFenceCreateFlagBits::VK_FENCE_CREATE_SIGNALED_BIT;
+		GBufferGeneration = std::make_unique<GBufferGenerationPass>(Device, QueueFamiliesIndices[QueueFamilyIndex::Graphics], DeviceMemoryInfo, *FrameUniforms);
+		GBufferGeneration->SetExtent(FrameExtent);
+		GBufferGeneration->DeclareRenderTargets(*RenderTargets);
 
-		vkCreateFence(Device, &CreationInfo, nullptr, &PresentationFence);
-	}
-	VkSemaphore QueueSemaphore{};
-	VkSemaphore AcquireNextImageSemaphore{};
+		ShadowMapGeneration = std::make_unique<ShadowMapGenerationPass>(Device, QueueFamiliesIndices[QueueFamilyIndex::Graphics], DeviceMemoryInfo, *FrameUniforms);
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+		ShadowMapGeneration->SetFilteringQueueIndex(QueueFamiliesIndices[QueueFamilyIndex::AsyncCompute]);
+#endif
+		ShadowMapGeneration->DeclareRenderTargets(*RenderTargets);
+
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+		ShadowMapFiltering = std::make_unique<ShadowMapFilteringPass>(Device, QueueFamiliesIndices[QueueFamilyIndex::AsyncCompute], ShadowMapGeneration->SharedResources.VarianceShadowMap);
+		ShadowMapFiltering->DeclareRenderTargets(*RenderTargets);
+#endif
+
+		DeferredAdditionalRequiredInfo AdditionalInfo
+		{
+			.GBufferPositionView = GBufferGeneration->SharedResources.GBufferPositionImageViewLink,
+			.GBufferNormalView = GBufferGeneration->SharedResources.GBufferNormalImageViewLink,
+			.GBufferDepthView = GBufferGeneration->SharedResources.DepthBufferViewLink,
+			.LightSpaceUniformBuffer = ShadowMapGeneration->SharedResources.LightSpaceUniformBuffer,
+			.LightSpaceUniformOffset = ShadowMapGeneration->SharedResources.LightSpaceUniformOffset,
+			.LightSpaceUniformRange = sizeof(ShadowMapGenerationPass::LightSpaceContent),
+			.VarianceShadowMapView = ShadowMapGeneration->SharedResources.VarianceShadowMap,
+			.SwapchainFormat = SupportedSwapchainCapabilities.ExposedSurfaceFormat.format,
+			.SwapchainViews = &SwapchainBuffersViews
+		};
+
+		DeferredShading = std::make_unique<DeferredPass>(Device, QueueFamiliesIndices[QueueFamilyIndex::Graphics], DeviceMemoryInfo, AdditionalInfo);
+		DeferredShading->SetExtent(FrameExtent);
+		DeferredShading->DeclareRenderTargets(*RenderTargets);
+		GBufferGeneration->SetSceneRenderPass(DeferredShading->SharedResources.SceneRenderPass);
+
+		RenderTargets->Commit();
+		RenderTargets->ReportFootprint();
+	});
+
+	// Pass reading render targets of other pass writes their views into its descriptors, so it waits for their setup.
+	const uint32_t GBufferTargetsTask = StartupTasks.AddTask("Setup G-buffer generation render targets", [&] { GBufferGeneration->SetupRenderTargets(); }, { PassesTask });
+	const uint32_t ShadowMapTargetsTask = StartupTasks.AddTask("Setup shadow map generation render targets", [&] { ShadowMapGeneration->SetupRenderTargets(); }, { PassesTask });
+	StartupTasks.AddTask("Setup deferred shading render targets", [&] { DeferredShading->SetupRenderTargets(); }, { GBufferTargetsTask, ShadowMapTargetsTask });
+
+	const uint32_t GBufferShadersTask = StartupTasks.AddTask("Setup G-buffer generation shaders", [&] { GBufferGeneration->SetupShaders(*Shaders); }, { PassesTask });
+	const uint32_t ShadowMapShadersTask = StartupTasks.AddTask("Setup shadow map generation shaders", [&] { ShadowMapGeneration->SetupShaders(*Shaders); }, { PassesTask });
+	const uint32_t DeferredShadersTask = StartupTasks.AddTask("Setup deferred shading shaders", [&] { DeferredShading->SetupShaders(*Shaders); }, { PassesTask });
+
+	StartupTasks.AddTask("Compile G-buffer generation pipeline", [&] { GBufferGeneration->SetupPipeline(PipelineCache->GetCache()); }, { PipelineCacheTask, GBufferShadersTask });
+	StartupTasks.AddTask("Compile shadow map generation pipeline", [&] { ShadowMapGeneration->SetupPipeline(PipelineCache->GetCache()); }, { PipelineCacheTask, ShadowMapShadersTask });
+	StartupTasks.AddTask("Compile deferred shading pipeline", [&] { DeferredShading->SetupPipeline(PipelineCache->GetCache()); }, { PipelineCacheTask, DeferredShadersTask });
+
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+	StartupTasks.AddTask("Setup shadow map filtering render targets", [&] { ShadowMapFiltering->SetupRenderTargets(); }, { ShadowMapTargetsTask });
+	const uint32_t ShadowMapFilteringShadersTask = StartupTasks.AddTask("Setup shadow map filtering shaders", [&] { ShadowMapFiltering->SetupShaders(*Shaders); }, { PassesTask });
+	StartupTasks.AddTask("Compile shadow map filtering pipeline", [&] { ShadowMapFiltering->SetupPipeline(PipelineCache->GetCache()); }, { PipelineCacheTask, ShadowMapFilteringShadersTask });
+#endif
+
+	StartupTasks.Execute(std::thread::hardware_concurrency());
+	StartupTasks.ReportTimings();
+
+	std::cout << "Pipelines created from " << (PipelineCache->IsWarm() ? "warm" : "cold") << " pipeline cache." << std::endl;
+	PipelineCache->Save();
+
+	// Every submission to queue signals next value of its timeline. Frame slot remembers graphics value of its last frame,
+	// which also implies completion of its compute work, because every compute batch is waited for by later graphics batch.
+	std::unique_ptr<QueueTimeline> GraphicsTimeline = std::make_unique<QueueTimeline>(Device);
+	std::unique_ptr<QueueTimeline> AsyncComputeTimeline = std::make_unique<QueueTimeline>(Device);
+	std::vector<uint64_t> FrameSlotsTimelineValues(TUTORIAL_VK_FRAMES_IN_FLIGHT, 0);
+
+	// Swapchain supports only binary semaphores. Acquire semaphores belong to frames in flight. Semaphores waited by presentation belong to swapchain images,
+	// because only reacquiring image guarantees that its previous presentation doesn't wait for semaphore anymore.
+	std::vector<VkSemaphore> QueueSemaphores(SwapchainBuffers.size());
+	std::vector<VkSemaphore> AcquireNextImageSemaphores(TUTORIAL_VK_FRAMES_IN_FLIGHT);
 	{
 		VkSemaphoreCreateInfo CreationInfo
 		{
@@ -782,8 +1055,14 @@ int main()
 			.flags = 0
 		};
 
-		vkCreateSemaphore(Device, &CreationInfo, nullptr, &QueueSemaphore);
-		vkCreateSemaphore(Device, &CreationInfo, nullptr, &AcquireNextImageSemaphore);
+		for (auto& QueueSemaphore : QueueSemaphores)
+		{
+			vkCreateSemaphore(Device, &CreationInfo, nullptr, &QueueSemaphore);
+		}
+		for (auto& AcquireNextImageSemaphore : AcquireNextImageSemaphores)
+		{
+			vkCreateSemaphore(Device, &CreationInfo, nullptr, &AcquireNextImageSemaphore);
+		}
 	}
 
 	// Setup presentation.	
@@ -793,7 +1072,7 @@ int main()
 		.sType = VkStructureType::VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
 		.pNext = nullptr,
 		.waitSemaphoreCount = 1,
-		.pWaitSemaphores = &QueueSemaphore,
+		.pWaitSemaphores = nullptr, // Set for every frame.
 		.swapchainCount = 1,
 		.pSwapchains = &Swapchain,
 		.pImageIndices = &ImageIndex,
@@ -814,17 +1093,17 @@ int main()
 	{
 		.sType = VkStructureType::VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
 		.pNext = nullptr,
-		.semaphore = QueueSemaphore,
-		.value = 1,
-		.stageMask = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
+		.semaphore = VK_NULL_HANDLE, // Set for every frame.
+		.value = 0, // Ignored for binary semaphores.
+		.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
 		.deviceIndex = 0
 	};
 	VkSemaphoreSubmitInfo PresentationSemaphoreSubmitInfo
 	{
 		.sType = VkStructureType::VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
 		.pNext = nullptr,
-		.semaphore = AcquireNextImageSemaphore,
-		.value = 1,
+		.semaphore = VK_NULL_HANDLE, // Set for every frame.
+		.value = 0, // Ignored for binary semaphores.
 		.stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
 		.deviceIndex = 0
 	};
@@ -833,40 +1112,139 @@ int main()
 	{
 		.sType = VkStructureType::VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
 		.pNext = nullptr,
-		.commandBuffer = CommandBuffer,
+		.commandBuffer = VK_NULL_HANDLE, // Set for every batch.
 		.deviceMask = 0
 	};
 
-	VkSubmitInfo2 SubmitInfo
+
+	// GPU time of every pass, read back when frame slot is reused.
+	std::unique_ptr<GPUTimestampProfiler> PassProfiler = std::make_unique<GPUTimestampProfiler>(Device, DeviceInfos.Limits, DeviceInfos.TimestampValidBits, TUTORIAL_VK_FRAMES_IN_FLIGHT);
+	const uint32_t GBufferGenerationZone = PassProfiler->RegisterZone("GBufferGeneration");
+	const uint32_t ShadowMapGenerationZone = PassProfiler->RegisterZone("ShadowMapGeneration");
+	const uint32_t DeferredShadingZone = PassProfiler->RegisterZone("DeferredShading");
+#ifndef TUTORIAL_VK_DIRECT_TO_SWAPCHAIN
+	const uint32_t PresentationBlitZone = PassProfiler->RegisterZone("PresentationBlit");
+#endif
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+	// Recorded on async compute queue, so its time shows whether blur overlaps with G-buffer generation.
+	const uint32_t ShadowMapFilteringZone = PassProfiler->RegisterZone("ShadowMapFiltering", DeviceInfos.AsyncComputeTimestampValidBits);
+#endif
+
+	// Shading load of every pass, read back together with pass times. Statistics queries can't be split between subpasses
+	// whose content is recorded in secondary command buffers, so both subpasses of scene render pass are gathered together.
+	std::unique_ptr<PipelineStatisticsProfiler> PassStatistics = std::make_unique<PipelineStatisticsProfiler>(Device, DeviceInfos.IsPipelineStatisticsSupported, TUTORIAL_VK_FRAMES_IN_FLIGHT);
+	const uint32_t ShadowMapGenerationStatistics = PassStatistics->RegisterZone("ShadowMapGeneration");
+	const uint32_t SceneRenderingStatistics = PassStatistics->RegisterZone("SceneRendering");
+	Recorder->SetInheritedPipelineStatistics(PassStatistics->GetInheritedStatistics());
+
+	// Benchmark renders fixed count of frames with scripted camera and light.
+	std::unique_ptr<FrameBenchmark> Benchmark;
+	if (Options.IsBenchmark)
 	{
-		.sType = VkStructureType::VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
-		.pNext = nullptr,
-		.flags = 0,
-		.waitSemaphoreInfoCount = 1,
-		.pWaitSemaphoreInfos = &PresentationSemaphoreSubmitInfo,
-		.commandBufferInfoCount = 1,
-		.pCommandBufferInfos = &CmdBufSubmitInfo,
-		.signalSemaphoreInfoCount = 1,
-		.pSignalSemaphoreInfos = &QueueSemaphoreSubmitInfo
-	};
+		Benchmark = std::make_unique<FrameBenchmark>(Options.SceneName, DeviceInfos.HardwareName, Options.WarmupFramesCount, Options.FramesCount);
+	}
 
+	// Submit time of frames whose completion hasn't been observed yet. Completion is polled every loop iteration, so measuring
+	// doesn't require waiting for each frame, but measured time is upper bound of GPU completion including CPU time until next poll.
+	// GPU time of frame itself is given by pass zones.
+	std::vector<std::optional<std::chrono::steady_clock::time_point>> FrameSlotsSubmitTimes(TUTORIAL_VK_FRAMES_IN_FLIGHT);
+	std::vector<uint32_t> FrameSlotsFrameIndices(TUTORIAL_VK_FRAMES_IN_FLIGHT, 0);
+	const auto ObserveCompletedFrames = [&]()
+	{
+		const uint64_t CompletedValue = GraphicsTimeline->GetCompletedValue();
+		const auto ObservationTime = std::chrono::steady_clock::now();
 
-	// Main app loop.
-	while (!glfwWindowShouldClose(PresentationWindow) && TUTORIAL_VK_DEBUG_DEALLOCATIONS)
+		for (uint32_t Slot = 0; Slot < TUTORIAL_VK_FRAMES_IN_FLIGHT; Slot++)
+		{
+			if (FrameSlotsSubmitTimes[Slot] && FrameSlotsTimelineValues[Slot] <= CompletedValue)
+			{
+				Benchmark->AddSample(FrameSlotsFrameIndices[Slot], "Submit to observed completion", std::chrono::duration<double, std::milli>(ObservationTime - *FrameSlotsSubmitTimes[Slot]).count());
+				FrameSlotsSubmitTimes[Slot].reset();
+			}
+		}
+	};
+
+	const auto ReadPassTimings = [&](const uint32_t FrameSlot)
 	{
-		glfwPollEvents();
+		if (PassProfiler->ReadFrame(FrameSlot) && Benchmark)
+		{
+			for (uint32_t Zone = 0; Zone < PassProfiler->GetZonesCount(); Zone++)
+			{
+				if (PassProfiler->GetLastTiming(Zone) >= 0.0)
+				{
+					Benchmark->AddSample(FrameSlotsFrameIndices[FrameSlot], "GPU " + PassProfiler->GetZoneName(Zone), PassProfiler->GetLastTiming(Zone));
+				}
+			}
+		}
 
-		vkResetFences(Device, 1, &PresentationFence);		
-		vkAcquireNextImageKHR(Device, Swapchain, UINT64_MAX, AcquireNextImageSemaphore, VK_NULL_HANDLE, &ImageIndex);
-		vkBeginCommandBuffer(CommandBuffer, &BeginInfo);
+		if (PassStatistics->ReadFrame(FrameSlot) && Benchmark)
+		{
+			for (uint32_t Zone = 0; Zone < PassStatistics->GetZonesCount(); Zone++)
+			{
+				PipelineStatisticsProfiler::Statistics ZoneStatistics;
+				if (!PassStatistics->GetLastStatistics(Zone, ZoneStatistics))
+					continue;
 
-		GBufferGeneration->RecordCommandBuffer(CommandBuffer, Actors);
-		ShadowMapGeneration->RecordCommandBuffer(CommandBuffer, Actors);
-		DeferredShading->RecordCommandBuffer(CommandBuffer);
+				for (uint32_t CounterIndex = 0; CounterIndex < PipelineStatisticsProfiler::Counter::CountersCount; CounterIndex++)
+				{
+					Benchmark->AddSample(FrameSlotsFrameIndices[FrameSlot], PassStatistics->GetZoneName(Zone) + " " + PipelineStatisticsProfiler::GetCounterName(static_cast<PipelineStatisticsProfiler::Counter>(CounterIndex)),
+						static_cast<double>(ZoneStatistics[CounterIndex]), "");
+				}
+			}
+		}
+	};
+
+	// Passes are recorded in order derived from images they read and write, separated by barriers derived from the same declarations.
+	std::unique_ptr<RenderGraph> FrameGraph = std::make_unique<RenderGraph>(*RenderTargets);
+	const uint32_t SwapchainResource = FrameGraph->ImportImage("Swapchain", VK_IMAGE_ASPECT_COLOR_BIT,
+		RenderGraphUsage{ .StageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, .AccessMask = VK_ACCESS_2_NONE, .Layout = VK_IMAGE_LAYOUT_UNDEFINED }, // Stage waiting for acquire semaphore.
+		RenderGraphUsage{ .StageMask = VK_PIPELINE_STAGE_2_NONE, .AccessMask = VK_ACCESS_2_NONE, .Layout = PresentationLayout });
+	FrameGraph->MarkOutput(SwapchainResource);
+	{
+		const uint32_t ShadowMapGenerationNode = FrameGraph->AddPass("ShadowMapGeneration", FrameStage::ShadowMapGenerationStage, [&](const RenderGraphContext& Context)
+		{
+			PassProfiler->RecordZoneBegin(Context.CommandBuffer, Context.FrameSlot, ShadowMapGenerationZone);
+			PassStatistics->RecordZoneBegin(Context.CommandBuffer, Context.FrameSlot, ShadowMapGenerationStatistics);
+			ShadowMapGeneration->RecordCommandBuffer(Context.CommandBuffer, *SceneGeometry, Actors, *Recorder);
+			PassStatistics->RecordZoneEnd(Context.CommandBuffer, Context.FrameSlot, ShadowMapGenerationStatistics);
+			PassProfiler->RecordZoneEnd(Context.CommandBuffer, Context.FrameSlot, ShadowMapGenerationZone);
+		});
+		ShadowMapGeneration->DeclareGraphUsage(*FrameGraph, ShadowMapGenerationNode);
+
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+		// Without dedicated compute family filtering stays on graphics queue, recorded between the same passes.
+		const RenderGraphQueue FilteringQueue = QueueFamiliesIndices[QueueFamilyIndex::AsyncCompute] != QueueFamiliesIndices[QueueFamilyIndex::Graphics] ? AsyncComputeGraphQueue : GraphicsGraphQueue;
+		const uint32_t ShadowMapFilteringNode = FrameGraph->AddPass("ShadowMapFiltering", FrameStage::ShadowMapGenerationStage, [&](const RenderGraphContext& Context)
+		{
+			PassProfiler->RecordZoneBegin(Context.CommandBuffer, Context.FrameSlot, ShadowMapFilteringZone);
+			ShadowMapFiltering->RecordCommandBuffer(Context.CommandBuffer);
+			PassProfiler->RecordZoneEnd(Context.CommandBuffer, Context.FrameSlot, ShadowMapFilteringZone);
+		}, FilteringQueue);
+		ShadowMapFiltering->DeclareGraphUsage(*FrameGraph, ShadowMapFilteringNode);
+#endif
+
+		// G-buffer generation and deferred shading are subpasses of one render pass, timestamp between them is written in deferred shading subpass.
+		const uint32_t SceneRenderingNode = FrameGraph->AddPass("SceneRendering", FrameStage::SceneRenderingStage, [&](const RenderGraphContext& Context)
+		{
+			PassProfiler->RecordZoneBegin(Context.CommandBuffer, Context.FrameSlot, GBufferGenerationZone);
+			PassStatistics->RecordZoneBegin(Context.CommandBuffer, Context.FrameSlot, SceneRenderingStatistics);
+			GBufferGeneration->RecordCommandBuffer(Context.CommandBuffer, Context.SwapchainImageIndex, *SceneGeometry, Actors, *Recorder);
+			PassProfiler->RecordZoneEnd(Context.CommandBuffer, Context.FrameSlot, GBufferGenerationZone);
+
+			PassProfiler->RecordZoneBegin(Context.CommandBuffer, Context.FrameSlot, DeferredShadingZone);
+			DeferredShading->RecordCommandBuffer(Context.CommandBuffer);
+			PassStatistics->RecordZoneEnd(Context.CommandBuffer, Context.FrameSlot, SceneRenderingStatistics);
+			PassProfiler->RecordZoneEnd(Context.CommandBuffer, Context.FrameSlot, DeferredShadingZone);
+		});
+		GBufferGeneration->DeclareGraphUsage(*FrameGraph, SceneRenderingNode);
+		DeferredShading->DeclareGraphUsage(*FrameGraph, SceneRenderingNode);
+
+#ifndef TUTORIAL_VK_DIRECT_TO_SWAPCHAIN
+		// Copies rendered frame into swapchain.
+		const uint32_t PresentationBlitNode = FrameGraph->AddPass("PresentationBlit", FrameStage::PresentationStage, [&](const RenderGraphContext& Context)
 		{
-			MakeImageTransition(CommandBuffer, *DeferredShading->SharedResources.ResultImage, VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, QueueFamiliesIndices[QueueFamilyIndex::Graphics]);
-			MakeImageTransition(CommandBuffer, SwapchainBuffers[ImageIndex], VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED, VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, QueueFamiliesIndices[QueueFamilyIndex::Graphics]);
-			// There will be copy already rendered frame into swapchain.
+			PassProfiler->RecordZoneBegin(Context.CommandBuffer, Context.FrameSlot, PresentationBlitZone);
+
 			VkImageSubresourceLayers SrcLayersInfo
 			{
 				.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT,
@@ -894,8 +1272,8 @@ int main()
 						.z = 0
 					},
 					{
-						.x = 1600,
-						.y = 900,
+						.x = static_cast<int32_t>(FrameExtent.width),
+						.y = static_cast<int32_t>(FrameExtent.height),
 						.z = 1
 					}
 				},
@@ -908,61 +1286,437 @@ int main()
 						.z = 0
 					},
 					{
-						.x = 1600,
-						.y = 900,
+						.x = static_cast<int32_t>(FrameExtent.width),
+						.y = static_cast<int32_t>(FrameExtent.height),
 						.z = 1
 					}
 				}
 			};
 
-			vkCmdBlitImage(CommandBuffer, *DeferredShading->SharedResources.ResultImage, VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, SwapchainBuffers[ImageIndex], VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &BlitInfo, VkFilter::VK_FILTER_NEAREST);
-			MakeImageTransition(CommandBuffer, SwapchainBuffers[ImageIndex], VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VkImageLayout::VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, QueueFamiliesIndices[QueueFamilyIndex::Graphics]);
+			vkCmdBlitImage(Context.CommandBuffer, *DeferredShading->SharedResources.ResultImage, VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, SwapchainBuffers[Context.SwapchainImageIndex], VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &BlitInfo, VkFilter::VK_FILTER_NEAREST);
+
+			PassProfiler->RecordZoneEnd(Context.CommandBuffer, Context.FrameSlot, PresentationBlitZone);
+		});
+		FrameGraph->Read(PresentationBlitNode, FrameGraph->FindResource("DeferredResult"), RenderGraphUsage{ .StageMask = VK_PIPELINE_STAGE_2_BLIT_BIT, .AccessMask = VK_ACCESS_2_TRANSFER_READ_BIT, .Layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL });
+		FrameGraph->Write(PresentationBlitNode, SwapchainResource, RenderGraphUsage{ .StageMask = VK_PIPELINE_STAGE_2_BLIT_BIT, .AccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT, .Layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL }, true);
+#endif
+	}
+	FrameGraph->Compile();
+	FrameGraph->ReportPasses();
+
+	// Create command buffers. Each frame in flight owns one command buffer per swapchain image and graph batch, so every
+	// combination is recorded once and resubmitted unchanged until content of scene changes.
+	const uint32_t BatchesCount = FrameGraph->GetBatchesCount();
+	std::vector<VkCommandBuffer> CommandBuffers;
+	std::vector<std::optional<SceneVersion>> RecordedSceneVersions;
+	const auto AllocateCommandBuffers = [&]()
+	{
+		// Command buffers are only added, those of larger swapchain are reused when it shrinks.
+		const size_t AllocatedCount = CommandBuffers.size();
+		CommandBuffers.resize((std::max)(AllocatedCount, TUTORIAL_VK_FRAMES_IN_FLIGHT * SwapchainBuffers.size() * BatchesCount));
+		for (size_t i = AllocatedCount; i < CommandBuffers.size(); i++)
+		{
+			VkCommandBufferAllocateInfo AllocationInfo
+			{
+				.sType = VkStructureType::VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+				.pNext = nullptr,
+				.commandPool = FrameGraph->GetBatchQueue(i % BatchesCount) == AsyncComputeGraphQueue ? AsyncComputeCommandPool : CommandPool,
+				.level = VkCommandBufferLevel::VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+				.commandBufferCount = 1
+			};
+
+			vkAllocateCommandBuffers(Device, &AllocationInfo, &CommandBuffers[i]);
 		}
 
-		vkEndCommandBuffer(CommandBuffer);
-		vkQueueSubmit2(GraphicsQueue, 1, &SubmitInfo, PresentationFence);
-		vkWaitForFences(Device, 1, &PresentationFence, true, UINT64_MAX);
-		vkQueuePresentKHR(GraphicsQueue, &PresentInfo);
+		// None of command buffers is recorded for current swapchain images.
+		RecordedSceneVersions.assign(TUTORIAL_VK_FRAMES_IN_FLIGHT * SwapchainBuffers.size(), std::nullopt);
+	};
+	AllocateCommandBuffers();
+
+	// Swapchain and all render targets are created again for new resolution. Pipelines use dynamic viewport and scissor,
+	// and neither render passes nor frame graph depend on resolution, so they are kept.
+	const auto ResizeFrame = [&](const VkExtent2D& NewExtent)
+	{
+		TUTORIAL_VK_PROFILE_ZONE("Resize frame");
+
+		// Frames in flight still use render targets and swapchain images.
+		vkDeviceWaitIdle(Device);
+
+		// Render targets share heap memory, so all of them are declared again, not only screen-sized ones.
+		GBufferGeneration->FreeRenderTargets();
+		ShadowMapGeneration->FreeRenderTargets();
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+		ShadowMapFiltering->FreeRenderTargets();
+#endif
+		DeferredShading->FreeRenderTargets();
+		RenderTargets->FreeGPUResources();
+
+		FreeFrameImages();
+		FrameExtent = NewExtent;
+		CreateFrameImages();
+
+		GBufferGeneration->SetExtent(FrameExtent);
+		DeferredShading->SetExtent(FrameExtent);
+
+		GBufferGeneration->DeclareRenderTargets(*RenderTargets);
+		ShadowMapGeneration->DeclareRenderTargets(*RenderTargets);
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+		ShadowMapFiltering->DeclareRenderTargets(*RenderTargets);
+#endif
+		DeferredShading->DeclareRenderTargets(*RenderTargets);
+		RenderTargets->Commit();
+
+		GBufferGeneration->SetupRenderTargets();
+		ShadowMapGeneration->SetupRenderTargets();
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+		ShadowMapFiltering->SetupRenderTargets();
+#endif
+		DeferredShading->SetupRenderTargets();
+
+		// Order of passes and barriers between them stay the same, only images change.
+		GBufferGeneration->UpdateGraphImages(*FrameGraph);
+		ShadowMapGeneration->UpdateGraphImages(*FrameGraph);
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+		ShadowMapFiltering->UpdateGraphImages(*FrameGraph);
+#endif
+		DeferredShading->UpdateGraphImages(*FrameGraph);
+
+		// New swapchain may have more images, each needs its own semaphore and command buffers.
+		while (QueueSemaphores.size() < SwapchainBuffers.size())
+		{
+			VkSemaphoreCreateInfo CreationInfo
+			{
+				.sType = VkStructureType::VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0
+			};
+
+			VkSemaphore QueueSemaphore;
+			vkCreateSemaphore(Device, &CreationInfo, nullptr, &QueueSemaphore);
+			QueueSemaphores.push_back(QueueSemaphore);
+		}
+		AllocateCommandBuffers();
+
+		std::cout << "Frame resized to " << FrameExtent.width << "x" << FrameExtent.height << "." << std::endl;
+	};
+
+	// Main app loop.
+	const uint32_t FramesLimit = Options.IsBenchmark ? Benchmark->GetTotalFramesCount() : (Options.IsHeadless ? Options.FramesCount : UINT32_MAX);
+	uint32_t FrameIndex = 0;
+	bool WasDumpKeyPressed = false;
+	bool IsSwapchainOutdated = false;
+	bool WasVariantKeyPressed[3] = { false, false, false }; // F5 - shadows, F6 - shadow filtering, F7 - tonemapping.
+	std::vector<double> FrameTimesInMs;
+	const auto LoopStartTime = std::chrono::steady_clock::now();
+	while (FrameIndex < FramesLimit && (Options.IsHeadless || !glfwWindowShouldClose(PresentationWindow)) && TUTORIAL_VK_DEBUG_DEALLOCATIONS)
+	{
+		TUTORIAL_VK_PROFILE_ZONE("Frame");
+
+		const auto FrameStartTime = std::chrono::steady_clock::now();
+
+		if (!Options.IsHeadless)
+		{
+			glfwPollEvents();
+		}
+
+		// Swapchain follows size of window surface. Minimized window has no surface to render into, so rendering waits until it's restored.
+		if (!Options.IsHeadless)
+		{
+			VkExtent2D SurfaceExtent = QuerySurfaceExtent();
+			while ((!SurfaceExtent.width || !SurfaceExtent.height) && !glfwWindowShouldClose(PresentationWindow))
+			{
+				glfwWaitEvents();
+				SurfaceExtent = QuerySurfaceExtent();
+			}
+
+			if (glfwWindowShouldClose(PresentationWindow))
+				break;
+
+			if (IsSwapchainOutdated || SurfaceExtent.width != FrameExtent.width || SurfaceExtent.height != FrameExtent.height)
+			{
+				ResizeFrame(SurfaceExtent);
+				IsSwapchainOutdated = false;
+			}
+		}
+
+		const uint32_t FrameSlot = FrameIndex % TUTORIAL_VK_FRAMES_IN_FLIGHT;
+
+		// Wait only for frame which used this slot before, newer frames keep rendering.
+		if (Benchmark)
+		{
+			ObserveCompletedFrames();
+		}
+		{
+			TUTORIAL_VK_PROFILE_ZONE("Wait for frame slot");
+			GraphicsTimeline->Wait(FrameSlotsTimelineValues[FrameSlot]);
+		}
+		ReadPassTimings(FrameSlot);
+		SceneGeometry->ReleaseCompletedRanges(GraphicsTimeline->GetCompletedValue());
+		if (Benchmark)
+		{
+			ObserveCompletedFrames();
+
+			GBufferGeneration->SetCamera(Benchmark->EvaluateCameraView(FrameIndex), Benchmark->EvaluateCameraProjection(static_cast<float>(FrameExtent.width) / static_cast<float>(FrameExtent.height)));
+			ShadowMapGeneration->SetLightDirection(Benchmark->EvaluateLightDirection(FrameIndex));
+		}
+
+		if (FrameIndex == TUTORIAL_VK_FRAMES_IN_FLIGHT)
+		{
+			// First frame is finished now.
+			GBufferGeneration->ReportGBufferMemory();
+			GPUMemory.PrintSummary();
+		}
+
+		if (Options.IsHeadless)
+		{
+			// Offscreen image of slot is free, because previous frame of slot has finished.
+			ImageIndex = FrameSlot;
+		}
+		else
+		{
+			TUTORIAL_VK_PROFILE_ZONE("Acquire image");
+
+			// Surface changed before its new size could be observed. Acquire semaphore isn't signaled, so frame is skipped.
+			if (vkAcquireNextImageKHR(Device, Swapchain, UINT64_MAX, AcquireNextImageSemaphores[FrameSlot], VK_NULL_HANDLE, &ImageIndex) == VK_ERROR_OUT_OF_DATE_KHR)
+			{
+				IsSwapchainOutdated = true;
+				continue;
+			}
+		}
+		const size_t CommandBufferIndex = FrameSlot * SwapchainBuffers.size() + ImageIndex;
+
+		// Uniforms written while recording stay in partition of this slot, so cached command buffer can be resubmitted as is.
+		const SceneVersion CurrentSceneVersion
+		{
+			.GBufferGeneration = GBufferGeneration->GetContentVersion(),
+			.ShadowMapGeneration = ShadowMapGeneration->GetContentVersion(),
+			.DeferredShading = DeferredShading->GetContentVersion(),
+			.Actors = ActorsVersion
+		};
+
+		const auto RecordStartTime = std::chrono::steady_clock::now();
+		if (RecordedSceneVersions[CommandBufferIndex] != CurrentSceneVersion)
+		{
+			TUTORIAL_VK_PROFILE_ZONE("Record command buffer");
+
+			FrameUniforms->BeginFrame(FrameIndex);
+			FrameGraph->SetImage(SwapchainResource, SwapchainBuffers[ImageIndex]);
+
+			for (uint32_t Batch = 0; Batch < BatchesCount; Batch++)
+			{
+				VkCommandBuffer CommandBuffer = CommandBuffers[CommandBufferIndex * BatchesCount + Batch];
+
+				vkBeginCommandBuffer(CommandBuffer, &BeginInfo);
+				if (Batch == 0)
+				{
+					// First batch is always on graphics queue, every batch writing queries on other queue waits for it.
+					PassProfiler->RecordReset(CommandBuffer, FrameSlot);
+					PassStatistics->RecordReset(CommandBuffer, FrameSlot);
+				}
+
+				FrameGraph->Record(Batch, { .CommandBuffer = CommandBuffer, .FrameSlot = FrameSlot, .SwapchainImageIndex = ImageIndex });
+
+				vkEndCommandBuffer(CommandBuffer);
+			}
+			FrameUniforms->FlushFrame();
+
+			RecordedSceneVersions[CommandBufferIndex] = CurrentSceneVersion;
+		}
+		if (Benchmark)
+		{
+			Benchmark->AddSample(FrameIndex, "CPU record", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - RecordStartTime).count());
+		}
+
+		PresentationSemaphoreSubmitInfo.semaphore = AcquireNextImageSemaphores[FrameSlot];
+		QueueSemaphoreSubmitInfo.semaphore = QueueSemaphores[ImageIndex];
+		{
+			TUTORIAL_VK_PROFILE_ZONE("Submit");
+
+			// Batches are submitted in graph order, so value waited for on other queue is always its last submitted one.
+			// Without swapchain there is nothing to acquire nor present, so batches signal only their timeline values.
+			for (uint32_t Batch = 0; Batch < BatchesCount; Batch++)
+			{
+				const bool IsAsyncCompute = FrameGraph->GetBatchQueue(Batch) == AsyncComputeGraphQueue;
+				QueueTimeline& Timeline = IsAsyncCompute ? *AsyncComputeTimeline : *GraphicsTimeline;
+				const QueueTimeline& OtherTimeline = IsAsyncCompute ? *GraphicsTimeline : *AsyncComputeTimeline;
+
+				VkSemaphoreSubmitInfo WaitSemaphoresSubmitInfos[2];
+				uint32_t WaitSemaphoresCount = 0;
+				if (Batch == 0 && !Options.IsHeadless)
+				{
+					WaitSemaphoresSubmitInfos[WaitSemaphoresCount++] = PresentationSemaphoreSubmitInfo;
+				}
+				if (const VkPipelineStageFlags2 WaitStageMask = FrameGraph->GetBatchWaitStageMask(Batch))
+				{
+					WaitSemaphoresSubmitInfos[WaitSemaphoresCount++] = OtherTimeline.MakeSubmitInfo(OtherTimeline.GetLastSubmittedValue(), WaitStageMask);
+				}
+
+				VkSemaphoreSubmitInfo SignalSemaphoresSubmitInfos[2];
+				uint32_t SignalSemaphoresCount = 0;
+				SignalSemaphoresSubmitInfos[SignalSemaphoresCount++] = Timeline.MakeSubmitInfo(Timeline.AdvanceValue(), VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+				if (Batch == BatchesCount - 1 && !Options.IsHeadless)
+				{
+					SignalSemaphoresSubmitInfos[SignalSemaphoresCount++] = QueueSemaphoreSubmitInfo;
+				}
+
+				CmdBufSubmitInfo.commandBuffer = CommandBuffers[CommandBufferIndex * BatchesCount + Batch];
+
+				VkSubmitInfo2 SubmitInfo
+				{
+					.sType = VkStructureType::VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+					.pNext = nullptr,
+					.flags = 0,
+					.waitSemaphoreInfoCount = WaitSemaphoresCount,
+					.pWaitSemaphoreInfos = WaitSemaphoresSubmitInfos,
+					.commandBufferInfoCount = 1,
+					.pCommandBufferInfos = &CmdBufSubmitInfo,
+					.signalSemaphoreInfoCount = SignalSemaphoresCount,
+					.pSignalSemaphoreInfos = SignalSemaphoresSubmitInfos
+				};
+
+				vkQueueSubmit2(IsAsyncCompute ? AsyncComputeQueue : GraphicsQueue, 1, &SubmitInfo, VK_NULL_HANDLE);
+			}
+		}
+		FrameSlotsTimelineValues[FrameSlot] = GraphicsTimeline->GetLastSubmittedValue();
+		FrameSlotsSubmitTimes[FrameSlot] = std::chrono::steady_clock::now();
+		FrameSlotsFrameIndices[FrameSlot] = FrameIndex;
+		PassProfiler->MarkFrameSubmitted(FrameSlot);
+		PassStatistics->MarkFrameSubmitted(FrameSlot);
+
+		if (!Options.IsHeadless)
+		{
+			TUTORIAL_VK_PROFILE_ZONE("Present");
+
+			PresentInfo.pWaitSemaphores = &QueueSemaphores[ImageIndex];
+
+			// Swapchain is recreated at beginning of next frame, once this one has been handed over.
+			const VkResult PresentResult = vkQueuePresentKHR(GraphicsQueue, &PresentInfo);
+			IsSwapchainOutdated = PresentResult == VK_ERROR_OUT_OF_DATE_KHR || PresentResult == VK_SUBOPTIMAL_KHR;
+		}
+
+		// Dump GPU memory statistics on demand.
+		if (!Options.IsHeadless)
+		{
+			const bool IsDumpKeyPressed = glfwGetKey(PresentationWindow, GLFW_KEY_F9) == GLFW_PRESS;
+			if (IsDumpKeyPressed && !WasDumpKeyPressed)
+			{
+				GPUMemory.DumpJSON("gpu_memory.json");
+			}
+			WasDumpKeyPressed = IsDumpKeyPressed;
+		}
+
+		// Switch deferred shading variant on demand. Pipeline of new variant is created once, before next recording.
+		if (!Options.IsHeadless)
+		{
+			const int VariantKeys[3] = { GLFW_KEY_F5, GLFW_KEY_F6, GLFW_KEY_F7 };
+
+			DeferredShadingVariant Variant = DeferredShading->GetVariant();
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				const bool IsVariantKeyPressed = glfwGetKey(PresentationWindow, VariantKeys[i]) == GLFW_PRESS;
+				if (IsVariantKeyPressed && !WasVariantKeyPressed[i])
+				{
+					if (i == 0)
+						Variant.IsShadowEnabled = !Variant.IsShadowEnabled;
+					else if (i == 1)
+						Variant.ShadowFiltering = Variant.ShadowFiltering == VarianceShadowFiltering ? HardShadowFiltering : VarianceShadowFiltering;
+					else
+						Variant.Tonemapping = Variant.Tonemapping == ExposureTonemapping ? ReinhardTonemapping : ExposureTonemapping;
+				}
+				WasVariantKeyPressed[i] = IsVariantKeyPressed;
+			}
+
+			if (Variant != DeferredShading->GetVariant())
+			{
+				DeferredShading->SetVariant(Variant);
+				std::cout << "Deferred shading: shadows " << (Variant.IsShadowEnabled ? "on" : "off") << ", " << (Variant.ShadowFiltering == VarianceShadowFiltering ? "variance" : "hard") << " shadow filtering, "
+					<< (Variant.Tonemapping == ExposureTonemapping ? "exposure" : "Reinhard") << " tonemapping." << std::endl;
+			}
+		}
+
+		FrameTimesInMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - FrameStartTime).count());
+		if (Benchmark)
+		{
+			Benchmark->AddSample(FrameIndex, "Frame", FrameTimesInMs.back());
+		}
+
+		FrameIndex++;
 
 #ifdef TUTORIAL_VK_DEBUG_COMMAND_BUFFER_SUBMIT
 		break;
 #endif
 	}
 
+	// Frames still in flight when loop ended.
+	GraphicsTimeline->Wait(GraphicsTimeline->GetLastSubmittedValue());
+
+	if (Options.IsHeadless)
+	{
+		ReportFrameTimings(FrameTimesInMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - LoopStartTime).count());
+	}
+
+	for (uint32_t FrameSlot = 0; FrameSlot < TUTORIAL_VK_FRAMES_IN_FLIGHT; FrameSlot++)
+	{
+		ReadPassTimings(FrameSlot);
+	}
+	PassProfiler->PrintAverages();
+	PassStatistics->PrintAverages();
+
+	if (Benchmark)
+	{
+		ObserveCompletedFrames();
+
+		Benchmark->PrintSummary();
+		Benchmark->WriteJSON(Options.BenchmarkOutputPath + ".json");
+		Benchmark->WriteCSV(Options.BenchmarkOutputPath + ".csv");
+	}
+
 	// Clean up.
 	vkDeviceWaitIdle(Device);
 
 	GBufferGeneration->FreeGPUResources();
 	ShadowMapGeneration->FreeGPUResources();
+#ifdef TUTORIAL_VK_ASYNC_COMPUTE
+	ShadowMapFiltering->FreeGPUResources();
+#endif
 	DeferredShading->FreeGPUResources();
+	PipelineCache->FreeGPUResources();
+	Shaders->FreeGPUResources();
+	RenderTargets->FreeGPUResources();
+	FrameUniforms->FreeGPUResources();
+
+	SceneGeometry->FreeGPUResources();
 
-	for (auto& Actor : Actors)
+	Recorder->FreeGPUResources();
+	PassProfiler->FreeGPUResources();
+	PassStatistics->FreeGPUResources();
+	vkDestroyCommandPool(Device, CommandPool, nullptr);
+	vkDestroyCommandPool(Device, AsyncComputeCommandPool, nullptr);
+	GraphicsTimeline->FreeGPUResources();
+	AsyncComputeTimeline->FreeGPUResources();
+	for (const auto& QueueSemaphore : QueueSemaphores)
 	{
-		for (auto& VertexBuffer : Actor.VertexBuffers)
-		{
-			vkDestroyBuffer(Device, VertexBuffer, nullptr);
-		}
-		vkFreeMemory(Device, Actor.ActorBuffersGPUMemory, nullptr);
+		vkDestroySemaphore(Device, QueueSemaphore, nullptr);
 	}
+	for (const auto& AcquireNextImageSemaphore : AcquireNextImageSemaphores)
+	{
+		vkDestroySemaphore(Device, AcquireNextImageSemaphore, nullptr);
+	}
+	FreeFrameImages();
+	GPUMemory.ReportLeaks();
 
-	vkDestroyImageView(Device, DepthBufferView, nullptr);
-	vkDestroyImage(Device, DepthBuffer, nullptr);
-	vkFreeMemory(Device, DepthBufferMemory, nullptr);
-
-	vkDestroyCommandPool(Device, CommandPool, nullptr);
-	vkDestroyFence(Device, PresentationFence, nullptr);
-	vkDestroySemaphore(Device, QueueSemaphore, nullptr);
-	vkDestroySemaphore(Device, AcquireNextImageSemaphore, nullptr);
-	for (const auto& SwapchainBufferView : SwapchainBuffersViews)
+	if (!Options.IsHeadless)
 	{
-		vkDestroyImageView(Device, SwapchainBufferView, nullptr);
+		vkDestroySwapchainKHR(Device, Swapchain, nullptr);
+		vkDestroySurfaceKHR(Instance, Surface, nullptr);
 	}
-	vkDestroySwapchainKHR(Device, Swapchain, nullptr);
-	vkDestroySurfaceKHR(Instance, Surface, nullptr);
 	vkDestroyDevice(Device, nullptr);
 	vkDestroyInstance(Instance, nullptr);
 	glfwTerminate();
 
+	// Recording workers have been stopped already.
+	CPUTrace.WriteTrace(Options.TracePath);
+
 	// Exit from app.
 	return 0;
 }
\ No newline at end of file
@@ -19,6 +19,16 @@ layout (set = 0, binding = 4) uniform sampler2D VarianceShadowMapping;
 
 layout (location = 0) out vec4 PixelColor;
 
+// Shading variant, selected when pipeline is created. Branches on these constants are removed by driver.
+layout (constant_id = 0) const bool IsShadowEnabled = true;
+layout (constant_id = 1) const uint ShadowFilteringMode = 1; // 0 - hard shadow, 1 - Chebyshev upper bound of variance shadow map.
+layout (constant_id = 2) const uint TonemappingOperator = 0; // 0 - exposure, 1 - Reinhard.
+layout (constant_id = 3) const float Exposure = 0.7f;
+layout (constant_id = 4) const float Gamma = 2.2f;
+layout (constant_id = 5) const float MinVariance = 0.0004f;
+layout (constant_id = 6) const float LightBleedingReduction = 0.98f;
+layout (constant_id = 7) const float HardShadowBias = 0.005f; // Offset of pixel depth preventing shadow acne of hard shadows.
+
 float ComputeDiffuseLightFactor(const vec3 PixelNormal)
 {
 	return max(dot(PixelNormal, normalize(LightSpaceDirection)), 0);
@@ -63,10 +73,9 @@ float ComputeShadowFactor(const vec3 PixelPosition)
 	LightSpacePixelPos.xyz = LightSpacePixelPos.xyz * 0.5f + 0.5f;
 
 	const vec2 Moments = texture(VarianceShadowMapping, LightSpacePixelPos.xy).rg;
-	//if (LightSpacePixelPos.z > Moments.x )
-	//	return 1.0f;
-	//return 0.0;
-	return ChebyshevUpperBound(Moments, LightSpacePixelPos.z, 0.0004, 0.98);
+	if (ShadowFilteringMode == 0)
+		return LightSpacePixelPos.z - HardShadowBias > Moments.x ? 0.0f : 1.0f;
+	return ChebyshevUpperBound(Moments, LightSpacePixelPos.z, MinVariance, LightBleedingReduction);
 }
 
 
@@ -81,7 +90,7 @@ void main()
 	const float AmbientLightFactor = 0.05f;
 	const float DiffuseLightFactor = ComputeDiffuseLightFactor(PixelNormal) * 2.0f;
 	const float SpecularLightFactor = ComputeSpecularLightFactor(PixelNormal) * 2.0f;
-	const float ShadowFactor = ComputeShadowFactor(PixelPosition);
+	const float ShadowFactor = IsShadowEnabled ? ComputeShadowFactor(PixelPosition) : 1.0f;
 
 	const vec3 PixelMaterialColor = vec3(1.0f);
 
@@ -93,11 +102,11 @@ void main()
 
 
 	// Map HDR into SDR.
-	const float Gamma = 2.2;
-	const float Exposure = 0.7;
-  
-    // exposure tone mapping
-    vec3 Mapped = vec3(1.0) - exp(-FinallyLightedPixelColor * Exposure);
+    vec3 Mapped;
+    if (TonemappingOperator == 0)
+        Mapped = vec3(1.0) - exp(-FinallyLightedPixelColor * Exposure);
+    else
+        Mapped = FinallyLightedPixelColor * Exposure / (vec3(1.0) + FinallyLightedPixelColor * Exposure);
     // gamma correction 
     Mapped = pow(Mapped, vec3(1.0 / Gamma));
   
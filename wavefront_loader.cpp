@@ -1,4 +1,5 @@
 #include "wavefront_loader.hpp"
+#include "CPUProfiler.hpp"
 #include <fstream>
 #include <cassert>
 #include <sstream>
@@ -48,6 +49,8 @@ static void ProcessTrianglesIntoObject(
 	const bool ShouldFlipY
 )
 {
+	TUTORIAL_VK_PROFILE_ZONE("ProcessTrianglesIntoObject");
+
 	Object.Positions.reserve(TrianglesOutput.size() * 3);
 	Object.Normals.reserve(TrianglesOutput.size() * 3);
 	Object.TextureCoords.reserve(TrianglesOutput.size() * 3);	
@@ -83,6 +86,8 @@ namespace tnr::m3d::wavefront
 {
 	void tnrWavefrontLoader::LoadMaterials(const std::string& MTLFile)
 	{
+		TUTORIAL_VK_PROFILE_ZONE("tnrWavefrontLoader::LoadMaterials");
+
 		std::ifstream File(MTLFile);
 
 		std::string Cache;
@@ -170,6 +175,8 @@ namespace tnr::m3d::wavefront
 	}
 	void tnrWavefrontLoader::LoadObject(const std::string& ObjFile)
 	{
+		TUTORIAL_VK_PROFILE_ZONE("tnrWavefrontLoader::LoadObject");
+
 		auto WholeStartTime = std::chrono::system_clock::now();
 
 		const bool ShouldFlipY = this->Flags & tnrWavefrontOpenFlag::FLIP_POSITION_Y_AXIS;